@@ -0,0 +1,158 @@
+#ifndef BENCHMARKTOOLS_H
+#define BENCHMARKTOOLS_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <stdint.h>
+
+// Timing and synthetic trips shared by the benchmark and test applications
+
+
+// Returns the best time in seconds over a few repetitions. The computation returns a value,
+// which is kept so that the computation is not optimised away
+template< typename Computation >
+inline double bestTime( Computation computation, int numberOfRepetitions = 5 )
+{
+    double bestTime = 0;
+    volatile double sink = 0;
+    for ( int i = 0; i < numberOfRepetitions; ++i ) {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        sink = sink + computation();
+        std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+        if ( i == 0 || elapsed.count() < bestTime ) bestTime = elapsed.count();
+    }
+    return bestTime;
+}
+
+
+// The parameters of the synthetic trips. The rates of the events are given per thousand points
+struct SyntheticTripParameters {
+    // Constructor with uniform lengths between 200 and 1800 points, stops and sharp turns
+    SyntheticTripParameters():
+      seed( 1 ),
+      logNormalLengths( false ),
+      minimumLength( 200 ),
+      maximumLength( 1800 ),
+      stopRate( 10 ),
+      gapRate( 0 ),
+      turnRate( 10 ),
+      spikeRate( 0 )
+    {}
+
+    // The seed of the generator
+    uint32_t seed;
+
+    // The lengths are log-normal around 500 points, as in the Kaggle data, or uniform. Both are bounded
+    bool logNormalLengths;
+    int minimumLength;
+    int maximumLength;
+
+    // The car stands still for 5 to 35 seconds, with the GPS noise
+    int stopRate;
+
+    // The car jumps 50 to 250 metres ahead
+    int gapRate;
+
+    // The heading turns by 112 to 157 degrees
+    int turnRate;
+
+    // A point lies 40 to 80 metres off the track
+    int spikeRate;
+};
+
+
+// Returns the component of a unit vector in one of the 64 directions from 0 to 63, scaled by 1024
+inline long syntheticDirectionComponent( int direction, bool sine )
+{
+    static const long quarter[17] = { 1024, 1019, 1004, 980, 946, 903, 851, 792, 724, 650, 569, 483, 392, 297, 200, 100, 0 };
+    const int k = ( sine ? direction + 48 : direction ) % 64;
+    if ( k <= 16 ) return quarter[k];
+    if ( k <= 32 ) return -quarter[32 - k];
+    if ( k <= 48 ) return -quarter[k - 32];
+    return quarter[64 - k];
+}
+
+
+// Generates trips with the ids 1 to numberOfTrips. The car drives with a speed of up to 35 m/s and
+// a slowly changing heading; the coordinates have a resolution of 0.1 metre, as in the csv files.
+// The trips are the same on every platform: the numbers drawn from std::mt19937, whose sequence the
+// standard specifies, are mapped to the events in integer arithmetic, without the distributions of
+// the standard library or any floating point rounding
+inline std::vector< std::pair< int, std::vector< std::pair<float,float> > > >
+syntheticTrips( int numberOfTrips, const SyntheticTripParameters& parameters )
+{
+    // The bounds of ten equally likely length ranges of a log-normal distribution with median 500 and sigma 0.8
+    static const int logNormalBounds[11] = { 64, 179, 255, 329, 408, 500, 612, 761, 980, 1394, 3926 };
+
+    std::mt19937 generator( parameters.seed );
+    std::vector< std::pair< int, std::vector< std::pair<float,float> > > > tripData;
+    tripData.reserve( numberOfTrips );
+    for ( int tripId = 1; tripId <= numberOfTrips; ++tripId ) {
+        int numberOfPoints = 0;
+        if ( parameters.logNormalLengths ) {
+            const int range = generator() % 10;
+            numberOfPoints = logNormalBounds[range] + generator() % ( logNormalBounds[range + 1] - logNormalBounds[range] );
+        }
+        else {
+            numberOfPoints = parameters.minimumLength + generator() % ( parameters.maximumLength - parameters.minimumLength + 1 );
+        }
+        numberOfPoints = std::max( parameters.minimumLength, std::min( parameters.maximumLength, numberOfPoints ) );
+
+        // The position in decimetres, the speed in decimetres per second
+        long x = 0, y = 0, speed = 0;
+        int heading = generator() % 64;
+        int stopDuration = 0;
+        std::vector< std::pair<float,float> > trip;
+        trip.reserve( numberOfPoints );
+        for ( int i = 0; i < numberOfPoints; ++i ) {
+            if ( stopDuration > 0 ) {
+                --stopDuration;
+                const long noiseX = static_cast<long>( generator() % 7 ) - 3;
+                const long noiseY = static_cast<long>( generator() % 7 ) - 3;
+                trip.push_back( std::make_pair( ( x + noiseX ) / 10.0f, ( y + noiseY ) / 10.0f ) );
+                continue;
+            }
+
+            int event = generator() % 1000;
+            bool spike = false;
+            if ( ( event -= parameters.stopRate ) < 0 ) {
+                stopDuration = 5 + generator() % 31;
+                speed = 0;
+            }
+            else if ( ( event -= parameters.gapRate ) < 0 ) {
+                const long jump = 500 + generator() % 2001;
+                x += jump * syntheticDirectionComponent( heading, false ) / 1024;
+                y += jump * syntheticDirectionComponent( heading, true ) / 1024;
+            }
+            else if ( ( event -= parameters.turnRate ) < 0 ) {
+                const int side = generator() % 2 == 0 ? -1 : 1;
+                heading = ( heading + 64 + side * static_cast<int>( 20 + generator() % 9 ) ) % 64;
+            }
+            else if ( ( event -= parameters.spikeRate ) < 0 ) {
+                spike = true;
+            }
+
+            // Accelerate by -0.9 to 1.1 m/s and drift by one direction now and then
+            speed = std::max( 0L, std::min( 350L, speed + static_cast<long>( generator() % 21 ) - 9 ) );
+            const int drift = generator() % 20;
+            if ( drift == 0 ) heading = ( heading + 63 ) % 64;
+            else if ( drift == 1 ) heading = ( heading + 1 ) % 64;
+            x += speed * syntheticDirectionComponent( heading, false ) / 1024;
+            y += speed * syntheticDirectionComponent( heading, true ) / 1024;
+            if ( spike ) {
+                const long offsetX = 400 + generator() % 401;
+                const long offsetY = 400 + generator() % 401;
+                trip.push_back( std::make_pair( ( x + offsetX ) / 10.0f, ( y - offsetY ) / 10.0f ) );
+                continue;
+            }
+            trip.push_back( std::make_pair( x / 10.0f, y / 10.0f ) );
+        }
+        tripData.push_back( std::make_pair( tripId, trip ) );
+    }
+    return tripData;
+}
+
+#endif
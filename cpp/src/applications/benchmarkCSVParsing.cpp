@@ -0,0 +1,94 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <exception>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#include "DriverTripDataIO.h"
+#include "BenchmarkTools.h"
+
+// The malformed rows written at the end of the last trip, which both parsers must skip
+static const char* malformedRows[] = { "", "12.5", "12.5;3.0", "x,3.0", "12.5,", " , ", "1.2.3,4", "1,2.3-4", "1,2 3", "1,2;" };
+static const size_t numberOfMalformedRows = sizeof(malformedRows) / sizeof(malformedRows[0]);
+
+// Writes synthetic trip csv files in the Kaggle format, with a few malformed rows in the last trip.
+// Returns the total number of bytes and valid rows
+static std::pair< size_t, size_t > writeSyntheticDriver( const std::string& directory, int driverId, int numberOfTrips )
+{
+    std::ostringstream osDriverDirectory;
+    osDriverDirectory << directory << "/" << driverId;
+    mkdir( directory.c_str(), 0755 );
+    mkdir( osDriverDirectory.str().c_str(), 0755 );
+    
+    SyntheticTripParameters parameters;
+    parameters.seed = driverId;
+    const std::vector< std::pair< int, std::vector< std::pair<float,float> > > > trips = syntheticTrips( numberOfTrips, parameters );
+
+    size_t numberOfBytes = 0;
+    size_t numberOfRows = 0;
+    for ( std::vector< std::pair< int, std::vector< std::pair<float,float> > > >::const_iterator iTrip = trips.begin();
+          iTrip != trips.end(); ++iTrip ) {
+        std::ostringstream osFileName;
+        osFileName << osDriverDirectory.str() << "/" << iTrip->first << ".csv";
+        std::ofstream outputFile( osFileName.str() );
+        outputFile << "x,y" << std::endl;
+        outputFile << std::fixed << std::setprecision(1);
+        
+        const std::vector< std::pair<float,float> >& points = iTrip->second;
+        for ( size_t i = 0; i < points.size(); ++i )
+            outputFile << points[i].first << "," << points[i].second << "\n";
+        if ( iTrip->first == numberOfTrips )
+            for ( size_t i = 0; i < numberOfMalformedRows; ++i ) outputFile << malformedRows[i] << "\n";
+        numberOfRows += points.size();
+        numberOfBytes += static_cast<size_t>( outputFile.tellp() );
+    }
+    return std::make_pair( numberOfBytes, numberOfRows );
+}
+
+
+// Times the parsing of a driver directory. Returns the best time in seconds over a few repetitions
+static double timeParsing( const std::string& directory, DriverTripDataIO::CSVParsing parsing, DriverTripDataIO& dataIO )
+{
+    return bestTime( [&]() {
+            dataIO.readTripDataFromCSVFiles( directory, parsing );
+            return dataIO.rawData().size(); } );
+}
+
+
+int main( int, char** ) {
+    try {
+        const std::string directory = "benchmark_csv";
+        const int driverId = 1;
+        const int numberOfTrips = 200;
+        
+        std::cout << "Writing " << numberOfTrips << " synthetic trips in " << directory << std::endl;
+        std::pair< size_t, size_t > size = writeSyntheticDriver( directory, driverId, numberOfTrips );
+        const double megaBytes = size.first / ( 1024.0 * 1024.0 );
+        
+        DriverTripDataIO streamIO( driverId );
+        const double streamTime = timeParsing( directory, DriverTripDataIO::StreamParsing, streamIO );
+        DriverTripDataIO fastIO( driverId );
+        const double fastTime = timeParsing( directory, DriverTripDataIO::FastParsing, fastIO );
+        
+        if ( streamIO.rawData() != fastIO.rawData() )
+            throw std::runtime_error( "The fast parser does not reproduce the stream parser output" );
+        if ( streamIO.numberOfSkippedRows() != numberOfMalformedRows || fastIO.numberOfSkippedRows() != numberOfMalformedRows )
+            throw std::runtime_error( "The parsers do not skip exactly the malformed rows" );
+        
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "Stream parsing : " << megaBytes / streamTime << " MB/s, " << size.second / streamTime << " rows/s" << std::endl;
+        std::cout << "Fast parsing   : " << megaBytes / fastTime << " MB/s, " << size.second / fastTime << " rows/s" << std::endl;
+        std::cout << "Speedup        : " << streamTime / fastTime << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "Unknown error" << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <valarray>
+#include <complex>
+#include <cmath>
+#include <exception>
+#include <stdexcept>
+
+#include "DFTPlan.h"
+#include "BenchmarkTools.h"
+
+// Compares the throughput of the DFT plans with the recursive radix-2 FFT that vfft used before,
+// for the window sizes of the rolling transforms and a few powers of two. The recursive FFT only
+// handles the powers of two correctly; the other sizes are timed all the same.
+
+
+static const double PI = std::atan( 1.0 ) * 4;
+
+// The recursive FFT, allocating the even and odd halves at every level
+static void recursiveFFT( std::valarray< std::complex<double> >& x )
+{
+    const size_t N = x.size();
+    if ( N <=1 ) return;
+
+    std::valarray< std::complex<double> > even = x[std::slice(0, N/2, 2)];
+    std::valarray< std::complex<double> >  odd = x[std::slice(1, N/2, 2)];
+
+    recursiveFFT( even );
+    recursiveFFT( odd );
+
+    for (size_t k = 0; k < N/2; ++k) {
+        std::complex<double> t = std::polar(1.0, -2 * PI * k / N) * odd[k];
+        x[k    ] = even[k] + t;
+        x[k+N/2] = even[k] - t;
+    }
+}
+
+
+// The magnitudes of the bins with the recursive FFT, as vfft computed them
+static std::valarray< double > recursiveMagnitudes( const std::vector<double>& data )
+{
+    std::valarray< std::complex<double> > x( data.size() );
+    for ( size_t i = 0; i < data.size(); ++i ) x[i] = data[i];
+    recursiveFFT( x );
+
+    std::valarray<double> transformed( data.size() / 2 + 1 );
+    for (size_t i = 0; i < transformed.size(); ++i ) transformed[i] = std::abs( x[i] );
+    return transformed;
+}
+
+
+int main( int, char** ) {
+    try {
+        const size_t numberOfValues = 200000;
+        std::mt19937 generator( 42 );
+        std::uniform_real_distribution<double> uniform( 0.0, 30.0 );
+        std::vector<double> values( numberOfValues );
+        for ( size_t i = 0; i < numberOfValues; ++i ) values[i] = uniform( generator );
+
+        const size_t sizes[] = { 8, 11, 16, 20, 32, 64, 256 };
+        std::cout << std::fixed << std::setprecision(2);
+        for ( size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s ) {
+            const size_t size = sizes[s];
+            const size_t numberOfWindows = numberOfValues - size + 1;
+
+            // Every window of the values, as the rolling transforms slide over a segment
+            const double recursiveTime = bestTime( [&]() {
+                    double sum = 0;
+                    std::vector<double> sample;
+                    for ( size_t i = 0; i < numberOfWindows; ++i ) {
+                        sample.assign( values.begin() + i, values.begin() + i + size );
+                        sum += recursiveMagnitudes( sample )[1];
+                    }
+                    return sum; } );
+
+            DFTPlan plan( size );
+            std::vector<double> bins( plan.numberOfBins() );
+            const double planTime = bestTime( [&]() {
+                    double sum = 0;
+                    for ( size_t i = 0; i < numberOfWindows; ++i ) {
+                        plan.magnitudes( values.data() + i, bins.data() );
+                        sum += bins[1];
+                    }
+                    return sum; } );
+
+            std::cout << "Size " << std::setw(4) << size << " : recursive " << std::setw(8) << numberOfWindows / recursiveTime * 1e-6
+                      << " transforms/us, plan " << std::setw(8) << numberOfWindows / planTime * 1e-6
+                      << " transforms/us, speedup " << recursiveTime / planTime << std::endl;
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "Unknown error" << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cstdlib>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "DriverTripDataIO.h"
+#include "DriverTripDataMap.h"
+#include "DriverFileBatchLoader.h"
+#include "DirectoryListing.h"
+
+// Compares the ways of loading the binary driver files: one ifstream per file, one mmap per file,
+// and batches of files through io_uring. Each method is timed on a cold and on a warm page cache.
+
+
+// Drops the driver files from the page cache. Returns false if this is not supported
+static bool dropFromPageCache( const std::string& driverDirectoryName, const std::vector<int>& driverIds )
+{
+#ifdef POSIX_FADV_DONTNEED
+    for ( size_t i = 0; i < driverIds.size(); ++i ) {
+        std::ostringstream osFileName;
+        osFileName << driverDirectoryName << "/" << driverIds[i] << ".data";
+        int fd = open( osFileName.str().c_str(), O_RDONLY );
+        if ( fd < 0 ) continue;
+        fdatasync( fd );
+        posix_fadvise( fd, 0, 0, POSIX_FADV_DONTNEED );
+        close( fd );
+    }
+    return true;
+#else
+    (void) driverDirectoryName;
+    (void) driverIds;
+    return false;
+#endif
+}
+
+
+// The loading methods. Each returns the number of points loaded
+static size_t loadWithStreams( const std::string& driverDirectoryName, const std::vector<int>& driverIds )
+{
+    size_t numberOfPoints = 0;
+    for ( size_t i = 0; i < driverIds.size(); ++i ) {
+        DriverTripDataIO dataIO( driverIds[i] );
+        dataIO.readDataFromBinaryFile( driverDirectoryName );
+        for ( size_t j = 0; j < dataIO.rawData().size(); ++j ) numberOfPoints += dataIO.rawData()[j].second.size();
+    }
+    return numberOfPoints;
+}
+
+
+static size_t loadWithMapping( const std::string& driverDirectoryName, const std::vector<int>& driverIds )
+{
+    size_t numberOfPoints = 0;
+    for ( size_t i = 0; i < driverIds.size(); ++i ) {
+        DriverTripDataMap dataMap( driverIds[i] );
+        dataMap.mapBinaryFile( driverDirectoryName );
+        for ( size_t j = 0; j < dataMap.numberOfTrips(); ++j ) numberOfPoints += dataMap.trip( j ).size();
+    }
+    return numberOfPoints;
+}
+
+
+static size_t loadWithIOUring( const std::string& driverDirectoryName, const std::vector<int>& driverIds )
+{
+    DriverFileBatchLoader loader( DriverFileBatchLoader::IOUring, 32 );
+    std::vector< DriverFileBatchLoader::LoadedDriver > drivers = loader.load( driverDirectoryName, driverIds );
+    size_t numberOfPoints = 0;
+    for ( size_t i = 0; i < drivers.size(); ++i ) {
+        if ( drivers[i].error ) std::rethrow_exception( drivers[i].error );
+        const DriverTripDataMap& dataMap = *drivers[i].data;
+        for ( size_t j = 0; j < dataMap.numberOfTrips(); ++j ) numberOfPoints += dataMap.trip( j ).size();
+    }
+    return numberOfPoints;
+}
+
+
+// Usage: benchmarkDriverLoading [directory] [numberOfRepetitions]
+int main( int argc, char** argv ) {
+    try {
+        std::string driverDirectoryName = "drivers_compressed_data";
+        int numberOfRepetitions = 3;
+        if ( argc > 1 ) driverDirectoryName = argv[1];
+        if ( argc > 2 ) numberOfRepetitions = std::max( 1, std::atoi( argv[2] ) );
+        
+        DirectoryListing dirList( driverDirectoryName );
+        dirList.setExtensionFilter( ".data" ).setOrdering( DirectoryListing::NumericOrdering );
+        std::list<std::string> driverFiles = dirList.directoryContent();
+        std::vector<int> driverIds;
+        for ( std::list<std::string>::const_iterator iDriverFile = driverFiles.begin();
+             iDriverFile != driverFiles.end(); ++iDriverFile )
+            driverIds.push_back( std::atoi( iDriverFile->c_str() ) );
+        if ( driverIds.empty() )
+            throw std::runtime_error( "No driver files found in " + driverDirectoryName );
+        
+        {
+            DriverFileBatchLoader loader;
+            std::cout << "io_uring " << ( loader.backend() == DriverFileBatchLoader::IOUring ? "available" : "not available, the batch loader maps the files" ) << std::endl;
+        }
+        const bool coldCacheSupported = dropFromPageCache( driverDirectoryName, driverIds );
+        if ( ! coldCacheSupported )
+            std::cout << "Dropping files from the page cache is not supported; the cold cache times are warm" << std::endl;
+        
+        const char* methodNames[] = { "ifstream", "mmap", "io_uring" };
+        size_t (*methods[])( const std::string&, const std::vector<int>& ) = { loadWithStreams, loadWithMapping, loadWithIOUring };
+        
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "Drivers : " << driverIds.size() << std::endl;
+        for ( int cold = 1; cold >= 0; --cold ) {
+            for ( int method = 0; method < 3; ++method ) {
+                // Keep the best of the repetitions
+                double bestTime = 0;
+                size_t numberOfPoints = 0;
+                for ( int i = 0; i < numberOfRepetitions; ++i ) {
+                    if ( cold ) dropFromPageCache( driverDirectoryName, driverIds );
+                    else methods[method]( driverDirectoryName, driverIds );
+                    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+                    numberOfPoints = methods[method]( driverDirectoryName, driverIds );
+                    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+                    if ( i == 0 || elapsed.count() < bestTime ) bestTime = elapsed.count();
+                }
+                std::cout << ( cold ? "Cold cache " : "Warm cache " ) << std::setw(8) << methodNames[method] << " : "
+                          << std::setw(8) << driverIds.size() / bestTime << " drivers/s, "
+                          << std::setw(8) << numberOfPoints * 8 / bestTime / 1e6 << " MB/s of points" << std::endl;
+            }
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "Unknown error" << std::endl;
+        return -1;
+    }
+    return 0;
+}
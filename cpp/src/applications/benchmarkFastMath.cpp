@@ -0,0 +1,133 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <tuple>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#include "DriverDataProcessing.h"
+#include "Fleet.h"
+#include "TripMetrics.h"
+#include "FastMath.h"
+#include "BenchmarkTools.h"
+
+// Reports the accuracy and the speed of the fast math mode against the exact one, on the trip data in the given
+// directory: the largest difference of each trip metric, the throughput of the trip metrics in both modes, and
+// the differences of the final trip scores. The scores of a second exact run give the noise floor of the scoring.
+// The kinematics are not cached, so that every trip metric is computed from the segments.
+
+
+// The trip scores in a mode, in the order of the drivers and the trips
+static std::vector< std::tuple< long, long, double > >
+scores( const DriverDataProcessing& dataProcessing, int numberOfThreads, FastMath::Mode mode )
+{
+    FastMath::setMode( mode );
+    std::vector< std::tuple< long, long, double > > output;
+    dataProcessing.scoreTrips( output, numberOfThreads );
+    FastMath::setMode( FastMath::Exact );
+    std::sort( output.begin(), output.end() );
+    return output;
+}
+
+
+// Reports the differences between two sets of trip scores
+static void reportScoreDifferences( const char* name,
+                                    const std::vector< std::tuple< long, long, double > >& reference,
+                                    const std::vector< std::tuple< long, long, double > >& output )
+{
+    if ( reference.size() != output.size() )
+        throw std::runtime_error( "benchmarkFastMath : the runs scored different numbers of trips" );
+    double largestDifference = 0, totalDifference = 0;
+    size_t numberOfDifferences = 0;
+    for ( size_t i = 0; i < reference.size(); ++i ) {
+        if ( std::get<0>( reference[i] ) != std::get<0>( output[i] ) || std::get<1>( reference[i] ) != std::get<1>( output[i] ) )
+            throw std::runtime_error( "benchmarkFastMath : the runs scored different trips" );
+        const double difference = std::fabs( std::get<2>( reference[i] ) - std::get<2>( output[i] ) );
+        largestDifference = std::max( largestDifference, difference );
+        totalDifference += difference;
+        if ( difference > 1e-6 ) ++numberOfDifferences;
+    }
+    std::cout << std::scientific << std::setprecision(2) << "  " << name << " : largest difference " << largestDifference
+              << ", mean difference " << totalDifference / std::max< size_t >( 1, reference.size() ) << ", "
+              << numberOfDifferences << " of " << reference.size() << " scores differ by more than 1e-6" << std::endl;
+}
+
+
+// Usage: benchmarkFastMath directory [numberOfThreads]
+int main( int argc, char** argv ) {
+    try {
+        if ( argc < 2 ) {
+            std::cerr << "Usage: " << argv[0] << " directory [numberOfThreads]" << std::endl;
+            return -1;
+        }
+        const int numberOfThreads = argc > 2 ? std::max( 1, std::atoi( argv[2] ) ) : 4;
+        Trip::setKinematicsCaching( false );
+        const DriverDataProcessing dataProcessing( argv[1] );
+        const Fleet fleet = dataProcessing.loadAllData( numberOfThreads );
+
+        std::vector< const Trip* > trips;
+        for ( size_t i = 0; i < fleet.size(); ++i ) {
+            const std::vector< Trip >& driverTrips = fleet[i].trips();
+            for ( std::vector< Trip >::const_iterator iTrip = driverTrips.begin(); iTrip != driverTrips.end(); ++iTrip ) {
+                iTrip->prepare();
+                trips.push_back( &*iTrip );
+            }
+        }
+
+        // The largest difference of each metric. The undefined metrics must be the same in both modes
+        const std::vector< std::string >& descriptions = TripMetrics::descriptions();
+        std::vector< double > largestDifferences( descriptions.size(), 0 );
+        std::vector< double > exactValues, fastValues;
+        for ( size_t i = 0; i < trips.size(); ++i ) {
+            FastMath::setMode( FastMath::Exact );
+            trips[i]->metrics( exactValues );
+            FastMath::setMode( FastMath::Fast );
+            trips[i]->metrics( fastValues );
+            for ( size_t j = 0; j < descriptions.size(); ++j ) {
+                if ( std::isnan( exactValues[j] ) != std::isnan( fastValues[j] ) )
+                    throw std::runtime_error( "benchmarkFastMath : the metric " + descriptions[j] + " is undefined in one mode only" );
+                if ( ! std::isnan( exactValues[j] ) )
+                    largestDifferences[j] = std::max( largestDifferences[j], std::fabs( exactValues[j] - fastValues[j] ) );
+            }
+        }
+        FastMath::setMode( FastMath::Exact );
+        std::cout << "Largest difference of the trip metrics over " << trips.size() << " trips:" << std::endl;
+        std::cout << std::scientific << std::setprecision(2);
+        for ( size_t j = 0; j < descriptions.size(); ++j )
+            std::cout << "  " << std::setw(24) << std::left << descriptions[j] << std::right << " " << largestDifferences[j] << std::endl;
+
+        // The throughput of the trip metrics in both modes
+        std::cout << std::fixed << std::setprecision(0) << "Trip metrics:";
+        for ( int mode = FastMath::Exact; mode <= FastMath::Fast; ++mode ) {
+            FastMath::setMode( static_cast< FastMath::Mode >( mode ) );
+            const double time = bestTime( [&]() {
+                    double sum = 0;
+                    for ( size_t i = 0; i < trips.size(); ++i ) {
+                        trips[i]->metrics( fastValues );
+                        sum += fastValues[3];
+                    }
+                    return sum; } );
+            std::cout << " " << FastMath::name( static_cast< FastMath::Mode >( mode ) ) << " mode " << trips.size() / time << " trips/s";
+        }
+        FastMath::setMode( FastMath::Exact );
+        std::cout << std::endl;
+
+        // The final scores
+        const std::vector< std::tuple< long, long, double > > exactScores = scores( dataProcessing, numberOfThreads, FastMath::Exact );
+        std::cout << "Trip scores:" << std::endl;
+        reportScoreDifferences( "exact mode again", exactScores, scores( dataProcessing, numberOfThreads, FastMath::Exact ) );
+        reportScoreDifferences( "fast mode", exactScores, scores( dataProcessing, numberOfThreads, FastMath::Fast ) );
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "Unknown error" << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#include "DriverDataProcessing.h"
+#include "Driver.h"
+#include "TripMetrics.h"
+#include "TripKinematics.h"
+#include "QuantileSelection.h"
+#include "BenchmarkTools.h"
+
+// Compares the trip metrics of the fused feature extractor against the separate calculations the metrics
+// were made of: the number of points, the kinematics, the quantiles of each series, the turns and the rolling
+// spectrum, one after the other. The trips come from the trip data in the given directory, or are synthetic.
+// The segments are generated beforehand and the kinematics are not cached, so that both calculations start
+// from the segments. The metrics must be identical, bit for bit.
+
+
+// Sets a metric to the logarithm of a value, if the value is positive
+static void setLogarithm( double value, double& metric )
+{
+    if ( value > 0 ) metric = std::log10( value );
+}
+
+
+// The metrics of a trip with the separate calculations, as Trip::metrics made them before the fused extractor
+static void separateMetrics( const Trip& trip, std::vector<double>& metricsValues )
+{
+    metricsValues.assign( TripMetrics::descriptions().size(), NAN );
+    size_t j = 0;
+    if ( trip.numberOfSegments() == 0 ) {
+        metricsValues[j++] = 1;
+        return;
+    }
+    metricsValues[j++] = 0;
+    long numberOfValidPoints = 0;
+    for ( std::vector< Segment >::const_iterator iSegment = trip.segments().begin(); iSegment != trip.segments().end(); ++iSegment )
+        numberOfValidPoints += iSegment->numberOfDataPoints();
+    if ( numberOfValidPoints < TripMetrics::minimumNumberOfPoints() ) {
+        metricsValues[j++] = 1;
+        return;
+    }
+    metricsValues[j++] = 0;
+
+    const std::shared_ptr< const TripKinematics > kinematics = trip.kinematics();
+    metricsValues[j++] = std::log10( 1 + trip.travelDuration() );
+    const double tripLength = trip.travelLength();
+    metricsValues[j++] = std::log10( 1 + tripLength );
+    metricsValues[j++] = trip.distanceOfEndPoint() / tripLength;
+
+    std::vector<double> values( kinematics->speedValues() );
+    QuantileValues percentiles;
+    percentiles.fill( NAN );
+    selectQuantiles( values.data(), values.data() + values.size(), percentiles );
+    for ( size_t i = 1; i <= 4; ++i ) metricsValues[j++] = std::log10( 0.1 + percentiles[i] );
+
+    values.assign( kinematics->accelerationValues().begin(), kinematics->accelerationValues().end() );
+    selectQuantiles( values.data(), values.data() + values.size(), percentiles );
+    setLogarithm( -percentiles[0], metricsValues[j++] );
+    setLogarithm( -percentiles[1], metricsValues[j++] );
+    setLogarithm( percentiles[3], metricsValues[j++] );
+    setLogarithm( percentiles[4], metricsValues[j++] );
+
+    values.assign( kinematics->directionValues().begin(), kinematics->directionValues().end() );
+    selectQuantiles( values.data(), values.data() + values.size(), percentiles );
+    setLogarithm( -percentiles[0], metricsValues[j++] );
+    setLogarithm( percentiles[4], metricsValues[j++] );
+
+    values.assign( kinematics->speedXaccelerationValues().begin(), kinematics->speedXaccelerationValues().end() );
+    selectQuantiles( values.data(), values.data() + values.size(), percentiles );
+    setLogarithm( -percentiles[0], metricsValues[j++] );
+    setLogarithm( -percentiles[1], metricsValues[j++] );
+    setLogarithm( percentiles[3], metricsValues[j++] );
+    setLogarithm( percentiles[4], metricsValues[j++] );
+
+    metricsValues[j++] = std::log10( 0.001 + trip.totalDirectionChange() );
+    const std::valarray< double > fft = trip.rollingFFT( 11 );
+    if ( fft.size() > 0 )
+        for ( size_t i = 0; i < 5; ++i ) metricsValues[j + i] = fft[i];
+}
+
+
+// Usage: benchmarkFeatureExtraction [directory] [numberOfThreads]
+int main( int argc, char** argv ) {
+    try {
+        Trip::setKinematicsCaching( false );
+        Fleet fleet;
+        if ( argc > 1 ) {
+            const int numberOfThreads = argc > 2 ? std::max( 1, std::atoi( argv[2] ) ) : 4;
+            fleet = DriverDataProcessing( argv[1] ).loadAllData( numberOfThreads );
+        }
+        else {
+            Driver driver( 1 );
+            SyntheticTripParameters parameters;
+            parameters.seed = 5;
+            parameters.logNormalLengths = true;
+            parameters.minimumLength = 10;
+            parameters.maximumLength = 8000;
+            driver.loadTripData( syntheticTrips( 4000, parameters ) );
+            fleet.add( std::move( driver ) );
+        }
+
+        std::vector< const Trip* > trips;
+        for ( size_t i = 0; i < fleet.size(); ++i ) {
+            const std::vector< Trip >& driverTrips = fleet[i].trips();
+            for ( std::vector< Trip >::const_iterator iTrip = driverTrips.begin(); iTrip != driverTrips.end(); ++iTrip ) {
+                iTrip->prepare();
+                trips.push_back( &*iTrip );
+            }
+        }
+
+        // The metrics must be identical
+        std::vector<double> expected, result;
+        for ( size_t i = 0; i < trips.size(); ++i ) {
+            separateMetrics( *trips[i], expected );
+            trips[i]->metrics( result );
+            if ( expected.size() != result.size() ||
+                 std::memcmp( expected.data(), result.data(), expected.size() * sizeof(double) ) != 0 )
+                throw std::runtime_error( "The fused metrics differ from the separate calculations" );
+        }
+
+        const double separateTime = bestTime( [&]() {
+                double sum = 0;
+                for ( size_t i = 0; i < trips.size(); ++i ) {
+                    separateMetrics( *trips[i], result );
+                    sum += result[3];
+                }
+                return sum; } );
+        const double fusedTime = bestTime( [&]() {
+                double sum = 0;
+                for ( size_t i = 0; i < trips.size(); ++i ) {
+                    trips[i]->metrics( result );
+                    sum += result[3];
+                }
+                return sum; } );
+
+        std::cout << std::fixed << std::setprecision(0);
+        std::cout << trips.size() << " trips: separate calculations " << trips.size() / separateTime << " trips/s, fused extractor "
+                  << trips.size() / fusedTime << " trips/s, speedup " << std::setprecision(2) << separateTime / fusedTime
+                  << ", all metrics identical" << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "Unknown error" << std::endl;
+        return -1;
+    }
+    return 0;
+}
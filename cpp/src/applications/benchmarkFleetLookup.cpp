@@ -0,0 +1,119 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <stdexcept>
+
+#include "DriverDataProcessing.h"
+
+// Times the driver and trip lookups of the explorer commands with the full fleet loaded:
+// the linear scan over the drivers followed by a search among their trips, against the indexed fleet.
+// Every command is timed on its own and the median and 99th percentile latencies are reported.
+
+
+// A command of the explorer, addressing a trip of a driver
+struct LookupCommand {
+    int driverId;
+    int tripId;
+};
+
+
+// The lookup of the explorer before the fleet was indexed
+static const Trip* scanForTrip( const std::vector< const Driver* >& drivers, int driverId, int tripId )
+{
+    std::vector< const Driver* >::const_iterator iDriver = drivers.begin();
+    while ( iDriver != drivers.end() ) {
+        if ( (*iDriver)->id() == driverId ) break;
+        ++iDriver;
+    }
+    if ( iDriver == drivers.end() ) return 0;
+    const std::vector< Trip >& trips = (*iDriver)->trips();
+    std::vector< Trip >::const_iterator iTrip = std::find( trips.begin(), trips.end(), tripId );
+    if ( iTrip == trips.end() ) return 0;
+    return &( *iTrip );
+}
+
+
+// Returns the latencies of the commands in nanoseconds, sorted
+template< typename Lookup >
+static std::vector< double > commandLatencies( const std::vector< LookupCommand >& commands, Lookup lookup )
+{
+    std::vector< double > latencies;
+    latencies.reserve( commands.size() );
+    size_t numberOfTripsFound = 0;
+    for ( std::vector< LookupCommand >::const_iterator iCommand = commands.begin(); iCommand != commands.end(); ++iCommand ) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        const Trip* trip = lookup( iCommand->driverId, iCommand->tripId );
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        if ( trip != 0 && trip->id() == iCommand->tripId ) ++numberOfTripsFound;
+        latencies.push_back( std::chrono::duration<double, std::nano>( end - start ).count() );
+    }
+    if ( numberOfTripsFound != commands.size() ) throw std::runtime_error( "Not all trips were found" );
+    std::sort( latencies.begin(), latencies.end() );
+    return latencies;
+}
+
+
+// Returns the given quantile of sorted values
+static double quantile( const std::vector< double >& sortedValues, double q )
+{
+    return sortedValues[ static_cast<size_t>( q * ( sortedValues.size() - 1 ) ) ];
+}
+
+
+// Usage: benchmarkFleetLookup [directory] [numberOfThreads] [numberOfCommands]
+int main( int argc, char** argv ) {
+    try {
+        std::string driverDirectoryName = "drivers_compressed_data";
+        int numberOfThreads = 4;
+        int numberOfCommands = 100000;
+        if ( argc > 1 ) driverDirectoryName = argv[1];
+        if ( argc > 2 ) numberOfThreads = std::max( 1, std::atoi( argv[2] ) );
+        if ( argc > 3 ) numberOfCommands = std::max( 1, std::atoi( argv[3] ) );
+
+        const Fleet fleet = DriverDataProcessing( driverDirectoryName ).loadAllData( numberOfThreads );
+        if ( fleet.numberOfTrips() == 0 ) throw std::runtime_error( "No trips were loaded" );
+
+        // The drivers as the explorer used to hold them
+        std::vector< const Driver* > drivers;
+        drivers.reserve( fleet.size() );
+        for ( size_t i = 0; i < fleet.size(); ++i ) drivers.push_back( &fleet[i] );
+
+        // Random commands on the trips of random drivers
+        std::mt19937 generator( 42 );
+        std::vector< LookupCommand > commands;
+        commands.reserve( numberOfCommands );
+        while ( commands.size() < static_cast<size_t>( numberOfCommands ) ) {
+            const Driver& driver = fleet[ std::uniform_int_distribution<size_t>( 0, fleet.size() - 1 )( generator ) ];
+            if ( driver.trips().empty() ) continue;
+            const Trip& trip = driver.trips()[ std::uniform_int_distribution<size_t>( 0, driver.trips().size() - 1 )( generator ) ];
+            LookupCommand command;
+            command.driverId = driver.id();
+            command.tripId = trip.id();
+            commands.push_back( command );
+        }
+
+        const std::vector< double > scanLatencies =
+            commandLatencies( commands, [&drivers]( int driverId, int tripId ) { return scanForTrip( drivers, driverId, tripId ); } );
+        const std::vector< double > fleetLatencies =
+            commandLatencies( commands, [&fleet]( int driverId, int tripId ) { return fleet.trip( driverId, tripId ); } );
+
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "Drivers, trips    : " << fleet.size() << ", " << fleet.numberOfTrips() << std::endl;
+        std::cout << "Commands          : " << commands.size() << std::endl;
+        std::cout << "Linear scan       : p50 " << quantile( scanLatencies, 0.5 ) << " ns, p99 " << quantile( scanLatencies, 0.99 ) << " ns" << std::endl;
+        std::cout << "Indexed fleet     : p50 " << quantile( fleetLatencies, 0.5 ) << " ns, p99 " << quantile( fleetLatencies, 0.99 ) << " ns" << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "Unknown error" << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,128 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+#include <exception>
+#include <stdexcept>
+
+#include "KinematicsKernels.h"
+#include "Utilities.h"
+#include "BenchmarkTools.h"
+
+// Measures the throughput of the kinematics kernels of every instruction set supported by the processor,
+// in velocity vectors per nanosecond, on segments of synthetic velocity vectors. The first row is the
+// computation of the segments before the kernels, one velocity vector at a time with std::pow.
+
+
+// The velocity vectors of the segments, one after the other, with the offsets of the segments
+struct SyntheticSegments {
+    std::vector<float> vx;
+    std::vector<float> vy;
+    std::vector<size_t> offsets;
+};
+
+
+// Returns the velocity vectors of synthetic trips, one segment per trip of 20 to 1800 vectors,
+// until there are about the given number of vectors
+static SyntheticSegments syntheticSegments( size_t numberOfVectors )
+{
+    SyntheticTripParameters parameters;
+    parameters.seed = 42;
+    parameters.minimumLength = 21;
+    parameters.maximumLength = 1801;
+    const std::vector< std::pair< int, std::vector< std::pair<float,float> > > > trips =
+        syntheticTrips( static_cast<int>( numberOfVectors / 900 ) + 1, parameters );
+
+    SyntheticSegments segments;
+    segments.vx.reserve( numberOfVectors + parameters.maximumLength );
+    segments.vy.reserve( numberOfVectors + parameters.maximumLength );
+    segments.offsets.push_back( 0 );
+    for ( std::vector< std::pair< int, std::vector< std::pair<float,float> > > >::const_iterator iTrip = trips.begin();
+          iTrip != trips.end(); ++iTrip ) {
+        const std::vector< std::pair<float,float> >& points = iTrip->second;
+        for ( size_t i = 1; i < points.size(); ++i ) {
+            segments.vx.push_back( points[i].first - points[i-1].first );
+            segments.vy.push_back( points[i].second - points[i-1].second );
+        }
+        segments.offsets.push_back( segments.vx.size() );
+    }
+    return segments;
+}
+
+
+// The kinematics of all segments, one velocity vector at a time as the segments computed them
+static double pairwiseKinematics( const SyntheticSegments& segments, std::vector<double>& speed, std::vector<double>& acceleration,
+                                  std::vector<double>& speedXacceleration, std::vector<double>& direction )
+{
+    for ( size_t s = 0; s + 1 < segments.offsets.size(); ++s ) {
+        const size_t begin = segments.offsets[s];
+        const size_t end = segments.offsets[s + 1];
+        for ( size_t i = begin; i < end; ++i )
+            speed[i] = std::sqrt( std::pow(segments.vx[i],2) + std::pow(segments.vy[i], 2) );
+        for ( size_t i = begin + 1; i < end; ++i ) {
+            acceleration[i] = speed[i] - speed[i-1];
+            speedXacceleration[i] = speed[i] * acceleration[i];
+            direction[i] = angleAmongVectors( std::make_pair( segments.vx[i], segments.vy[i] ),
+                                              std::make_pair( segments.vx[i-1], segments.vy[i-1] ) );
+        }
+    }
+    return speed.back() + direction.back();
+}
+
+
+// The kinematics of all segments with the kernels
+static double kernelKinematics( const KinematicsKernels& kernels, const SyntheticSegments& segments, std::vector<double>& speed,
+                                std::vector<double>& acceleration, std::vector<double>& speedXacceleration, std::vector<double>& direction )
+{
+    for ( size_t s = 0; s + 1 < segments.offsets.size(); ++s ) {
+        const size_t begin = segments.offsets[s];
+        const size_t n = segments.offsets[s + 1] - begin;
+        kernels.speed( segments.vx.data() + begin, segments.vy.data() + begin, n, speed.data() + begin );
+        kernels.acceleration( speed.data() + begin, n, acceleration.data() + begin, speedXacceleration.data() + begin );
+        kernels.direction( segments.vx.data() + begin, segments.vy.data() + begin, speed.data() + begin, n, direction.data() + begin );
+    }
+    return speed.back() + direction.back();
+}
+
+
+int main( int, char** ) {
+    try {
+        const SyntheticSegments segments = syntheticSegments( 4000000 );
+        const size_t numberOfVectors = segments.vx.size();
+        std::vector<double> speed( numberOfVectors ), acceleration( numberOfVectors ),
+                            speedXacceleration( numberOfVectors ), direction( numberOfVectors );
+
+        std::cout << std::fixed << std::setprecision(3);
+        std::cout << "Segments, vectors : " << segments.offsets.size() - 1 << ", " << numberOfVectors << std::endl;
+        const double pairwiseTime = bestTime( [&]() { return pairwiseKinematics( segments, speed, acceleration, speedXacceleration, direction ); } );
+        std::cout << std::setw(10) << "Pairwise" << " : " << numberOfVectors / pairwiseTime * 1e-9 << " vectors/ns" << std::endl;
+
+        const KinematicsKernels::InstructionSet instructionSets[] = { KinematicsKernels::Scalar,
+                                                                      KinematicsKernels::SSE2,
+                                                                      KinematicsKernels::AVX2,
+                                                                      KinematicsKernels::AVX512 };
+        for ( size_t k = 0; k < sizeof(instructionSets) / sizeof(instructionSets[0]); ++k ) {
+            if ( ! KinematicsKernels::isSupported( instructionSets[k] ) ) continue;
+            const KinematicsKernels& kernels = KinematicsKernels::forInstructionSet( instructionSets[k] );
+            const double time = bestTime( [&]() { return kernelKinematics( kernels, segments, speed, acceleration, speedXacceleration, direction ); } );
+
+            // The speed kernel on its own, where the instruction set matters most
+            const double speedTime = bestTime( [&]() {
+                    kernels.speed( segments.vx.data(), segments.vy.data(), numberOfVectors, speed.data() );
+                    return speed.back(); } );
+
+            std::cout << std::setw(10) << KinematicsKernels::name( instructionSets[k] ) << " : "
+                      << numberOfVectors / time * 1e-9 << " vectors/ns, speed alone "
+                      << numberOfVectors / speedTime * 1e-9 << " vectors/ns, speedup " << pairwiseTime / time << std::endl;
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "Unknown error" << std::endl;
+        return -1;
+    }
+    return 0;
+}
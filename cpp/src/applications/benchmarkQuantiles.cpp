@@ -0,0 +1,167 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#include "DriverDataProcessing.h"
+#include "Driver.h"
+#include "TripKinematics.h"
+#include "QuantileSelection.h"
+#include "BenchmarkTools.h"
+
+// Compares the quantile selections on the series of the trip metrics: the speed, acceleration, direction and
+// speed x acceleration values of every trip. The series come from the trip data in the given directory, or
+// from synthetic trips whose lengths follow the log-normal distribution of the trip data (median of about
+// 500 points, a tail to several thousands). The results are reported by series length: the five chained
+// nth_element calls of the former findQuantiles, the multi-selection, and the streaming estimates with
+// their largest rank error, which must stay within the rank error of the summary (0.5%).
+
+
+// The quantiles as the former findQuantiles found them
+static std::vector< double > chainedQuantiles( std::vector<double>& values )
+{
+    size_t Q05 = ( values.size() *  5 ) / 100;
+    size_t Q25 = ( values.size() * 25 ) / 100;
+    size_t Q50 = ( values.size() * 50 ) / 100;
+    size_t Q75 = ( values.size() * 75 ) / 100;
+    size_t Q95 = ( values.size() * 95 ) / 100;
+
+    std::nth_element(values.begin()          , values.begin() + Q05, values.end() );
+    std::nth_element(values.begin() + Q05 + 1, values.begin() + Q25, values.end() );
+    std::nth_element(values.begin() + Q25 + 1, values.begin() + Q50, values.end() );
+    std::nth_element(values.begin() + Q50 + 1, values.begin() + Q75, values.end() );
+    std::nth_element(values.begin() + Q75 + 1, values.begin() + Q95, values.end() );
+
+    return std::vector<double> ( { values[Q05], values[Q25], values[Q50], values[Q75], values[Q95] } );
+}
+
+
+// Adds the value series of the trips of a driver
+static void addSeries( const Driver& driver, std::vector< std::vector<double> >& series )
+{
+    const std::vector< Trip >& trips = driver.trips();
+    for ( std::vector< Trip >::const_iterator iTrip = trips.begin(); iTrip != trips.end(); ++iTrip ) {
+        const std::shared_ptr< const TripKinematics > kinematics = iTrip->kinematics();
+        if ( kinematics->speedValues().empty() ) continue;
+        series.push_back( kinematics->speedValues() );
+        series.push_back( kinematics->accelerationValues() );
+        series.push_back( kinematics->directionValues() );
+        series.push_back( kinematics->speedXaccelerationValues() );
+    }
+}
+
+
+// Usage: benchmarkQuantiles [directory] [numberOfThreads]
+int main( int argc, char** argv ) {
+    try {
+        std::vector< std::vector<double> > allSeries;
+        if ( argc > 1 ) {
+            const int numberOfThreads = argc > 2 ? std::max( 1, std::atoi( argv[2] ) ) : 4;
+            const Fleet fleet = DriverDataProcessing( argv[1] ).loadAllData( numberOfThreads );
+            for ( size_t i = 0; i < fleet.size(); ++i ) addSeries( fleet[i], allSeries );
+        }
+        else {
+            Driver driver( 1 );
+            SyntheticTripParameters parameters;
+            parameters.seed = 3;
+            parameters.logNormalLengths = true;
+            parameters.minimumLength = 50;
+            parameters.maximumLength = 8000;
+            driver.loadTripData( syntheticTrips( 4000, parameters ) );
+            addSeries( driver, allSeries );
+        }
+
+        // The series by length
+        const size_t lengthLimits[] = { 0, 300, 1000, 3000, 1000000000 };
+        const size_t numberOfClasses = sizeof(lengthLimits) / sizeof(lengthLimits[0]) - 1;
+        std::cout << std::fixed;
+        for ( size_t c = 0; c < numberOfClasses; ++c ) {
+            std::vector< std::vector<double> > series;
+            size_t numberOfValues = 0;
+            for ( size_t i = 0; i < allSeries.size(); ++i ) {
+                if ( allSeries[i].empty() || allSeries[i].size() < lengthLimits[c] || allSeries[i].size() >= lengthLimits[c + 1] ) continue;
+                series.push_back( allSeries[i] );
+                numberOfValues += allSeries[i].size();
+            }
+            if ( series.empty() ) continue;
+
+            // The multi-selection must find the same values, and the streaming estimates are checked by rank
+            std::vector<double> buffer;
+            double largestRankError = 0;
+            for ( size_t i = 0; i < series.size(); ++i ) {
+                buffer.assign( series[i].begin(), series[i].end() );
+                const std::vector<double> expected = chainedQuantiles( buffer );
+                buffer.assign( series[i].begin(), series[i].end() );
+                QuantileValues selected;
+                selectQuantiles( buffer.data(), buffer.data() + buffer.size(), selected );
+                if ( ! std::equal( expected.begin(), expected.end(), selected.begin() ) )
+                    throw std::runtime_error( "The multi-selection differs from the chained selections" );
+
+                StreamingQuantiles streaming( 0.005 );
+                for ( size_t j = 0; j < series[i].size(); ++j ) streaming( series[i][j] );
+                QuantileValues estimated;
+                streaming.quantiles( estimated );
+                std::sort( buffer.begin(), buffer.end() );
+                for ( size_t q = 0; q < estimated.size(); ++q ) {
+                    // The ranks of the values equal to the estimate are all right
+                    const double lowRank = std::lower_bound( buffer.begin(), buffer.end(), estimated[q] ) - buffer.begin();
+                    const double highRank = std::upper_bound( buffer.begin(), buffer.end(), estimated[q] ) - buffer.begin();
+                    const double rank = static_cast<double>( ( buffer.size() * quantilePercentages[q] ) / 100 );
+                    const double rankError = rank < lowRank ? lowRank - rank : ( rank >= highRank ? rank - highRank + 1 : 0 );
+                    if ( rankError > 0.005 * buffer.size() )
+                        throw std::runtime_error( "The streaming estimates are off by more than their rank error" );
+                    largestRankError = std::max( largestRankError, rankError / buffer.size() );
+                }
+            }
+
+            const double chainedTime = bestTime( [&]() {
+                    double sum = 0;
+                    for ( size_t i = 0; i < series.size(); ++i ) {
+                        buffer.assign( series[i].begin(), series[i].end() );
+                        sum += chainedQuantiles( buffer )[2];
+                    }
+                    return sum; } );
+            const double selectionTime = bestTime( [&]() {
+                    double sum = 0;
+                    QuantileValues quantiles;
+                    for ( size_t i = 0; i < series.size(); ++i ) {
+                        buffer.assign( series[i].begin(), series[i].end() );
+                        selectQuantiles( buffer.data(), buffer.data() + buffer.size(), quantiles );
+                        sum += quantiles[2];
+                    }
+                    return sum; } );
+            const double streamingTime = bestTime( [&]() {
+                    double sum = 0;
+                    QuantileValues quantiles;
+                    for ( size_t i = 0; i < series.size(); ++i ) {
+                        StreamingQuantiles streaming( 0.005 );
+                        for ( size_t j = 0; j < series[i].size(); ++j ) streaming( series[i][j] );
+                        streaming.quantiles( quantiles );
+                        sum += quantiles[2];
+                    }
+                    return sum; } );
+
+            std::cout << "Series of [" << lengthLimits[c] << ", " << lengthLimits[c + 1] << ") values: " << series.size()
+                      << " series, " << std::setprecision(0) << numberOfValues / series.size() << " values on average" << std::endl;
+            std::cout << std::setprecision(3);
+            std::cout << "  chained nth_element : " << numberOfValues / chainedTime * 1e-9 << " values/ns" << std::endl;
+            std::cout << "  multi-selection     : " << numberOfValues / selectionTime * 1e-9 << " values/ns, speedup "
+                      << chainedTime / selectionTime << std::endl;
+            std::cout << "  streaming summary   : " << numberOfValues / streamingTime * 1e-9 << " values/ns, largest rank error "
+                      << 100 * largestRankError << "%" << std::endl;
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "Unknown error" << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#include "DFTPlan.h"
+#include "SlidingDFT.h"
+#include "BenchmarkTools.h"
+
+// Compares the rolling spectra of the trips computed with the sliding DFT against a full transform of
+// every window, on synthetic speed series of 2000 points, for the window sizes of the metrics (11) and
+// of the default rolling FFT (20). The averaged spectra must agree to rounding.
+
+
+// Generates a speed series with accelerations, cruising and stops
+static std::vector<double> syntheticSpeeds( std::mt19937& generator, size_t numberOfPoints )
+{
+    std::uniform_real_distribution<double> uniform( 0.0, 1.0 );
+    std::vector<double> speeds;
+    speeds.reserve( numberOfPoints );
+    double speed = 0;
+    for ( size_t i = 0; i < numberOfPoints; ++i ) {
+        if ( uniform( generator ) < 0.01 ) speed = 0;
+        speed = std::max( 0.0, std::min( 35.0, speed + 2 * ( uniform( generator ) - 0.45 ) ) );
+        speeds.push_back( speed );
+    }
+    return speeds;
+}
+
+
+// The averaged spectrum with a full transform of every window
+static std::vector<double> fullTransforms( DFTPlan& plan, const std::vector<double>& values, size_t numberOfBins )
+{
+    std::vector<double> result( numberOfBins, 0.0 );
+    std::vector<double> bins( plan.numberOfBins() );
+    size_t numberOfTransformations = 0;
+    for ( size_t start = 0; start + plan.size() <= values.size(); ++start ) {
+        plan.magnitudes( values.data() + start, bins.data() );
+        for ( size_t i = 0; i < numberOfBins; ++i ) result[i] += bins[i];
+        ++numberOfTransformations;
+    }
+    for ( size_t i = 0; i < numberOfBins; ++i ) result[i] /= numberOfTransformations;
+    return result;
+}
+
+
+// The averaged spectrum with the sliding DFT
+static std::vector<double> slidingTransforms( SlidingDFT& slidingDFT, const std::vector<double>& values )
+{
+    std::vector<double> result( slidingDFT.numberOfBins(), 0.0 );
+    const std::vector<double>& magnitudes = slidingDFT.magnitudes();
+    size_t numberOfTransformations = 0;
+    for ( size_t start = 0; start + slidingDFT.windowSize() <= values.size(); ++start ) {
+        if ( start == 0 ) slidingDFT.start( values.data() );
+        else slidingDFT.slide( values.data() + start );
+        for ( size_t i = 0; i < result.size(); ++i ) result[i] += magnitudes[i];
+        ++numberOfTransformations;
+    }
+    for ( size_t i = 0; i < result.size(); ++i ) result[i] /= numberOfTransformations;
+    return result;
+}
+
+
+int main( int, char** ) {
+    try {
+        const size_t numberOfTrips = 500;
+        const size_t numberOfPoints = 2000;
+
+        std::mt19937 generator( 42 );
+        std::vector< std::vector<double> > trips;
+        for ( size_t i = 0; i < numberOfTrips; ++i ) trips.push_back( syntheticSpeeds( generator, numberOfPoints ) );
+
+        const size_t windowSizes[] = { 11, 20 };
+        std::cout << std::fixed;
+        for ( size_t w = 0; w < sizeof(windowSizes) / sizeof(windowSizes[0]); ++w ) {
+            const size_t windowSize = windowSizes[w];
+            const size_t numberOfBins = ( windowSize - 1 ) / 2 + ( windowSize + 1 ) % 2;
+            DFTPlan plan( windowSize );
+            SlidingDFT slidingDFT( windowSize, numberOfBins );
+
+            // The spectra must agree to rounding
+            double largestRelativeDifference = 0;
+            for ( size_t i = 0; i < numberOfTrips; ++i ) {
+                const std::vector<double> expected = fullTransforms( plan, trips[i], numberOfBins );
+                const std::vector<double> result = slidingTransforms( slidingDFT, trips[i] );
+                for ( size_t k = 0; k < numberOfBins; ++k )
+                    largestRelativeDifference = std::max( largestRelativeDifference, std::fabs( result[k] - expected[k] ) / expected[0] );
+            }
+            if ( ! ( largestRelativeDifference < 1e-12 ) )
+                throw std::runtime_error( "The sliding DFT differs from the full transforms" );
+
+            const double fullTime = bestTime( [&]() {
+                    double sum = 0;
+                    for ( size_t i = 0; i < numberOfTrips; ++i ) sum += fullTransforms( plan, trips[i], numberOfBins )[0];
+                    return sum; } );
+            const double slidingTime = bestTime( [&]() {
+                    double sum = 0;
+                    for ( size_t i = 0; i < numberOfTrips; ++i ) sum += slidingTransforms( slidingDFT, trips[i] )[0];
+                    return sum; } );
+
+            std::cout << "Window " << std::setw(2) << windowSize << " (" << numberOfBins << " bins) : "
+                      << std::setprecision(0) << "full transforms " << numberOfTrips / fullTime << " trips/s, sliding DFT "
+                      << numberOfTrips / slidingTime << " trips/s, speedup " << std::setprecision(2) << fullTime / slidingTime
+                      << std::scientific << ", largest relative difference " << largestRelativeDifference << std::fixed << std::endl;
+        }
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "Unknown error" << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#include "TripDataCompression.h"
+#include "BenchmarkTools.h"
+
+// Measures the size of the compressed trip format and the speed of its decoding on trips resembling the
+// Kaggle data: 0.1 metre resolution, smooth driving with stops and GPS noise
+
+int main( int, char** ) {
+    try {
+        SyntheticTripParameters parameters;
+        parameters.seed = 12345;
+        parameters.turnRate = 0;
+        const std::vector< std::pair< int, std::vector< std::pair<float,float> > > > trips = syntheticTrips( 200, parameters );
+        
+        size_t numberOfPoints = 0;
+        for ( size_t i = 0; i < trips.size(); ++i ) numberOfPoints += trips[i].second.size();
+        // The raw format: driver id, number of trips, and per trip the id, the number of points and the points
+        const size_t rawSize = sizeof(int) + sizeof(unsigned long) + trips.size() * ( sizeof(int) + sizeof(unsigned long) ) + numberOfPoints * sizeof( std::pair<float,float> );
+        
+        std::vector<char> compressed;
+        compressDriverData( 1, trips, compressed );
+        
+        // Time the decoding, keeping the best of several repetitions
+        std::vector< std::pair< int, std::vector< std::pair<float,float> > > > decoded;
+        const double decodingTime = bestTime( [&]() {
+                int driverId = 0;
+                decompressDriverData( compressed.data(), compressed.size(), driverId, decoded );
+                return driverId; }, 20 );
+        
+        if ( decoded != trips )
+            throw std::runtime_error( "The decoded trips differ from the original ones" );
+        
+        const double decodedBytes = numberOfPoints * sizeof( std::pair<float,float> );
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "Points            : " << numberOfPoints << std::endl;
+        std::cout << "Raw size          : " << rawSize << " bytes" << std::endl;
+        std::cout << "Compressed size   : " << compressed.size() << " bytes" << std::endl;
+        std::cout << "Compression ratio : " << static_cast<double>( rawSize ) / compressed.size() << std::endl;
+        std::cout << "Bits per point    : " << 8.0 * compressed.size() / numberOfPoints << std::endl;
+        std::cout << "Decoding          : " << decodedBytes / decodingTime / 1e9 << " GB/s of decoded points" << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "Unknown error" << std::endl;
+        return -1;
+    }
+    return 0;
+}
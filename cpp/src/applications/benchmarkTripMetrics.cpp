@@ -0,0 +1,120 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <exception>
+#include <new>
+#include <atomic>
+#include <stdint.h>
+#include <sys/resource.h>
+
+#include "DriverDataProcessing.h"
+#include "Driver.h"
+#include "TripMetrics.h"
+
+// Measures the memory held by a loaded fleet and the throughput of the trip metrics calculation.
+// The memory of the trip stores is compared with the points as they were held before, one vector of pairs per trip.
+
+
+// Counts the heap allocations of the process
+static std::atomic< unsigned long > numberOfAllocations( 0 );
+
+void* operator new( size_t size )
+{
+    ++numberOfAllocations;
+    void* memory = std::malloc( size > 0 ? size : 1 );
+    if ( memory == 0 ) throw std::bad_alloc();
+    return memory;
+}
+
+void operator delete( void* memory ) noexcept
+{
+    std::free( memory );
+}
+
+
+// Returns the peak resident memory of the process in MB
+static double peakMemory()
+{
+    struct rusage usage;
+    getrusage( RUSAGE_SELF, &usage );
+#ifdef __APPLE__
+    return usage.ru_maxrss / ( 1024.0 * 1024.0 );   // bytes
+#else
+    return usage.ru_maxrss / 1024.0;                // kilobytes
+#endif
+}
+
+
+// Usage: benchmarkTripMetrics [directory] [numberOfThreads] [cacheKinematics (1|0)]
+int main( int argc, char** argv ) {
+    try {
+        std::string driverDirectoryName = "drivers_compressed_data";
+        int numberOfThreads = 4;
+        if ( argc > 1 ) driverDirectoryName = argv[1];
+        if ( argc > 2 ) numberOfThreads = std::max( 1, std::atoi( argv[2] ) );
+        if ( argc > 3 ) Trip::setKinematicsCaching( std::atoi( argv[3] ) != 0 );
+        
+        const double initialMemory = peakMemory();
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        Fleet drivers = DriverDataProcessing( driverDirectoryName ).loadAllData( numberOfThreads );
+        std::chrono::duration<double> loadingTime = std::chrono::high_resolution_clock::now() - start;
+        const double loadedMemory = peakMemory();
+        
+        // The metrics of all trips in a single thread. A hash of the values guards against changed results.
+        // The drivers are loaded in any order, so the hashes of the trips are summed up
+        size_t numberOfTrips = 0;
+        uint64_t hashOfValues = 0;
+        const unsigned long initialAllocations = numberOfAllocations.load();
+        start = std::chrono::high_resolution_clock::now();
+        for ( size_t i = 0; i < drivers.size(); ++i ) {
+            const std::vector< Trip >& trips = drivers[i].trips();
+            for ( std::vector< Trip >::const_iterator iTrip = trips.begin(); iTrip != trips.end(); ++iTrip ) {
+                const TripMetrics metrics = iTrip->metrics();
+                const std::vector< double >& values = metrics.values();
+                uint64_t hashOfTrip = 14695981039346656037ULL;
+                for ( size_t j = 0; j < values.size(); ++j ) {
+                    uint64_t bits = 0;
+                    std::memcpy( &bits, &values[j], sizeof(bits) );
+                    hashOfTrip = ( hashOfTrip ^ bits ) * 1099511628211ULL;
+                }
+                hashOfValues += hashOfTrip;
+                ++numberOfTrips;
+            }
+        }
+        std::chrono::duration<double> metricsTime = std::chrono::high_resolution_clock::now() - start;
+        const unsigned long metricsAllocations = numberOfAllocations.load() - initialAllocations;
+        
+        size_t kinematicsMemory = 0, storeMemory = 0, pointMemory = 0;
+        for ( size_t i = 0; i < drivers.size(); ++i ) {
+            const std::vector< Trip >& trips = drivers[i].trips();
+            for ( std::vector< Trip >::const_iterator iTrip = trips.begin(); iTrip != trips.end(); ++iTrip ) {
+                kinematicsMemory += iTrip->kinematicsMemoryUsage();
+                pointMemory += iTrip->rawData().size() * sizeof( std::pair<float,float> );
+            }
+            storeMemory += drivers[i].tripStore()->memoryUsage();
+        }
+        
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "Drivers, trips          : " << drivers.size() << ", " << numberOfTrips << std::endl;
+        std::cout << "Loading                 : " << loadingTime.count() << " s" << std::endl;
+        std::cout << "Peak memory after load  : " << loadedMemory - initialMemory << " MB" << std::endl;
+        std::cout << "Trip coordinates        : " << storeMemory / ( 1024.0 * 1024.0 ) << " MB in the stores, "
+                  << pointMemory / ( 1024.0 * 1024.0 ) << " MB as vectors of points" << std::endl;
+        std::cout << "Metrics                 : " << numberOfTrips / metricsTime.count() << " trips/s" << std::endl;
+        std::cout << "Allocations per trip    : " << static_cast<double>( metricsAllocations ) / std::max( numberOfTrips, size_t( 1 ) ) << std::endl;
+        std::cout << "Peak memory at the end  : " << peakMemory() - initialMemory << " MB" << std::endl;
+        std::cout << "Kinematics cache        : " << kinematicsMemory / std::max( numberOfTrips, size_t( 1 ) ) / 1024.0 << " kB per trip" << std::endl;
+        std::cout << "Hash of the metrics     : " << std::hex << hashOfValues << std::dec << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "Unknown error" << std::endl;
+        return -1;
+    }
+    return 0;
+}
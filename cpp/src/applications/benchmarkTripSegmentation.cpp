@@ -0,0 +1,332 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <stdint.h>
+
+#include "TripStore.h"
+#include "TripSegmentation.h"
+#include "Utilities.h"
+#include "BenchmarkTools.h"
+
+// Checks the segmentation of synthetic trips against the original implementation, Trip::generateSegments before
+// the segments became views of the trip coordinates, and reports the throughput of both.
+// Both run the same four passes over every trip; the original copies the trip and every intermediate segment,
+// while TripSegmentation cuts views of the trip coordinates into reused buffers.
+// The segments of the original Trip class are also recorded as a digest of the segment boundaries and the
+// extra travel duration and length, so that the copy of the original below is checked as well.
+
+// The number of segments and the digest of the original Trip class
+static const size_t originalNumberOfSegments = 72880;
+static const uint64_t originalDigest = 0xb2c7952262a8c37eULL;
+
+
+// The original segmentation, with the four passes of Trip::generateSegments copying their segments
+class OriginalSegmentation {
+public:
+    // Constructor
+    OriginalSegmentation(): m_extraTravelDuration( 0 ), m_extraTravelLength( 0 ) {}
+
+    // Segments a trip
+    std::vector< std::vector< std::pair< float, float > > > segment( const std::vector< std::pair< float, float > >& tripRawData ) {
+        m_extraTravelDuration = 0;
+        m_extraTravelLength = 0;
+
+        std::vector< std::pair< float, float > > rawData = tripRawData;
+
+        std::vector< std::vector< std::pair< float, float > > > segmentsFirstPass;
+        this->removeZeroSpeedSegments( rawData, segmentsFirstPass );
+
+        std::vector< std::vector< std::pair< float, float > > > segmentsSecondPass;
+        for ( std::vector< std::vector< std::pair< float, float > > >::const_iterator iSegment = segmentsFirstPass.begin();
+             iSegment != segmentsFirstPass.end(); ++iSegment )
+            this->identifyGapsCorrectJitter( *iSegment, segmentsSecondPass );
+        segmentsFirstPass.clear();
+
+        std::vector< std::vector< std::pair< float, float > > > segmentsThirdPass;
+        for ( std::vector< std::vector< std::pair< float, float > > >::const_iterator iSegment = segmentsSecondPass.begin();
+             iSegment != segmentsSecondPass.end(); ++iSegment )
+            this->removeAccuteAngleSegments( *iSegment, segmentsThirdPass );
+        segmentsSecondPass.clear();
+
+        std::vector< std::vector< std::pair< float, float > > > segmentsFourthPass;
+        for ( std::vector< std::vector< std::pair< float, float > > >::const_iterator iSegment = segmentsThirdPass.begin();
+             iSegment != segmentsThirdPass.end(); ++iSegment )
+            this->identifyGapsCorrectJitter( *iSegment, segmentsFourthPass );
+        return segmentsFourthPass;
+    }
+
+    // Returns the travel duration and length not included in the segments of the last call
+    inline long extraTravelDuration() const { return m_extraTravelDuration; }
+    inline double extraTravelLength() const { return m_extraTravelLength; }
+
+private:
+    void identifyGapsCorrectJitter( const std::vector< std::pair< float, float > >& tripData,
+                                    std::vector< std::vector< std::pair< float, float > > >& segments ) {
+        const double maxAcceleration = 5;
+        const double speedToTrigger = 10;
+
+        double v_previous = 0;
+        std::pair<float,float> p_previous = tripData[0];
+        size_t i = 1;
+        size_t segmentStartingIndex = 0;
+
+        while ( i < tripData.size() ) {
+            std::pair<float,float> p_current = tripData[i];
+            double v_current = magnitude( p_current - p_previous );
+
+            if ( ( std::abs( v_current - v_previous ) > maxAcceleration ) &&  v_current > speedToTrigger ) {
+                size_t nDiff = i - segmentStartingIndex;
+                if ( nDiff > 1 ) {
+                    std::vector< std::pair< float, float > > segment( tripData.begin() + segmentStartingIndex, tripData.begin() + i );
+                    segments.push_back( segment );
+                }
+                else {
+                    if ( i < tripData.size() - 1 ) {
+                        std::pair<float,float> p_next = tripData[i];
+                        double v_next = magnitude( p_next - p_current );
+                        if ( std::abs( v_current - v_next ) < maxAcceleration ) {
+                            m_extraTravelDuration += 1;
+                            m_extraTravelLength += magnitude( p_next - p_previous );
+                        }
+                    }
+                }
+
+                if ( i < tripData.size() - 1 ) {
+                    std::pair<float,float> p_next = tripData[i+1];
+                    double v_next = magnitude( p_next - p_current );
+                    if ( std::abs( v_current - v_next ) > maxAcceleration ) {
+                        double averageSpeedInGap = 0.5 * ( v_next + v_previous );
+                        double distanceSpentInGap = magnitude( p_current - p_previous );
+                        m_extraTravelLength += distanceSpentInGap;
+                        m_extraTravelDuration += static_cast<int>( std::nearbyint( distanceSpentInGap / averageSpeedInGap ) );
+                        segmentStartingIndex = i;
+                        ++i;
+                        p_current = p_next;
+                        v_current = v_next;
+                    }
+                    else {
+                        size_t j = i + 2;
+                        bool endOfSpikesFound = false;
+                        while ( j < tripData.size() - 1 ) {
+                            std::pair<float,float> p_nnext = tripData[j];
+                            double v_nnext = magnitude( p_next - p_nnext );
+                            std::pair<float,float> p_nnnext = tripData[j+1];
+                            double v_nnnext = magnitude( p_nnnext - p_nnext );
+
+                            if ( std::abs( v_nnnext - v_nnext ) < maxAcceleration ) {
+                                double averageSpeedInGap = 0.5 * ( v_nnext + v_previous );
+                                double distanceSpentInGap = magnitude( p_next - p_previous );
+                                m_extraTravelLength += distanceSpentInGap;
+                                m_extraTravelDuration += static_cast<int>( std::nearbyint( distanceSpentInGap / averageSpeedInGap ) );
+                                i = j;
+                                segmentStartingIndex = i-1;
+                                p_current = p_next;
+                                v_current = averageSpeedInGap;
+                                endOfSpikesFound = true;
+                                break;
+                            }
+                            ++j;
+                            p_next = p_nnext;
+                        }
+                        if ( ! endOfSpikesFound ) {
+                            i = j;
+                            segmentStartingIndex = i;
+                        }
+                    }
+                }
+            }
+
+            p_previous = p_current;
+            v_previous = v_current;
+            ++i;
+        }
+
+        if ( tripData.size() - segmentStartingIndex > 2 ) {
+            std::vector< std::pair< float, float > > segment( tripData.begin()+segmentStartingIndex, tripData.end() );
+            segments.push_back( segment );
+        }
+    }
+
+    void removeAccuteAngleSegments( const std::vector< std::pair< float, float > >& tripData,
+                                    std::vector< std::vector< std::pair< float, float > > >& segments ) {
+        const double pi = std::atan( 1.0 ) * 4;
+        const double maxAngle = 100 * pi / 180.0;
+
+        size_t segentStartingIndex = 0;
+
+        std::pair<float, float> v_previous = tripData[1]-tripData[0];
+        size_t i = 2;
+        while ( i < tripData.size() ) {
+            std::pair<float, float> v_current = tripData[i] - tripData[i-1];
+            double angle = angleAmongVectors( v_current, v_previous );
+
+            if ( std::abs( angle ) > maxAngle ) {
+                if ( i - segentStartingIndex > 2 ) {
+                    std::vector< std::pair< float, float > > segment( tripData.begin() + segentStartingIndex, tripData.begin() + i - 1 );
+                    segments.push_back( segment );
+                }
+
+                m_extraTravelDuration += 2;
+                m_extraTravelLength += magnitude(tripData[i-2] - tripData[i]);
+
+                segentStartingIndex = i;
+                i += 2;
+                if ( i - 1 < tripData.size() )
+                    v_previous = tripData[i-1] - tripData[i-2];
+                continue;
+            }
+            v_previous = v_current;
+            ++i;
+        }
+
+        if ( tripData.size() - segentStartingIndex > 2 ) {
+            std::vector< std::pair< float, float > > segment( tripData.begin()+segentStartingIndex, tripData.end() );
+            segments.push_back( segment );
+        }
+    }
+
+    void removeZeroSpeedSegments( const std::vector< std::pair< float, float > >& tripData,
+                                  std::vector< std::vector< std::pair< float, float > > >& segments ) {
+        const double zeroSpeedTolerance = 1.5;
+
+        size_t segentStartingIndex = 0;
+        size_t zeroSpeedCounter = 0;
+        std::pair<float, float> p_previous = tripData[0];
+        for (size_t i = 1; i < tripData.size(); ++i ) {
+            std::pair<float, float> p_current = tripData[i];
+            double v_current = magnitude( p_current - p_previous );
+
+            if ( v_current < zeroSpeedTolerance ) {
+                if ( zeroSpeedCounter == 0 ) {
+                    if ( i - segentStartingIndex > 1 ) {
+                        std::vector< std::pair< float, float > > segment( tripData.begin() + segentStartingIndex, tripData.begin() + i );
+                        segments.push_back( segment );
+                    }
+                }
+                zeroSpeedCounter += 1;
+                segentStartingIndex = i;
+            }
+            else {
+                zeroSpeedCounter = 0;
+            }
+            p_previous = p_current;
+        }
+
+        if ( tripData.size() - segentStartingIndex > 2 ) {
+            std::vector< std::pair< float, float > > segment( tripData.begin()+segentStartingIndex, tripData.end() );
+            segments.push_back( segment );
+        }
+    }
+
+    long m_extraTravelDuration;
+    double m_extraTravelLength;
+};
+
+
+// Adds a value to a 64-bit FNV-1a digest, byte by byte
+static void addToDigest( uint64_t& digest, long long value )
+{
+    for ( int i = 0; i < 8; ++i ) {
+        digest ^= ( value >> ( 8 * i ) ) & 0xff;
+        digest *= 1099511628211ULL;
+    }
+}
+
+
+// Returns true if a segment view holds the points of a copied segment
+static bool sameSegment( const TripCoordinates& segment, const std::vector< std::pair< float, float > >& copiedSegment )
+{
+    if ( segment.size() != copiedSegment.size() ) return false;
+    for ( size_t i = 0; i < segment.size(); ++i )
+        if ( segment[i] != copiedSegment[i] ) return false;
+    return true;
+}
+
+
+int main( int, char** ) {
+    try {
+        const int numberOfTrips = 2000;
+
+        // Trips with stops, gaps, jitter spikes and sharp turns
+        SyntheticTripParameters parameters;
+        parameters.seed = 42;
+        parameters.minimumLength = 50;
+        parameters.maximumLength = 1800;
+        parameters.stopRate = 10;
+        parameters.gapRate = 10;
+        parameters.turnRate = 10;
+        parameters.spikeRate = 10;
+        const std::vector< std::pair< int, std::vector< std::pair<float,float> > > > tripData = syntheticTrips( numberOfTrips, parameters );
+        const TripStore store( tripData );
+
+        // The segments, the extra travel durations and lengths against the original segmentation, and the digest
+        // of the trips, the offsets and sizes of their segments and the extra travel durations and lengths
+        TripSegmentation segmentation;
+        OriginalSegmentation originalSegmentation;
+        size_t numberOfSegments = 0;
+        uint64_t digest = 14695981039346656037ULL;
+        for ( size_t i = 0; i < store.numberOfTrips(); ++i ) {
+            const TripCoordinates trip = store.trip( i );
+            const std::vector< TripCoordinates >& segments = segmentation.segment( trip );
+            const std::vector< std::vector< std::pair< float, float > > > originalSegments = originalSegmentation.segment( tripData[i].second );
+            bool sameSegments = segments.size() == originalSegments.size() &&
+                segmentation.extraTravelDuration() == originalSegmentation.extraTravelDuration() &&
+                segmentation.extraTravelLength() == originalSegmentation.extraTravelLength();
+            for ( size_t j = 0; sameSegments && j < segments.size(); ++j )
+                sameSegments = sameSegment( segments[j], originalSegments[j] );
+            if ( ! sameSegments ) {
+                std::ostringstream os;
+                os << "The segments of trip " << store.tripId( i ) << " differ from the original segmentation";
+                throw std::runtime_error( os.str() );
+            }
+
+            addToDigest( digest, store.tripId( i ) );
+            addToDigest( digest, segments.size() );
+            for ( std::vector< TripCoordinates >::const_iterator iSegment = segments.begin(); iSegment != segments.end(); ++iSegment ) {
+                addToDigest( digest, iSegment->x() - trip.x() );
+                addToDigest( digest, iSegment->size() );
+            }
+            addToDigest( digest, segmentation.extraTravelDuration() );
+            const double extraTravelLength = segmentation.extraTravelLength();
+            long long extraTravelLengthBits = 0;
+            std::memcpy( &extraTravelLengthBits, &extraTravelLength, sizeof(extraTravelLength) );
+            addToDigest( digest, extraTravelLengthBits );
+            numberOfSegments += segments.size();
+        }
+        if ( numberOfSegments != originalNumberOfSegments || digest != originalDigest ) {
+            std::ostringstream os;
+            os << "The segments differ from the original Trip class: " << numberOfSegments << " segments, digest "
+               << std::hex << digest;
+            throw std::runtime_error( os.str() );
+        }
+        std::cout << "Segments of the original implementation for " << numberOfTrips << " trips (" << numberOfSegments << " segments)" << std::endl;
+
+        const double originalTime = bestTime( [&]() {
+            size_t n = 0;
+            for ( size_t i = 0; i < tripData.size(); ++i ) n += originalSegmentation.segment( tripData[i].second ).size();
+            return static_cast<double>( n );
+        } );
+        const double time = bestTime( [&]() {
+            size_t n = 0;
+            for ( size_t i = 0; i < store.numberOfTrips(); ++i ) n += segmentation.segment( store.trip( i ) ).size();
+            return static_cast<double>( n );
+        } );
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "Original four passes with copies : " << numberOfTrips / originalTime << " trips/s" << std::endl;
+        std::cout << "Four passes over views           : " << numberOfTrips / time << " trips/s ("
+                  << originalTime / time << " times faster)" << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "Unknown error" << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include <iostream>
+#include <sstream>
+#include <exception>
+
+#include "DriverTripDataIO.h"
+#include "DirectoryListing.h"
+#include "TripDataArchiveWriter.h"
+#include "ProcessLogger.h"
+
+// Converts the per driver binary files into a single fleet archive
+int main( int argc, char** argv ) {
+    try {
+        std::string driverCompressedDir = "drivers_compressed_data";
+        std::string archiveFileName = "drivers.archive";
+        if ( argc > 1 ) archiveFileName = argv[1];
+        
+        // The archive expects the drivers in increasing id order
+        DirectoryListing dirList( driverCompressedDir );
+        dirList.setExtensionFilter( ".data" ).setOrdering( DirectoryListing::NumericOrdering );
+        std::list<std::string> driverFiles = dirList.directoryContent();
+        
+        std::vector<int> driverIds;
+        driverIds.reserve( driverFiles.size() );
+        for ( std::list<std::string>::const_iterator iDriverFile = driverFiles.begin();
+             iDriverFile != driverFiles.end(); ++iDriverFile ) {
+            int driverId = 0;
+            std::istringstream isId( *iDriverFile );
+            isId >> driverId;
+            driverIds.push_back( driverId );
+        }
+        
+        ProcessLogger log( driverIds.size(), "Writing the fleet archive : " );
+        
+        TripDataArchiveWriter archive( archiveFileName );
+        for ( std::vector<int>::const_iterator iDriverId = driverIds.begin();
+             iDriverId != driverIds.end(); ++iDriverId ) {
+            DriverTripDataIO dataIO( *iDriverId );
+            dataIO.readDataFromBinaryFile( driverCompressedDir );
+            archive.addDriver( dataIO.id(), dataIO.rawData() );
+            log.taskEnded();
+        }
+        archive.close();
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "Unknown error" << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -1,9 +1,11 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <cstring>
 #include <exception>
 
 #include "DriverDataProcessing.h"
+#include "TripDataArchive.h"
 #include "Segment.h"
 
 class CppToPythonPipe
@@ -11,34 +13,46 @@ class CppToPythonPipe
 public:
     explicit CppToPythonPipe( const std::string& inputFileName,
                              const std::string& outputFileName,
-                             std::vector< std::auto_ptr<Driver> >& drivers,
-                             DriverDataProcessing& dataProcessing ):
+                             Fleet& drivers,
+                             DriverDataProcessing& dataProcessing,
+                             TripDataArchive* archive = 0 ):
     m_inputFileName(inputFileName),
     m_outputFileName(outputFileName),
     m_drivers( drivers ),
-    m_dataProcessing( dataProcessing )
+    m_dataProcessing( dataProcessing ),
+    m_archive( archive ),
+    m_archiveTrip(),
+    m_archiveTripDriverId( 0 )
     {}
     
     virtual ~CppToPythonPipe() {}
     
 private:
-    Driver* driver( int driverId ) const {
-        std::vector< std::auto_ptr<Driver> >::iterator iDriver  = m_drivers.begin();
-        while (  iDriver != m_drivers.end() ) {
-            if ( (*iDriver)->id() == driverId ) break;
-            ++iDriver;
-        }
-        if (iDriver == m_drivers.end() ) return 0;
-        return iDriver->get();
+    const Driver* driver( int driverId ) {
+        const Driver* driver = m_drivers.driver( driverId );
+        if ( driver != 0 || m_archive == 0 ) return driver;
+        
+        // Load the driver on demand from the archive
+        std::vector< std::pair< int, std::vector< std::pair<float,float> > > > tripData = m_archive->readDriver( driverId );
+        if ( tripData.empty() ) return 0;
+        Driver newDriver( driverId );
+        newDriver.loadTripData( tripData );
+        return &m_drivers.add( std::move( newDriver ) );
     }
     
-    const Trip* trip( int driverId, int tripId ) const {
-        Driver* driver = this->driver( driverId );
-        if ( driver == 0 ) return 0;
-        const std::vector<Trip>& trips = driver->trips();
-        std::vector<Trip>::const_iterator iTrip = std::find( trips.begin(), trips.end(), tripId );
-        if (iTrip == trips.end() ) return 0;
-        return &(*iTrip);
+    const Trip* trip( int driverId, int tripId ) {
+        if ( m_drivers.driver( driverId ) == 0 && m_archive != 0 ) {
+            // Fetch the single trip from the archive
+            if ( m_archiveTrip.get() != 0 && m_archiveTripDriverId == driverId && m_archiveTrip->id() == tripId )
+                return m_archiveTrip.get();
+            const TripDataArchiveEntry* entry = m_archive->findTrip( driverId, tripId );
+            if ( entry == 0 ) return 0;
+            m_archiveTrip.reset( new Trip( tripId ) );
+            m_archiveTrip->setTripData( m_archive->readTrip( *entry ) );
+            m_archiveTripDriverId = driverId;
+            return m_archiveTrip.get();
+        }
+        return m_drivers.trip( driverId, tripId );
     }
     
 public:
@@ -65,21 +79,21 @@ public:
             const Trip* trip = this->trip( driverId, tripId );
             if ( trip == 0 ) return false;
             std::ofstream outputPipe( m_outputFileName );
-            const std::vector< std::pair< float, float > >& rawData = trip->rawData();
+            const TripCoordinates& rawData = trip->rawData();
             outputPipe << rawData.size() << std::endl;
-            for ( std::vector< std::pair< float, float > >::const_iterator iPoint = rawData.begin(); iPoint != rawData.end(); ++iPoint )
-                outputPipe << iPoint->first << " " << iPoint->second << std::endl;
+            for ( size_t i = 0; i < rawData.size(); ++i )
+                outputPipe << rawData.x()[i] << " " << rawData.y()[i] << std::endl;
             outputPipe.close();
         }
         else if ( command == "segments" ) {
             const Trip* trip = this->trip( driverId, tripId );
             if ( trip == 0 ) return false;
             std::ofstream outputPipe( m_outputFileName );
-            const std::vector< Segment* >& segments = trip->segments();
+            const std::vector< Segment >& segments = trip->segments();
             outputPipe << segments.size() << std::endl;
-            for ( std::vector< Segment* >::const_iterator iSegment = segments.begin();
+            for ( std::vector< Segment >::const_iterator iSegment = segments.begin();
                  iSegment != segments.end(); ++iSegment ) {
-                Segment& segment = **iSegment;
+                const Segment& segment = *iSegment;
                 std::vector< std::pair<float,float> > segmentRawData = segment.dataPoints();
                 outputPipe << segmentRawData.size() << std::endl;
                 for ( std::vector< std::pair< float, float > >::const_iterator iPoint = segmentRawData.begin();
@@ -194,15 +208,23 @@ public:
             }
             outputPipe.close();
         }
+        else if ( command == "drivers" && m_archive != 0 ) {
+            std::ofstream outputPipe( m_outputFileName );
+            std::vector<int> driverIds = m_archive->driverIds();
+            outputPipe << driverIds.size() << std::endl;
+            for ( std::vector<int>::const_iterator iDriverId = driverIds.begin(); iDriverId != driverIds.end(); ++iDriverId )
+                outputPipe << *iDriverId << std::endl;
+            outputPipe.close();
+        }
         else if ( command == "drivers") {
             std::ofstream outputPipe( m_outputFileName );
             outputPipe << m_drivers.size() << std::endl;
-            for ( std::vector< std::auto_ptr<Driver> >::const_iterator iDriver = m_drivers.begin(); iDriver != m_drivers.end(); ++iDriver )
-                outputPipe << (*iDriver)->id() << std::endl;
+            for ( size_t i = 0; i < m_drivers.size(); ++i )
+                outputPipe << m_drivers[i].id() << std::endl;
             outputPipe.close();
         }
         else if ( command == "trips") {
-            Driver* driver = this->driver( driverId );
+            const Driver* driver = this->driver( driverId );
             if ( driver == 0 ) return false;
             const std::vector<Trip>& trips = driver->trips();
             
@@ -234,31 +256,29 @@ public:
             outputPipe.close();
         }
         else if ( command == "allTripMetrics" ) {
-            std::vector< TripMetrics > outputData;
+            FeatureMatrix outputData;
             m_dataProcessing.produceTripMetrics( outputData );
             
             std::ofstream outputPipe( m_outputFileName );
-            outputData.front().writeDescriptions( outputPipe ) << std::endl;
+            FeatureMatrix::writeDescriptions( outputPipe ) << std::endl;
             
-            outputPipe << outputData.size() << std::endl;
-            for ( std::vector< TripMetrics >::const_iterator iTripData = outputData.begin();
-                 iTripData != outputData.end(); ++iTripData ) {
-                outputPipe << *iTripData << std::endl;
+            outputPipe << outputData.numberOfRows() << std::endl;
+            for ( size_t row = 0; row < outputData.numberOfRows(); ++row ) {
+                outputData.writeRow( outputPipe, row ) << std::endl;
             }
             outputPipe.close();
         }
         else if ( command == "driverTripMetrics" ) {
-            Driver* driver = this->driver( driverId );
+            const Driver* driver = this->driver( driverId );
             if ( driver == 0 ) return false;
-            std::vector< TripMetrics > outputData = driver->tripMetrics();
+            FeatureMatrix outputData = driver->tripMetrics();
 
             std::ofstream outputPipe( m_outputFileName );
-            outputData.front().writeDescriptions( outputPipe ) << std::endl;
+            FeatureMatrix::writeDescriptions( outputPipe ) << std::endl;
             
-            outputPipe << outputData.size() << std::endl;
-            for ( std::vector< TripMetrics >::const_iterator iTripData = outputData.begin();
-                 iTripData != outputData.end(); ++iTripData ) {
-                outputPipe << *iTripData << std::endl;
+            outputPipe << outputData.numberOfRows() << std::endl;
+            for ( size_t row = 0; row < outputData.numberOfRows(); ++row ) {
+                outputData.writeRow( outputPipe, row ) << std::endl;
             }
             outputPipe.close();
         }
@@ -273,24 +293,36 @@ public:
 private:
     std::string m_inputFileName;
     std::string m_outputFileName;
-    std::vector< std::auto_ptr<Driver> >& m_drivers;
+    Fleet& m_drivers;
     DriverDataProcessing& m_dataProcessing;
+    TripDataArchive* m_archive;
+    std::unique_ptr<Trip> m_archiveTrip;
+    int m_archiveTripDriverId;
 };
 
 
 
 
-int main( int, char**) {
+int main( int argc, char** argv ) {
     try {
         std::string driverCompressedDir = "drivers_compressed_data";
         DriverDataProcessing dataProcessing( driverCompressedDir );
         
-        std::cout << "Loading and preprocessing the data" << std::endl;
-        std::vector< std::auto_ptr<Driver> > drivers = dataProcessing.loadAllData();
+        // With an archive given, drivers and trips are fetched on demand instead of loading everything up front
+        std::unique_ptr<TripDataArchive> archive;
+        Fleet drivers;
+        if ( argc > 1 ) {
+            std::cout << "Opening the archive " << argv[1] << std::endl;
+            archive.reset( new TripDataArchive( argv[1] ) );
+        }
+        else {
+            std::cout << "Loading and preprocessing the data" << std::endl;
+            drivers = dataProcessing.loadAllData();
+        }
         
         std::cout << "Ready for receing commands." << std::endl;
         
-        CppToPythonPipe pipe( "pythontocpppipe", "cpptopythonpipe", drivers, dataProcessing );
+        CppToPythonPipe pipe( "pythontocpppipe", "cpptopythonpipe", drivers, dataProcessing, archive.get() );
         
         while( pipe.processCommands() );
         
@@ -8,7 +8,7 @@ int main( int, char**) {
         std::string driverCompressedDir = "drivers_compressed_data";
         DriverDataProcessing dataProcessing( driverCompressedDir );
         
-        std::vector< std::auto_ptr<Driver> > drivers = dataProcessing.loadAllData();
+        Fleet drivers = dataProcessing.loadAllData();
         
         std::cout << "Done. ";
         std::cin.get();
@@ -1,34 +1,409 @@
 #include <iostream>
 #include <sstream>
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
 #include <exception>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <map>
+#include <set>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #include "DriverTripDataIO.h"
 #include "DirectoryListing.h"
 #include "ProcessLogger.h"
+#include "BoundedQueue.h"
+#include "ConversionManifest.h"
 
-int main( int, char**) {
-    try {
-        std::string driverCSVDir = "drivers";
-        std::string driverCompressedDir = "drivers_compressed_data";
+// The conversion runs as a pipeline:
+//   enumeration of the driver directories -> parsing workers -> writers in enumeration order
+// so that the csv parsing of many drivers overlaps with the writing of the binary files.
+// A manifest next to the output directory records the state of the csv files of every converted driver,
+// so that only the new drivers and the drivers whose csv files have changed are converted again.
+
+
+// The outcome of the check of a driver against the manifest
+enum DriverStatus {
+    NewDriver,        // Not converted before
+    ChangedDriver,    // The csv files, the format or the binary file changed since the last conversion
+    UnchangedDriver   // Up to date
+};
+
+
+// A driver passing through the pipeline. The data are only read for the drivers to convert
+struct DriverConversion {
+    DriverConversion( int id ): driverId( id ), status( NewDriver ), state(), updateManifest( false ), data(), numberOfSkippedRows( 0 ) {}
+    
+    int driverId;
+    DriverStatus status;
+    DriverSourceState state;
+    bool updateManifest;
+    std::unique_ptr<DriverTripDataIO> data;
+    size_t numberOfSkippedRows;
+};
+
+
+// The settings shared by the pipeline threads
+struct ConversionSettings {
+    std::string driverCSVDir;
+    std::string driverCompressedDir;
+    DriverTripDataIO::BinaryFormat format;
+    bool dryRun;
+    bool fullConversion;
+};
+
+
+// Counts the drivers by status, and the csv rows skipped
+class ConversionReport {
+public:
+    ConversionReport(): m_numberOfDrivers(), m_csvBytes(), m_numberOfSkippedRows( 0 ), m_driverIds(), m_mutex() {
+        for ( int i = 0; i < 3; ++i ) { m_numberOfDrivers[i] = 0; m_csvBytes[i] = 0; }
+    }
+    
+    void add( const DriverConversion& driver ) {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        ++m_numberOfDrivers[driver.status];
+        m_csvBytes[driver.status] += driver.state.totalSize;
+        m_numberOfSkippedRows += driver.numberOfSkippedRows;
+        m_driverIds.insert( driver.driverId );
+    }
+    
+    // The ids of all drivers found in the csv directory
+    inline const std::set<int>& driverIds() const { return m_driverIds; }
+    
+    void print( std::ostream& os, bool dryRun, size_t numberOfRemovedDrivers ) const {
+        const char* verb = dryRun ? "to convert" : "converted";
+        os << "New drivers " << verb << "       : " << m_numberOfDrivers[NewDriver]
+           << " (" << m_csvBytes[NewDriver] / 1.0e6 << " MB of csv)\n"
+           << "Changed drivers " << verb << "   : " << m_numberOfDrivers[ChangedDriver]
+           << " (" << m_csvBytes[ChangedDriver] / 1.0e6 << " MB of csv)\n"
+           << "Unchanged drivers skipped : " << m_numberOfDrivers[UnchangedDriver]
+           << " (" << m_csvBytes[UnchangedDriver] / 1.0e6 << " MB of csv)\n"
+           << "Drivers no longer in the csv directory : " << numberOfRemovedDrivers
+           << ( dryRun ? " (binary files to remove)\n" : " (binary files removed)\n" )
+           << "Csv rows without a valid point skipped : " << m_numberOfSkippedRows << std::endl;
+    }
+    
+private:
+    unsigned long m_numberOfDrivers[3];
+    unsigned long long m_csvBytes[3];
+    unsigned long long m_numberOfSkippedRows;
+    std::set<int> m_driverIds;
+    std::mutex m_mutex;
+};
+
+
+// Checks a driver against the manifest. The content hash is only computed if the file sizes or times differ
+static void checkDriver( const ConversionSettings& settings,
+                         const ConversionManifest& manifest,
+                         DriverConversion& driver )
+{
+    driver.state = ConversionManifest::scanDriverFiles( settings.driverCSVDir, driver.driverId );
+    driver.state.format = settings.format;
+    
+    DriverSourceState recorded;
+    if ( settings.fullConversion || ! manifest.find( driver.driverId, recorded ) ) {
+        driver.status = NewDriver;
+    }
+    else {
+        std::ostringstream osFileName;
+        osFileName << settings.driverCompressedDir << "/" << driver.driverId << ".data";
+        struct stat fileStatus;
+        const bool upToDate = recorded.format == driver.state.format && ::stat( osFileName.str().c_str(), &fileStatus ) == 0;
         
-        DirectoryListing dirList( driverCSVDir );
-        std::list<std::string> driverDirs = dirList.directoryContent();
+        if ( upToDate && recorded.sameFiles( driver.state ) ) {
+            driver.state.contentHash = recorded.contentHash;
+            driver.status = UnchangedDriver;
+            return;
+        }
+        driver.status = ChangedDriver;
         
-        ProcessLogger log( driverDirs.size() );
+        // Touched files with the same content only need the manifest updated
+        if ( upToDate && recorded.numberOfFiles == driver.state.numberOfFiles && recorded.totalSize == driver.state.totalSize ) {
+            driver.state.contentHash = ConversionManifest::hashDriverFiles( settings.driverCSVDir, driver.driverId );
+            driver.updateManifest = true;
+            if ( driver.state.contentHash == recorded.contentHash ) driver.status = UnchangedDriver;
+            return;
+        }
+    }
+    
+    // The content hash is taken while parsing, so that the csv files are read once
+    driver.updateManifest = true;
+}
+
+
+// Hands the parsed drivers over to the writers in the order they were enumerated.
+// Parsers may run ahead of the writers by at most a window of drivers.
+class OrderedHandOver {
+public:
+    explicit OrderedHandOver( size_t window ):
+      m_window( window > 0 ? window : 1 ),
+      m_items(),
+      m_next( 0 ),
+      m_total( 0 ),
+      m_totalKnown( false ),
+      m_aborted( false ),
+      m_mutex(),
+      m_condition()
+    {}
+    
+    // Stores the parsed driver with the given sequence number. Returns false if the pipeline was aborted
+    bool put( size_t sequence, std::unique_ptr<DriverConversion> item ) {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        while ( sequence >= m_next + m_window && ! m_aborted ) m_condition.wait( lock );
+        if ( m_aborted ) return false;
+        m_items[sequence] = std::move( item );
+        m_condition.notify_all();
+        return true;
+    }
+    
+    // Takes the next driver in sequence. Returns false when all drivers have been taken or on abort
+    bool take( std::unique_ptr<DriverConversion>& item ) {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        while ( true ) {
+            if ( m_aborted || ( m_totalKnown && m_next == m_total ) ) return false;
+            std::map< size_t, std::unique_ptr<DriverConversion> >::iterator iItem = m_items.find( m_next );
+            if ( iItem != m_items.end() ) {
+                item = std::move( iItem->second );
+                m_items.erase( iItem );
+                ++m_next;
+                m_condition.notify_all();
+                return true;
+            }
+            m_condition.wait( lock );
+        }
+    }
+    
+    // Sets the total number of drivers, once the enumeration has finished
+    void setTotal( size_t total ) {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_total = total;
+        m_totalKnown = true;
+        m_condition.notify_all();
+    }
+    
+    // Stops the pipeline
+    void abort() {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_aborted = true;
+        m_condition.notify_all();
+    }
+    
+private:
+    const size_t m_window;
+    std::map< size_t, std::unique_ptr<DriverConversion> > m_items;
+    size_t m_next;
+    size_t m_total;
+    bool m_totalKnown;
+    bool m_aborted;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+};
+
+
+// Keeps the first error raised in any of the pipeline threads
+class PipelineError {
+public:
+    PipelineError(): m_error(), m_mutex() {}
+    
+    void set( std::exception_ptr error ) {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        if ( ! m_error ) m_error = error;
+    }
+    
+    void rethrow() {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        if ( m_error ) std::rethrow_exception( m_error );
+    }
+    
+private:
+    std::exception_ptr m_error;
+    std::mutex m_mutex;
+};
+
+
+static void enumerationThreadFunction( const ConversionSettings* psettings,
+                                      BoundedQueue< std::pair< size_t, int > >* pdriverQueue,
+                                      OrderedHandOver* phandOver,
+                                      ProcessLogger** plog,
+                                      std::mutex* plogMutex,
+                                      std::condition_variable* plogReady,
+                                      PipelineError* perror )
+{
+    try {
+        DirectoryListing dirList( psettings->driverCSVDir );
+        dirList.setOrdering( DirectoryListing::NumericOrdering );
+        std::list<std::string> driverDirs = dirList.directoryContent();
+        {
+            std::lock_guard<std::mutex> lock( *plogMutex );
+            *plog = new ProcessLogger( driverDirs.size() );
+            plogReady->notify_all();
+        }
         
+        size_t sequence = 0;
         for ( std::list<std::string>::const_iterator iDriverDir = driverDirs.begin();
              iDriverDir != driverDirs.end(); ++iDriverDir ) {
-            
             int driverId = 0;
             std::istringstream isId( *iDriverDir );
             isId >> driverId;
+            if ( ! pdriverQueue->push( std::make_pair( sequence, driverId ) ) ) break;
+            ++sequence;
+        }
+        phandOver->setTotal( sequence );
+    }
+    catch ( ... ) {
+        perror->set( std::current_exception() );
+        phandOver->abort();
+    }
+    pdriverQueue->close();
+}
+
+
+static void parsingThreadFunction( const ConversionSettings* psettings,
+                                  const ConversionManifest* pmanifest,
+                                  BoundedQueue< std::pair< size_t, int > >* pdriverQueue,
+                                  OrderedHandOver* phandOver,
+                                  PipelineError* perror )
+{
+    try {
+        std::pair< size_t, int > driver;
+        while ( pdriverQueue->pop( driver ) ) {
+            std::unique_ptr<DriverConversion> conversion( new DriverConversion( driver.second ) );
+            checkDriver( *psettings, *pmanifest, *conversion );
+            if ( conversion->status != UnchangedDriver && ! psettings->dryRun ) {
+                conversion->data.reset( new DriverTripDataIO( driver.second ) );
+                conversion->data->readTripDataFromCSVFiles( psettings->driverCSVDir );
+                conversion->state.contentHash = conversion->data->contentHash();
+                conversion->numberOfSkippedRows = conversion->data->numberOfSkippedRows();
+            }
+            if ( ! phandOver->put( driver.first, std::move( conversion ) ) ) break;
+        }
+    }
+    catch ( ... ) {
+        perror->set( std::current_exception() );
+        phandOver->abort();
+        pdriverQueue->close();
+    }
+}
+
+
+static void writingThreadFunction( const ConversionSettings* psettings,
+                                  ConversionManifest* pmanifest,
+                                  ConversionReport* preport,
+                                  BoundedQueue< std::pair< size_t, int > >* pdriverQueue,
+                                  OrderedHandOver* phandOver,
+                                  ProcessLogger** plog,
+                                  std::mutex* plogMutex,
+                                  std::condition_variable* plogReady,
+                                  PipelineError* perror )
+{
+    try {
+        std::unique_ptr<DriverConversion> conversion;
+        while ( phandOver->take( conversion ) ) {
+            if ( conversion->data ) {
+                conversion->data->writeDataToBinaryFile( psettings->driverCompressedDir, psettings->format );
+                conversion->data.reset();
+            }
+            if ( conversion->updateManifest && ! psettings->dryRun )
+                pmanifest->update( conversion->driverId, conversion->state );
+            preport->add( *conversion );
+            conversion.reset();
             
-            DriverTripDataIO dataIO( driverId );
-            dataIO.readTripDataFromCSVFiles( driverCSVDir ).writeDataToBinaryFile( driverCompressedDir );
-            
-            log.taskEnded();
+            std::unique_lock<std::mutex> lock( *plogMutex );
+            while ( *plog == 0 ) plogReady->wait( lock );
+            ProcessLogger* log = *plog;
+            lock.unlock();
+            log->taskEnded();
+        }
+    }
+    catch ( ... ) {
+        perror->set( std::current_exception() );
+        phandOver->abort();
+        pdriverQueue->close();
+    }
+}
+
+
+// Usage: readFromCSV [--dry-run] [--full] [numberOfParsingThreads] [numberOfWritingThreads] [queueDepth] [raw|compressed]
+//   --dry-run : only reports which drivers would be converted
+//   --full    : ignores the manifest and converts all drivers
+int main( int argc, char** argv ) {
+    try {
+        ConversionSettings settings;
+        settings.driverCSVDir = "drivers";
+        settings.driverCompressedDir = "drivers_compressed_data";
+        settings.format = DriverTripDataIO::RawFormat;
+        settings.dryRun = false;
+        settings.fullConversion = false;
+        
+        std::vector<std::string> arguments;
+        for ( int i = 1; i < argc; ++i ) {
+            const std::string argument = argv[i];
+            if ( argument == "--dry-run" ) settings.dryRun = true;
+            else if ( argument == "--full" ) settings.fullConversion = true;
+            else arguments.push_back( argument );
+        }
+        
+        int numberOfParsingThreads = std::thread::hardware_concurrency();
+        if ( numberOfParsingThreads < 1 ) numberOfParsingThreads = 6;
+        int numberOfWritingThreads = 2;
+        int queueDepth = 0;
+        if ( arguments.size() > 0 ) numberOfParsingThreads = std::atoi( arguments[0].c_str() );
+        if ( arguments.size() > 1 ) numberOfWritingThreads = std::atoi( arguments[1].c_str() );
+        if ( arguments.size() > 2 ) queueDepth = std::atoi( arguments[2].c_str() );
+        if ( arguments.size() > 3 && arguments[3] == "compressed" ) settings.format = DriverTripDataIO::CompressedFormat;
+        if ( numberOfParsingThreads < 1 ) numberOfParsingThreads = 1;
+        if ( numberOfWritingThreads < 1 ) numberOfWritingThreads = 1;
+        if ( queueDepth < 1 ) queueDepth = 4 * numberOfParsingThreads;
+        
+        ConversionManifest manifest( ConversionManifest::manifestFileName( settings.driverCompressedDir ) );
+        manifest.load();
+        ConversionReport report;
+        
+        // The queue of drivers to parse and the window of parsed drivers waiting to be written
+        BoundedQueue< std::pair< size_t, int > > driverQueue( queueDepth );
+        OrderedHandOver handOver( queueDepth );
+        PipelineError error;
+        
+        // The logger is created once the number of drivers is known
+        ProcessLogger* log = 0;
+        std::mutex logMutex;
+        std::condition_variable logReady;
+        
+        std::vector<std::thread> threads;
+        threads.push_back( std::thread( enumerationThreadFunction, &settings, &driverQueue, &handOver, &log, &logMutex, &logReady, &error ) );
+        for ( int i = 0; i < numberOfParsingThreads; ++i )
+            threads.push_back( std::thread( parsingThreadFunction, &settings, &manifest, &driverQueue, &handOver, &error ) );
+        for ( int i = 0; i < numberOfWritingThreads; ++i )
+            threads.push_back( std::thread( writingThreadFunction, &settings, &manifest, &report, &driverQueue, &handOver, &log, &logMutex, &logReady, &error ) );
+        
+        for ( size_t i = 0; i < threads.size(); ++i ) threads[i].join();
+        
+        delete log;
+        
+        // The drivers whose csv directories have gone. Their binary files are removed, as the data processing
+        // would still load them
+        std::vector<int> recordedDriverIds = manifest.driverIds();
+        size_t numberOfRemovedDrivers = 0;
+        for ( size_t i = 0; i < recordedDriverIds.size(); ++i ) {
+            if ( report.driverIds().count( recordedDriverIds[i] ) > 0 ) continue;
+            ++numberOfRemovedDrivers;
+            if ( settings.dryRun ) continue;
+            std::ostringstream osFileName;
+            osFileName << settings.driverCompressedDir << "/" << recordedDriverIds[i] << ".data";
+            if ( std::remove( osFileName.str().c_str() ) != 0 && errno != ENOENT )
+                throw std::runtime_error( "Could not remove the stale binary file " + osFileName.str() );
+            manifest.remove( recordedDriverIds[i] );
         }
         
+        // The manifest records the drivers written so far, also if the conversion failed
+        if ( ! settings.dryRun ) manifest.save();
+        error.rethrow();
+        report.print( std::cout, settings.dryRun, numberOfRemovedDrivers );
     }
     catch (std::exception& e) {
         std::cerr << e.what() << std::endl;
@@ -0,0 +1,92 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#include "DFTPlan.h"
+
+// Checks the transforms of the DFT plans against a naive DFT in long double precision, for all sizes
+// up to 130 (the powers of two go through the radix-2 path, the other sizes through the direct one)
+// and for a few larger powers of two. The largest difference must stay within a few ulps of the largest bin.
+
+
+// The naive DFT of real values: every bin summed up with freshly computed twiddle factors
+static void naiveDFT( const std::vector<double>& data, std::vector<long double>& real, std::vector<long double>& imaginary )
+{
+    const size_t n = data.size();
+    const long double pi = std::atan( 1.0L ) * 4;
+    real.assign( n / 2 + 1, 0 );
+    imaginary.assign( n / 2 + 1, 0 );
+    for ( size_t k = 0; k <= n / 2; ++k ) {
+        for ( size_t i = 0; i < n; ++i ) {
+            const long double angle = 2 * pi * static_cast<long double>( ( k * i ) % n ) / n;
+            real[k] += data[i] * std::cos( angle );
+            imaginary[k] -= data[i] * std::sin( angle );
+        }
+    }
+}
+
+
+int main( int, char** ) {
+    try {
+        std::mt19937 generator( 5 );
+        std::uniform_real_distribution<double> uniform( -50.0, 50.0 );
+
+        std::vector< size_t > sizes;
+        for ( size_t size = 1; size <= 130; ++size ) sizes.push_back( size );
+        for ( size_t size = 256; size <= 4096; size *= 2 ) sizes.push_back( size );
+
+        long numberOfErrors = 0;
+        double largestRelativeError = 0;
+        for ( std::vector< size_t >::const_iterator iSize = sizes.begin(); iSize != sizes.end(); ++iSize ) {
+            DFTPlan plan( *iSize );
+            if ( plan.numberOfBins() != *iSize / 2 + 1 ) throw std::runtime_error( "Wrong number of bins" );
+
+            std::vector<double> data( *iSize );
+            std::vector<double> real( plan.numberOfBins() ), imaginary( plan.numberOfBins() ), magnitudes( plan.numberOfBins() );
+            std::vector<long double> expectedReal, expectedImaginary;
+            for ( int round = 0; round < 5; ++round ) {
+                for ( size_t i = 0; i < data.size(); ++i ) data[i] = ( round == 0 ? 1 : uniform( generator ) );
+                naiveDFT( data, expectedReal, expectedImaginary );
+                plan.transform( data.data(), real.data(), imaginary.data() );
+                plan.magnitudes( data.data(), magnitudes.data() );
+
+                // The scale of the transform, and the errors relative to it
+                long double scale = 0;
+                for ( size_t k = 0; k < expectedReal.size(); ++k )
+                    scale = std::max( scale, std::sqrt( expectedReal[k] * expectedReal[k] + expectedImaginary[k] * expectedImaginary[k] ) );
+                double error = 0;
+                for ( size_t k = 0; k < expectedReal.size(); ++k ) {
+                    const long double magnitude = std::sqrt( expectedReal[k] * expectedReal[k] + expectedImaginary[k] * expectedImaginary[k] );
+                    error = std::max( error, static_cast<double>( std::fabs( real[k] - expectedReal[k] ) / scale ) );
+                    error = std::max( error, static_cast<double>( std::fabs( imaginary[k] - expectedImaginary[k] ) / scale ) );
+                    error = std::max( error, static_cast<double>( std::fabs( magnitudes[k] - magnitude ) / scale ) );
+                }
+                largestRelativeError = std::max( largestRelativeError, error );
+                if ( ! ( error < 1e-13 ) ) {
+                    std::cerr << "Size " << *iSize << ": relative error " << error << std::endl;
+                    ++numberOfErrors;
+                }
+            }
+        }
+
+        if ( numberOfErrors > 0 ) {
+            std::cerr << numberOfErrors << " transforms differ from the naive DFT" << std::endl;
+            return -1;
+        }
+        std::cout << sizes.size() << " sizes: all transforms agree with the naive DFT, largest relative error "
+                  << largestRelativeError << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "Unknown error" << std::endl;
+        return -1;
+    }
+    return 0;
+}
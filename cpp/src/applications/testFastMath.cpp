@@ -0,0 +1,194 @@
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <limits>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#include "FastMath.h"
+#include "KinematicsKernels.h"
+#include "BenchmarkTools.h"
+
+// Checks the fast mode of the batched math functions against the standard library in long double precision,
+// on values spread over the whole range of doubles, the special values and the ranges of the feature path:
+// the errors must stay within the bounds given in FastMath.h. The exact mode and the square roots must agree
+// with the standard library bit for bit. The directions of the kinematics are checked in both modes.
+// The throughput of both modes is reported.
+
+
+// Returns whether two values are the same, NaN included
+static bool same( double a, double b )
+{
+    return a == b || ( std::isnan( a ) && std::isnan( b ) );
+}
+
+
+// Reports the throughput of a batched function in both modes
+template< typename Function >
+static void reportThroughput( const char* name, Function function, size_t numberOfValues )
+{
+    const double exactTime = bestTime( [&]() { return function( FastMath::Exact ); } );
+    const double fastTime = bestTime( [&]() { return function( FastMath::Fast ); } );
+    std::cout << std::fixed << std::setprecision(3) << "  " << std::setw(5) << name << " : exact "
+              << numberOfValues / exactTime * 1e-9 << " values/ns, fast " << numberOfValues / fastTime * 1e-9
+              << " values/ns, speedup " << std::setprecision(2) << exactTime / fastTime << std::endl;
+}
+
+
+int main( int, char** ) {
+    try {
+        std::mt19937 generator( 11 );
+        std::uniform_real_distribution<double> uniform( 0.0, 1.0 );
+        const double infinity = std::numeric_limits<double>::infinity();
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        long numberOfErrors = 0;
+
+        // The arguments: random signs and magnitudes over all exponents, and the special values
+        const size_t numberOfValues = 1000000;
+        std::vector<double> x( numberOfValues ), y( numberOfValues );
+        for ( size_t i = 0; i < numberOfValues; ++i ) {
+            x[i] = ( uniform( generator ) < 0.5 ? -1 : 1 ) * std::pow( 2.0, -1074 + 2097 * uniform( generator ) );
+            y[i] = ( uniform( generator ) < 0.5 ? -1 : 1 ) * std::pow( 2.0, -1074 + 2097 * uniform( generator ) );
+        }
+        // Close magnitudes, as for the ratios of the directions
+        for ( size_t i = 0; i < numberOfValues / 2; ++i ) y[i] = x[i] * ( 4 * uniform( generator ) - 2 );
+        const double specials[] = { 0.0, -0.0, 1.0, -1.0, DBL_MIN, DBL_MIN / 4, DBL_MAX, -DBL_MAX, infinity, -infinity, nan };
+        const size_t numberOfSpecials = sizeof(specials) / sizeof(specials[0]);
+        for ( size_t i = 0; i < numberOfSpecials; ++i )
+            for ( size_t j = 0; j < numberOfSpecials; ++j ) {
+                x[ numberOfValues - 1 - i * numberOfSpecials - j ] = specials[i];
+                y[ numberOfValues - 1 - i * numberOfSpecials - j ] = specials[j];
+            }
+        std::vector<double> result( numberOfValues ), exactResult( numberOfValues );
+
+        // atan2. The fast mode is checked on finite arguments, with relative errors
+        FastMath::atan2( y.data(), x.data(), numberOfValues, exactResult.data(), FastMath::Exact );
+        FastMath::atan2( y.data(), x.data(), numberOfValues, result.data(), FastMath::Fast );
+        double largestAtan2Error = 0;
+        for ( size_t i = 0; i < numberOfValues; ++i ) {
+            if ( ! same( exactResult[i], std::atan2( y[i], x[i] ) ) ) ++numberOfErrors;
+            if ( ! ( std::isfinite( x[i] ) && std::isfinite( y[i] ) ) ) continue;
+            const long double expected = std::atan2( static_cast<long double>( y[i] ), static_cast<long double>( x[i] ) );
+            // The angles too small for a normal double are relative to the smallest one
+            const double error = expected == 0 ? ( result[i] == 0 && std::signbit( result[i] ) == std::signbit( exactResult[i] ) ? 0 : 1 ) :
+                static_cast<double>( std::fabs( ( result[i] - expected ) / std::max( std::fabs( expected ), static_cast<long double>( DBL_MIN ) ) ) );
+            largestAtan2Error = std::max( largestAtan2Error, error );
+        }
+        if ( ! ( largestAtan2Error < 1e-10 ) ) {
+            std::cerr << "atan2: relative error " << largestAtan2Error << std::endl;
+            ++numberOfErrors;
+        }
+
+        // log10, with the absolute and relative error bounds together. The values near 1 have the smallest logarithms
+        for ( size_t i = 0; i < numberOfValues / 4; ++i ) x[i] = 1 + ( uniform( generator ) - 0.5 ) * std::pow( 2.0, -50 * uniform( generator ) );
+        FastMath::log10( x.data(), numberOfValues, exactResult.data(), FastMath::Exact );
+        FastMath::log10( x.data(), numberOfValues, result.data(), FastMath::Fast );
+        double largestLog10Error = 0;
+        for ( size_t i = 0; i < numberOfValues; ++i ) {
+            if ( ! same( exactResult[i], std::log10( x[i] ) ) ) ++numberOfErrors;
+            if ( ! ( x[i] > 0 && x[i] <= DBL_MAX ) ) {
+                if ( ! same( result[i], exactResult[i] ) ) ++numberOfErrors;
+                continue;
+            }
+            const long double expected = std::log10( static_cast<long double>( x[i] ) );
+            const double error = static_cast<double>( std::fabs( result[i] - expected ) / ( 1e-15 + 1e-13 * std::fabs( expected ) ) );
+            largestLog10Error = std::max( largestLog10Error, error );
+        }
+        if ( ! ( largestLog10Error <= 1 ) ) {
+            std::cerr << "log10: error " << largestLog10Error << " of the bound" << std::endl;
+            ++numberOfErrors;
+        }
+
+        // sqrt, exact in both modes
+        for ( int mode = FastMath::Exact; mode <= FastMath::Fast; ++mode ) {
+            FastMath::sqrt( x.data(), numberOfValues, result.data(), static_cast<FastMath::Mode>( mode ) );
+            for ( size_t i = 0; i < numberOfValues; ++i )
+                if ( ! same( result[i], std::sqrt( x[i] ) ) ) ++numberOfErrors;
+        }
+
+        // The directions of velocity vectors on the grid of the trip data, with stops and reversals
+        const size_t numberOfVectors = 100000;
+        std::vector<float> vx( numberOfVectors ), vy( numberOfVectors );
+        for ( size_t i = 0; i < numberOfVectors; ++i ) {
+            const double event = uniform( generator );
+            if ( event < 0.02 ) vx[i] = vy[i] = 0;
+            else if ( event < 0.04 && i > 0 ) {
+                vx[i] = -vx[i-1];
+                vy[i] = -vy[i-1];
+            }
+            else {
+                vx[i] = static_cast<float>( std::round( 300 * ( uniform( generator ) - 0.5 ) ) / 10 );
+                vy[i] = static_cast<float>( std::round( 300 * ( uniform( generator ) - 0.5 ) ) / 10 );
+            }
+        }
+        const KinematicsKernels& kernels = KinematicsKernels::best();
+        std::vector<double> speed( numberOfVectors ), exactDirection( numberOfVectors - 1 ), fastDirection( numberOfVectors - 1 );
+        kernels.speed( vx.data(), vy.data(), numberOfVectors, speed.data() );
+        kernels.direction( vx.data(), vy.data(), speed.data(), numberOfVectors, exactDirection.data() );
+        FastMath::setMode( FastMath::Fast );
+        kernels.direction( vx.data(), vy.data(), speed.data(), numberOfVectors, fastDirection.data() );
+        FastMath::setMode( FastMath::Exact );
+        // Both against the angles in long double precision, up to full turns, as the reversals are -pi in both modes.
+        // The exact mode takes the arc sine of the sine ratio up to right angles, where it amplifies the rounding of the ratio
+        const long double fullTurn = 2 * std::atan2( 0.0L, -1.0L );
+        double largestExactDirectionError = 0, largestFastDirectionError = 0;
+        for ( size_t i = 0; i < exactDirection.size(); ++i ) {
+            if ( ( exactDirection[i] == 0 ) != ( fastDirection[i] == 0 ) || ( exactDirection[i] < 0 ) != ( fastDirection[i] < 0 ) ) ++numberOfErrors;
+            const long double x1 = vx[i+1], y1 = vy[i+1], x2 = vx[i], y2 = vy[i];
+            const long double expected = ( speed[i] == 0 || speed[i+1] == 0 ) ? 0 : std::atan2( x1 * y2 - y1 * x2, x1 * x2 + y1 * y2 );
+            const long double exactError = std::fabs( exactDirection[i] - expected );
+            const long double fastError = std::fabs( fastDirection[i] - expected );
+            largestExactDirectionError = std::max( largestExactDirectionError, static_cast<double>( std::min( exactError, fullTurn - exactError ) ) );
+            largestFastDirectionError = std::max( largestFastDirectionError, static_cast<double>( std::min( fastError, fullTurn - fastError ) ) );
+        }
+        if ( ! ( largestFastDirectionError < 1e-6 ) ) {
+            std::cerr << "Directions: error " << largestFastDirectionError << std::endl;
+            ++numberOfErrors;
+        }
+
+        if ( numberOfErrors > 0 ) {
+            std::cerr << numberOfErrors << " results are off" << std::endl;
+            return -1;
+        }
+        std::cout << std::scientific << std::setprecision(2);
+        std::cout << "All results within the bounds: atan2 relative error " << largestAtan2Error
+                  << ", log10 error " << largestLog10Error << " of the bound" << std::endl;
+        std::cout << "Largest error of the directions: exact mode " << largestExactDirectionError << " rad, fast mode "
+                  << largestFastDirectionError << " rad" << std::endl;
+
+        // The throughput on blocks of the size of the direction kernels
+        const size_t blockSize = 256;
+        std::vector<double> block( blockSize );
+        std::cout << "Throughput on blocks of " << blockSize << " values:" << std::endl;
+        reportThroughput( "atan2", [&]( FastMath::Mode mode ) {
+                for ( size_t i = 0; i + blockSize <= numberOfValues / 2; i += blockSize )
+                    FastMath::atan2( y.data() + i, x.data() + i, blockSize, block.data(), mode );
+                return block[0]; }, numberOfValues / 2 );
+        reportThroughput( "log10", [&]( FastMath::Mode mode ) {
+                for ( size_t i = 0; i + blockSize <= numberOfValues; i += blockSize )
+                    FastMath::log10( x.data() + i, blockSize, block.data(), mode );
+                return block[0]; }, numberOfValues );
+        reportThroughput( "sqrt", [&]( FastMath::Mode mode ) {
+                for ( size_t i = 0; i + blockSize <= numberOfValues; i += blockSize )
+                    FastMath::sqrt( x.data() + i, blockSize, block.data(), mode );
+                return block[0]; }, numberOfValues );
+        reportThroughput( "angle", [&]( FastMath::Mode mode ) {
+                FastMath::setMode( mode );
+                kernels.direction( vx.data(), vy.data(), speed.data(), numberOfVectors, fastDirection.data() );
+                FastMath::setMode( FastMath::Exact );
+                return fastDirection[0]; }, numberOfVectors );
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "Unknown error" << std::endl;
+        return -1;
+    }
+    return 0;
+}
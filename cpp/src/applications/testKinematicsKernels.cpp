@@ -0,0 +1,118 @@
+#include <iostream>
+#include <random>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+#include "KinematicsKernels.h"
+#include "Utilities.h"
+
+// Checks the kinematics kernels of every instruction set supported by the processor against the formulas
+// the segments used before the kernels: the speed from std::pow and std::sqrt per velocity vector and the
+// direction from angleAmongVectors. The results must be the same bit for bit. The velocity vectors include
+// stops, repeated vectors and reversals, and the lengths cover the scalar tails of all vector widths.
+
+
+// Random velocity vectors with stops, repeated vectors and reversals
+static void randomVelocities( std::mt19937& generator, size_t n, std::vector<float>& vx, std::vector<float>& vy )
+{
+    std::uniform_real_distribution<double> uniform( 0.0, 1.0 );
+    vx.resize( n );
+    vy.resize( n );
+    for ( size_t i = 0; i < n; ++i ) {
+        const double event = uniform( generator );
+        if ( event < 0.1 ) {
+            vx[i] = 0;
+            vy[i] = 0;
+        }
+        else if ( event < 0.15 && i > 0 ) {
+            vx[i] = vx[i-1];
+            vy[i] = vy[i-1];
+        }
+        else if ( event < 0.2 && i > 0 ) {
+            vx[i] = -vx[i-1];
+            vy[i] = -vy[i-1];
+        }
+        else {
+            vx[i] = static_cast<float>( 60 * ( uniform( generator ) - 0.5 ) );
+            vy[i] = static_cast<float>( 60 * ( uniform( generator ) - 0.5 ) );
+        }
+    }
+}
+
+
+// Returns true if the values are the same bit for bit
+static bool sameBits( const std::vector<double>& v1, const std::vector<double>& v2 )
+{
+    return v1.size() == v2.size() && std::memcmp( v1.data(), v2.data(), v1.size() * sizeof(double) ) == 0;
+}
+
+
+int main( int, char** ) {
+    try {
+        const KinematicsKernels::InstructionSet instructionSets[] = { KinematicsKernels::Scalar,
+                                                                      KinematicsKernels::SSE2,
+                                                                      KinematicsKernels::AVX2,
+                                                                      KinematicsKernels::AVX512 };
+        std::mt19937 generator( 11 );
+        std::vector<float> vx, vy;
+        long numberOfErrors = 0;
+        int numberOfInstructionSets = 0;
+
+        for ( size_t k = 0; k < sizeof(instructionSets) / sizeof(instructionSets[0]); ++k ) {
+            if ( ! KinematicsKernels::isSupported( instructionSets[k] ) ) {
+                std::cout << KinematicsKernels::name( instructionSets[k] ) << " : not supported" << std::endl;
+                continue;
+            }
+            const KinematicsKernels& kernels = KinematicsKernels::forInstructionSet( instructionSets[k] );
+            ++numberOfInstructionSets;
+            long errors = 0;
+
+            for ( size_t n = 1; n < 2000; n += ( n < 80 ? 1 : 97 ) ) {
+                randomVelocities( generator, n, vx, vy );
+
+                // The reference values
+                std::vector<double> speed, acceleration, speedXacceleration, direction;
+                for ( size_t i = 0; i < n; ++i )
+                    speed.push_back( std::sqrt( std::pow(vx[i],2) + std::pow(vy[i], 2) ) );
+                for ( size_t i = 1; i < n; ++i ) {
+                    acceleration.push_back( speed[i] - speed[i-1] );
+                    speedXacceleration.push_back( speed[i] * acceleration.back() );
+                    direction.push_back( angleAmongVectors( std::make_pair( vx[i], vy[i] ), std::make_pair( vx[i-1], vy[i-1] ) ) );
+                }
+
+                std::vector<double> kernelSpeed( n ), kernelAcceleration( n - 1 ), kernelSpeedXacceleration( n - 1 ), kernelDirection( n - 1 );
+                kernels.speed( vx.data(), vy.data(), n, kernelSpeed.data() );
+                kernels.acceleration( kernelSpeed.data(), n, kernelAcceleration.data(), kernelSpeedXacceleration.data() );
+                kernels.direction( vx.data(), vy.data(), kernelSpeed.data(), n, kernelDirection.data() );
+
+                if ( ! sameBits( speed, kernelSpeed ) ) ++errors;
+                if ( ! sameBits( acceleration, kernelAcceleration ) ) ++errors;
+                if ( ! sameBits( speedXacceleration, kernelSpeedXacceleration ) ) ++errors;
+                if ( ! sameBits( direction, kernelDirection ) ) ++errors;
+            }
+
+            std::cout << KinematicsKernels::name( instructionSets[k] ) << " : "
+                      << ( errors == 0 ? "identical" : "DIFFERENT" ) << std::endl;
+            numberOfErrors += errors;
+        }
+
+        std::cout << "Best : " << KinematicsKernels::name( KinematicsKernels::best().instructionSet() ) << std::endl;
+        if ( numberOfErrors > 0 ) {
+            std::cerr << numberOfErrors << " kernel results differ from the reference values" << std::endl;
+            return -1;
+        }
+        std::cout << numberOfInstructionSets << " instruction sets: all results identical" << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "Unknown error" << std::endl;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <cmath>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#include "Driver.h"
+#include "BenchmarkTools.h"
+
+// Calls the accessors of the same trips from many threads at once, starting before any segments exist,
+// and checks the results against a single threaded run. Build it with -fsanitize=thread (make tsan) to
+// have the lazy initialisation checked for data races.
+
+
+// Returns true if the values are the same, NaN included
+static bool sameValues( const std::vector<double>& v1, const std::vector<double>& v2 )
+{
+    if ( v1.size() != v2.size() ) return false;
+    for ( size_t i = 0; i < v1.size(); ++i )
+        if ( v1[i] != v2[i] && ! ( std::isnan( v1[i] ) && std::isnan( v2[i] ) ) ) return false;
+    return true;
+}
+
+
+// Reads all trips of the driver, starting from a different trip in every thread
+static void readTrips( const Driver* driver,
+                       const Driver* reference,
+                       size_t firstTrip,
+                       std::atomic<bool>* start,
+                       std::atomic<long>* numberOfErrors )
+{
+    while ( ! start->load() ) std::this_thread::yield();
+
+    const std::vector< Trip >& trips = driver->trips();
+    const std::vector< Trip >& expectedTrips = reference->trips();
+    for ( size_t j = 0; j < trips.size(); ++j ) {
+        const size_t i = ( firstTrip + j ) % trips.size();
+        const Trip& trip = trips[i];
+        const Trip& expected = expectedTrips[i];
+        bool correct = ( trip.numberOfSegments() == expected.numberOfSegments() &&
+                         trip.travelDuration() == expected.travelDuration() &&
+                         trip.travelLength() == expected.travelLength() &&
+                         sameValues( trip.speedValues(), expected.speedValues() ) &&
+                         sameValues( trip.metrics().values(), expected.metrics().values() ) );
+        if ( ! correct ) ++(*numberOfErrors);
+    }
+}
+
+
+int main( int, char** ) {
+    try {
+        const int numberOfTrips = 50;
+        const int numberOfThreads = 16;
+        const int numberOfRounds = 5;
+
+        // A synthetic driver with stops, gaps and sharp turns
+        SyntheticTripParameters parameters;
+        parameters.seed = 7;
+        parameters.minimumLength = 100;
+        parameters.maximumLength = 1200;
+        parameters.stopRate = 20;
+        parameters.gapRate = 10;
+        parameters.turnRate = 20;
+        const std::vector< std::pair< int, std::vector< std::pair<float,float> > > > tripData = syntheticTrips( numberOfTrips, parameters );
+        Driver reference( 1 );
+        reference.loadTripData( tripData );
+        for ( size_t i = 0; i < reference.trips().size(); ++i ) reference.trips()[i].prepare();
+
+        long numberOfErrors = 0;
+        for ( int round = 0; round < numberOfRounds; ++round ) {
+            // Fresh trips, so that the threads race for the segmentation
+            Driver driver( 1 );
+            driver.loadTripData( tripData );
+
+            std::atomic<bool> start( false );
+            std::atomic<long> errors( 0 );
+            std::vector< std::thread > threads;
+            for ( int i = 0; i < numberOfThreads; ++i )
+                threads.push_back( std::thread( readTrips, &driver, &reference, static_cast<size_t>( i % 2 ) * numberOfTrips / 2, &start, &errors ) );
+            start.store( true );
+            for ( std::vector< std::thread >::iterator iThread = threads.begin(); iThread != threads.end(); ++iThread )
+                iThread->join();
+            numberOfErrors += errors.load();
+        }
+
+        if ( numberOfErrors > 0 ) {
+            std::cerr << numberOfErrors << " trip reads differ from the single threaded results" << std::endl;
+            return -1;
+        }
+        std::cout << numberOfRounds << " rounds of " << numberOfThreads << " threads reading "
+                  << numberOfTrips << " trips: all results identical" << std::endl;
+    }
+    catch (std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return -1;
+    }
+    catch (...) {
+        std::cerr << "Unknown error" << std::endl;
+        return -1;
+    }
+    return 0;
+}
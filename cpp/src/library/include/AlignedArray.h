@@ -0,0 +1,86 @@
+#ifndef ALIGNEDARRAY_H
+#define ALIGNEDARRAY_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <algorithm>
+
+// Fixed size array of plain values on cache line aligned memory.
+// The allocation is padded to a whole number of cache lines and the values are zero initialised,
+// so that vectorised loops may run over the padding.
+template< typename T >
+class AlignedArray {
+public:
+    // The alignment in bytes
+    static const size_t alignment = 64;
+
+    // The number of values in an aligned block
+    static const size_t valuesPerBlock = alignment / sizeof(T);
+
+    // Returns the size rounded up to a whole number of aligned blocks
+    static inline size_t paddedSize( size_t size ) { return ( size + valuesPerBlock - 1 ) / valuesPerBlock * valuesPerBlock; }
+
+    // Constructor
+    explicit AlignedArray( size_t size = 0 ): m_data( 0 ), m_size( 0 ) { this->allocate( size ); }
+
+    // Copy constructor and assignment copy the values
+    AlignedArray( const AlignedArray& rhs ): m_data( 0 ), m_size( 0 ) {
+        this->allocate( rhs.m_size );
+        if ( m_size > 0 ) std::memcpy( m_data, rhs.m_data, paddedSize( m_size ) * sizeof(T) );
+    }
+
+    AlignedArray& operator=( const AlignedArray& rhs ) {
+        AlignedArray copy( rhs );
+        this->swap( copy );
+        return *this;
+    }
+
+    // Move constructor and assignment take over the memory
+    AlignedArray( AlignedArray&& rhs ) noexcept: m_data( rhs.m_data ), m_size( rhs.m_size ) {
+        rhs.m_data = 0;
+        rhs.m_size = 0;
+    }
+
+    AlignedArray& operator=( AlignedArray&& rhs ) noexcept {
+        this->swap( rhs );
+        return *this;
+    }
+
+    // Destructor
+    ~AlignedArray() { std::free( m_data ); }
+
+    inline void swap( AlignedArray& rhs ) noexcept {
+        std::swap( m_data, rhs.m_data );
+        std::swap( m_size, rhs.m_size );
+    }
+
+    // The number of values, without the padding
+    inline size_t size() const { return m_size; }
+    inline bool empty() const { return m_size == 0; }
+
+    // The allocated memory in bytes
+    inline size_t memoryUsage() const { return paddedSize( m_size ) * sizeof(T); }
+
+    // Element access
+    inline T* data() { return m_data; }
+    inline const T* data() const { return m_data; }
+    inline T& operator[]( size_t i ) { return m_data[i]; }
+    inline const T& operator[]( size_t i ) const { return m_data[i]; }
+
+private:
+    void allocate( size_t size ) {
+        if ( size == 0 ) return;
+        void* memory = 0;
+        if ( posix_memalign( &memory, alignment, paddedSize( size ) * sizeof(T) ) != 0 ) throw std::bad_alloc();
+        std::memset( memory, 0, paddedSize( size ) * sizeof(T) );
+        m_data = static_cast<T*>( memory );
+        m_size = size;
+    }
+
+    T* m_data;
+    size_t m_size;
+};
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+// A blocking first-in first-out queue with a maximum size, for connecting the stages of a pipeline.
+// Producers block while the queue is full, consumers block while it is empty and not closed.
+template< typename T >
+class BoundedQueue {
+public:
+    // Constructor
+    explicit BoundedQueue( size_t capacity ):
+      m_capacity( capacity > 0 ? capacity : 1 ),
+      m_items(),
+      m_closed( false ),
+      m_mutex(),
+      m_notEmpty(),
+      m_notFull()
+    {}
+    
+    // Adds an item, waiting for space. Returns false if the queue has been closed
+    bool push( T item ) {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        while ( m_items.size() >= m_capacity && ! m_closed ) m_notFull.wait( lock );
+        if ( m_closed ) return false;
+        m_items.push_back( std::move( item ) );
+        m_notEmpty.notify_one();
+        return true;
+    }
+    
+    // Removes the oldest item, waiting for one. Returns false once the queue is closed and drained
+    bool pop( T& item ) {
+        std::unique_lock<std::mutex> lock( m_mutex );
+        while ( m_items.empty() && ! m_closed ) m_notEmpty.wait( lock );
+        if ( m_items.empty() ) return false;
+        item = std::move( m_items.front() );
+        m_items.pop_front();
+        m_notFull.notify_one();
+        return true;
+    }
+    
+    // Signals that no more items will be pushed. Waiting consumers drain the remaining items
+    void close() {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_closed = true;
+        m_notEmpty.notify_all();
+        m_notFull.notify_all();
+    }
+    
+private:
+    // No copying
+    BoundedQueue( const BoundedQueue& );
+    BoundedQueue& operator=( const BoundedQueue& );
+    
+    // The maximum number of items
+    const size_t m_capacity;
+    
+    // The items
+    std::deque< T > m_items;
+    
+    // Flags that no more items will be pushed
+    bool m_closed;
+    
+    // The synchronisation
+    std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+};
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+// Returns the CRC32C (Castagnoli) checksum of the data, continuing from a previous checksum.
+// Uses the SSE4.2 or ARMv8 crc32 instructions when the processor has them.
+uint32_t crc32c( const void* data, size_t size, uint32_t crc = 0 );
+
+// Appends a trailer holding the checksum of the buffer content: the crc32c followed by an 8 byte tag
+void appendChecksumTrailer( std::vector<char>& buffer );
+
+// Returns the size of the data without the checksum trailer, after verifying the checksum.
+// Throws if the checksum does not match, or if the trailer is required and missing, as after a truncation.
+// Data without a trailer are returned unchecked if it is not required
+size_t verifyChecksumTrailer( const char* data, size_t size, bool trailerRequired );
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef CONVERSIONMANIFEST_H
+#define CONVERSIONMANIFEST_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <stdint.h>
+
+// The state of the csv files of a driver when it was converted
+struct DriverSourceState {
+    DriverSourceState();
+
+    // Returns true if the number of files, their total size and the latest modification time are the same
+    bool sameFiles( const DriverSourceState& rhs ) const;
+
+    unsigned long numberOfFiles;
+    unsigned long long totalSize;
+    long long lastModification;   // In seconds since the epoch
+    uint32_t contentHash;         // The crc32c of the file names and contents
+    int format;                   // The binary format the driver was written in
+};
+
+
+// Records which drivers have been converted from csv to binary files, so that a conversion
+// only needs to process the drivers that are new or whose csv files have changed.
+// The manifest is a text file with one line per driver. All methods are thread safe.
+class ConversionManifest {
+public:
+    // Constructor. Nothing is read until load is called
+    explicit ConversionManifest( const std::string& fileName );
+
+    // Destructor
+    ~ConversionManifest();
+
+    // Returns the manifest file name for an output directory. It is kept next to the directory
+    static std::string manifestFileName( const std::string& outputDirectory );
+
+    // Loads the manifest. A missing file gives an empty manifest
+    ConversionManifest& load();
+
+    // Saves the manifest, replacing the file atomically
+    const ConversionManifest& save() const;
+
+    // Looks up the recorded state of a driver. Returns false if the driver is not in the manifest
+    bool find( int driverId, DriverSourceState& state ) const;
+
+    // Records the state of a converted driver
+    ConversionManifest& update( int driverId, const DriverSourceState& state );
+
+    // Removes a driver from the manifest
+    ConversionManifest& remove( int driverId );
+
+    // Returns the ids of all recorded drivers
+    std::vector<int> driverIds() const;
+
+    // Collects the number, total size and latest modification time of the csv files of a driver
+    static DriverSourceState scanDriverFiles( const std::string& driverDirectoryName, int driverId );
+
+    // Returns the hash of the names and contents of the csv files of a driver
+    static uint32_t hashDriverFiles( const std::string& driverDirectoryName, int driverId );
+
+private:
+    // No copying
+    ConversionManifest( const ConversionManifest& );
+    ConversionManifest& operator=( const ConversionManifest& );
+
+    // The manifest file
+    std::string m_fileName;
+
+    // The states by driver id
+    std::map< int, DriverSourceState > m_entries;
+
+    mutable std::mutex m_mutex;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef DFTPLAN_H
+#define DFTPLAN_H
+
+#include <vector>
+#include <cstddef>
+
+// The discrete Fourier transform of a fixed number of real values. The twiddle factors are tabulated
+// when the plan is made. Powers of two go through an iterative radix-2 FFT of half the size, with the
+// real values packed in pairs into complex ones; any other size is transformed directly, which is
+// the faster way for the small windows of the trip metrics.
+//
+// A plan keeps its scratch buffers, so transforms allocate nothing. A plan is used by one thread at a time.
+class DFTPlan {
+public:
+    // Constructor. Throws if the size is zero
+    explicit DFTPlan( size_t size );
+
+    // Destructor
+    ~DFTPlan();
+
+    // The number of real values transformed
+    inline size_t size() const { return m_size; }
+
+    // The number of bins from the zero frequency to the Nyquist frequency, size() / 2 + 1
+    inline size_t numberOfBins() const { return m_size / 2 + 1; }
+
+    // Computes the real and imaginary parts of the numberOfBins() first bins of the transform of size() values
+    void transform( const double* data, double* real, double* imaginary );
+
+    // Computes the magnitudes of the numberOfBins() first bins of the transform of size() values
+    void magnitudes( const double* data, double* magnitudes );
+
+private:
+    // No copying
+    DFTPlan( const DFTPlan& );
+    DFTPlan& operator=( const DFTPlan& );
+
+    // The direct transform, for any size
+    void directTransform( const double* data, double* real, double* imaginary ) const;
+
+    // The packed radix-2 transform, for the powers of two
+    void radix2Transform( const double* data, double* real, double* imaginary );
+
+    // The number of values
+    size_t m_size;
+
+    // Whether the size is a power of two
+    bool m_powerOfTwo;
+
+    // cos( 2 pi k / size ) and sin( 2 pi k / size ) for k in [0, size)
+    std::vector< double > m_cos;
+    std::vector< double > m_sin;
+
+    // The bit reversal permutation of the half size radix-2 transform
+    std::vector< size_t > m_bitReversal;
+
+    // The scratch buffers of the radix-2 transform and of the magnitudes
+    std::vector< double > m_real;
+    std::vector< double > m_imaginary;
+    std::vector< double > m_binsReal;
+    std::vector< double > m_binsImaginary;
+};
+
+#endif
@@ -3,17 +3,61 @@
 
 #include <string>
 #include <list>
+#include <memory>
+#include <iterator>
+#include <dirent.h>
 
+// Lists the entries of a directory, skipping the hidden ones
 class DirectoryListing {
 public:
+    // The orderings of the listed entries
+    enum Ordering {
+        NoOrdering,       // As returned by the file system
+        NameOrdering,     // Lexicographically by name, as ls does
+        NumericOrdering   // By the number the name starts with, e.g. driver and trip ids
+    };
+    
+    // Streams the entries of the directory without building a list. The order is the file system order
+    class const_iterator : public std::iterator< std::input_iterator_tag, std::string > {
+    public:
+        const_iterator();
+        const_iterator( const std::string& directory, const std::string& extension );
+        
+        inline const std::string& operator*() const { return m_entry; }
+        inline const std::string* operator->() const { return &m_entry; }
+        const_iterator& operator++();
+        inline bool operator==( const const_iterator& rhs ) const { return m_directory == rhs.m_directory; }
+        inline bool operator!=( const const_iterator& rhs ) const { return m_directory != rhs.m_directory; }
+        
+    private:
+        // Moves to the next entry passing the filter, releasing the directory at the end
+        void advance();
+        
+        std::shared_ptr< DIR > m_directory;
+        std::string m_extension;
+        std::string m_entry;
+    };
+    
     DirectoryListing( std::string targetDirectory = "." );
     
     DirectoryListing& setWorkingDirectory( const std::string& cwd );
     
+    // Restricts the listing to the names ending with the extension, e.g. ".data". An empty extension lists everything
+    DirectoryListing& setExtensionFilter( const std::string& extension );
+    
+    // Sets the ordering of directoryContent. The default is NameOrdering
+    DirectoryListing& setOrdering( Ordering ordering );
+    
     std::list<std::string> directoryContent() const;
+    
+    // The streaming interface
+    const_iterator begin() const;
+    const_iterator end() const;
 
 private:
     std::string m_currentDirectory;
+    std::string m_extension;
+    Ordering m_ordering;
 };
 
 #endif
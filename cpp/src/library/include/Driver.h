@@ -2,27 +2,47 @@
 #define DRIVER_H
 
 #include <string>
+#include <memory>
 #include "Trip.h"
+#include "TripStore.h"
+#include "FeatureMatrix.h"
+
+class DriverTripDataMap;
 
 class Driver {
 public:
     // Constructor
     explicit Driver( int driverId = 0 );
     
+    // Drivers are not copyable, since their trips are not, but can be moved
+    Driver( const Driver& rhs ) = delete;
+    Driver& operator=( const Driver& rhs ) = delete;
+    Driver( Driver&& rhs ) noexcept;
+    Driver& operator=( Driver&& rhs ) noexcept;
+    
     // Destructor
     virtual ~Driver();
     
     // Returns the trip id
     inline int id() const { return m_driverId; }
     
-    // Creates trip objects from data
+    // Creates trip objects from data. The data are copied into the trip store of the driver
     Driver& loadTripData( const std::vector< std::pair< int, std::vector< std::pair<float,float> > > >& tripData );
     
+    // Creates trip objects from mapped data. The trip store views the coordinates of the mapped data and keeps them alive
+    Driver& loadTripData( const std::shared_ptr< const DriverTripDataMap >& mappedData );
+    
+    // Returns the store holding the coordinates of all trips
+    inline const std::shared_ptr< const TripStore >& tripStore() const { return m_tripStore; }
+    
     // Returns the trip objects
     inline const std::vector< Trip >& trips() const { return m_trips; }
 
     // Returns the trip metrics
-    std::vector< TripMetrics > tripMetrics() const;
+    FeatureMatrix tripMetrics() const;
+    
+    // Appends the trip metrics to a matrix
+    const Driver& appendTripMetrics( FeatureMatrix& output ) const;
 
     // Operator for searching in a vector
     inline bool operator==( const Driver& rhs ) const { return this->id() == rhs.id(); }
@@ -35,6 +55,8 @@ private:
     // The trip objects
     std::vector< Trip > m_trips;
     
+    // The coordinates of the trips, viewed by the trip objects
+    std::shared_ptr< const TripStore > m_tripStore;
 };
 
 #endif
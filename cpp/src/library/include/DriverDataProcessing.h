@@ -4,8 +4,9 @@
 #include <string>
 #include <memory>
 #include <tuple>
-#include "Driver.h"
-#include "TripMetrics.h"
+#include "Fleet.h"
+#include "FeatureMatrix.h"
+#include "DriverFileBatchLoader.h"
 
 class DriverDataProcessing
 {
@@ -15,12 +16,19 @@ class DriverDataProcessing
     
     // Destructor
     virtual ~DriverDataProcessing();
+    
+    // Sets how many drivers are read ahead of the worker threads and by how many I/O threads.
+    // A depth of 0 lets every worker read its drivers itself
+    DriverDataProcessing& setReadAhead( int depth, int numberOfIOThreads = 2 );
+    
+    // Sets how the I/O threads load the driver files. The default is IOUring where available
+    DriverDataProcessing& setFileLoading( DriverFileBatchLoader::Backend backend );
 
-    // Loads all the trip data in memory
-    std::vector< std::auto_ptr<Driver> > loadAllData( int numberOfThreads = 6 ) const;
+    // Loads all the trip data in memory, indexed by driver and trip id
+    Fleet loadAllData( int numberOfThreads = 6 ) const;
 
     // Produces the trip metrics for all trivers and trips. Returns the number of drivers
-    size_t produceTripMetrics( std::vector< TripMetrics >& outputData,
+    size_t produceTripMetrics( FeatureMatrix& outputData,
                               int numberOfThreads = 6 ) const;
 
     // Calculates the trip scores by comparing driver metrics against population metrics
@@ -30,6 +38,13 @@ class DriverDataProcessing
  private:
     // The driver directory containing the trip data files
     std::string m_driversDirectory;
+    
+    // The number of drivers read ahead and the number of threads reading them
+    int m_readAheadDepth;
+    int m_numberOfIOThreads;
+    
+    // How the read ahead driver files are loaded
+    DriverFileBatchLoader::Backend m_fileLoading;
 };
 
 #endif
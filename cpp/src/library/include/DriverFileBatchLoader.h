@@ -0,0 +1,64 @@
+#ifndef DRIVERFILEBATCHLOADER_H
+#define DRIVERFILEBATCHLOADER_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <exception>
+
+#include "DriverTripDataMap.h"
+
+// Loads the binary files of batches of drivers.
+// On Linux the files are opened, sized, read and closed through io_uring, submitting the requests for
+// a whole batch with a few system calls. Where io_uring is not available, or with the MemoryMapping
+// backend, every file is mapped with DriverTripDataMap::mapBinaryFile.
+// An object is meant to be used by one thread at a time.
+class DriverFileBatchLoader {
+public:
+    // The ways of loading the files
+    enum Backend {
+        MemoryMapping,   // One mmap per file
+        IOUring          // Batched io_uring requests, falling back to MemoryMapping
+    };
+    
+    // The outcome of loading one driver file: the data, or the error raised
+    struct LoadedDriver {
+        std::shared_ptr< DriverTripDataMap > data;
+        std::exception_ptr error;
+    };
+    
+    // Constructor. The batch size bounds the number of files in flight
+    explicit DriverFileBatchLoader( Backend backend = IOUring, unsigned int batchSize = 32 );
+    
+    // Destructor
+    ~DriverFileBatchLoader();
+    
+    // Returns the backend actually used
+    Backend backend() const;
+    
+    // Returns the maximum number of files loaded per batch
+    inline unsigned int batchSize() const { return m_batchSize; }
+    
+    // Loads the binary files of the drivers. The results are in the order of the ids, and the errors,
+    // including the failure of a whole batch, are reported per driver
+    std::vector< LoadedDriver > load( const std::string& driverDirectoryName,
+                                      const std::vector<int>& driverIds );
+
+private:
+    // No copying
+    DriverFileBatchLoader( const DriverFileBatchLoader& );
+    DriverFileBatchLoader& operator=( const DriverFileBatchLoader& );
+    
+    // Loads one batch through the ring
+    void loadBatch( const std::string& driverDirectoryName,
+                    const int* driverIds, unsigned int numberOfDrivers,
+                    LoadedDriver* results );
+    
+    // The io_uring submission and completion queues, or 0 if not used
+    class Ring;
+    Ring* m_ring;
+    
+    unsigned int m_batchSize;
+};
+
+#endif
@@ -4,9 +4,22 @@
 #include <string>
 #include <vector>
 #include <utility>
+#include <stdint.h>
 
 class DriverTripDataIO {
 public:
+    // The ways of parsing the csv files
+    enum CSVParsing {
+        StreamParsing,   // Line by line through std::istringstream
+        FastParsing      // Whole file in one read with a locale-free number parser
+    };
+    
+    // The binary file formats
+    enum BinaryFormat {
+        RawFormat,        // Native floats
+        CompressedFormat  // Quantised, delta encoded and bit-packed (see TripDataCompression.h)
+    };
+    
     // Constructor
     explicit DriverTripDataIO( int driverId = 0 );
     
@@ -16,18 +29,43 @@ public:
     // Returns the driver id
     inline int id() const { return m_driverId; }
     
-    // Read raw data from the csv files
-    DriverTripDataIO& readTripDataFromCSVFiles( const std::string& driverDirectoryName );
+    // Read raw data from the csv files. The rows without a valid point are skipped in both parsing modes
+    DriverTripDataIO& readTripDataFromCSVFiles( const std::string& driverDirectoryName,
+                                                CSVParsing parsing = FastParsing );
     
     // Write raw data to binary file
-    const DriverTripDataIO& writeDataToBinaryFile( const std::string& driverDirectoryName ) const;
+    const DriverTripDataIO& writeDataToBinaryFile( const std::string& driverDirectoryName,
+                                                   BinaryFormat format = RawFormat ) const;
     
-    // Reads raw data from a binary file
+    // Reads raw data from a binary file. The format is detected from the file content
     DriverTripDataIO& readDataFromBinaryFile( const std::string& driverDirectoryName );
     
+    // The version of the raw binary files written
+    static const uint32_t rawVersion = 2;
+    
+    // Raw binary files start with a signature and a format version. Version 2 holds the driver id, the number of trips,
+    // the number of stored values and for every trip its id, a reserved int and its number of points. From the next
+    // multiple of 64 bytes follow the x values of all trips, then their y values, every trip padded with zeros to a
+    // multiple of 64 bytes as in TripStore. Version 1 holds the driver id, the number of trips and for every trip its id,
+    // number of points and points. The files written before the version start with the driver id.
+    // Returns the version of the content of a raw file, 0 for the files without one, and sets the offset of the driver id.
+    // Throws if the version is not supported
+    static uint32_t rawDataVersion( const char* data, size_t size, size_t& offset );
+    
+    // Verifies the checksum trailer of the content of a binary file and returns the size without it.
+    // The files with a format version must end with the trailer; the older files are checked if they have one
+    static size_t verifyChecksum( const char* data, size_t size );
+    
     inline const std::vector< std::pair< int, std::vector< std::pair<float,float> > > >& rawData() const {
         return m_rawData;
     }
+    
+    // The number of csv rows skipped by the last reading of the csv files
+    inline size_t numberOfSkippedRows() const { return m_numberOfSkippedRows; }
+    
+    // The hash of the names and contents of the csv files read last with the fast parsing, as
+    // ConversionManifest::hashDriverFiles computes it. The stream parsing leaves it at 0
+    inline uint32_t contentHash() const { return m_contentHash; }
 
 private:
     // The driver id
@@ -35,6 +73,12 @@ private:
     
     // The raw data of a driver's trip
     std::vector< std::pair< int, std::vector< std::pair<float,float> > > > m_rawData;
+    
+    // The csv rows without a valid point
+    size_t m_numberOfSkippedRows;
+    
+    // The hash of the csv files
+    uint32_t m_contentHash;
 };
 
 #endif
@@ -0,0 +1,86 @@
+#ifndef DRIVERTRIPDATAMAP_H
+#define DRIVERTRIPDATAMAP_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+
+#include "TripStore.h"
+
+// Memory maps a driver's binary data file and exposes the coordinates of every trip as x and y arrays.
+// The raw files of the current version have the layout of TripStore, so the trips are views into the mapping,
+// which stays for the lifetime of the object. The mapping is aligned to a page, so every trip starts on a cache line.
+// Alternatively the content of the file can be read by the caller and handed over to the object; the trips are then
+// only aligned as far as the vector allocation is.
+// The raw files of the older versions, with the points of every trip stored together, and the compressed files
+// are converted once into a store owned by the object and the file content is released.
+class DriverTripDataMap {
+public:
+    // Constructor
+    explicit DriverTripDataMap( int driverId = 0 );
+
+    // Destructor. Unmaps the file
+    virtual ~DriverTripDataMap();
+
+    // Returns the driver id
+    inline int id() const { return m_driverId; }
+
+    // Maps the binary file of the driver and indexes the trips
+    DriverTripDataMap& mapBinaryFile( const std::string& driverDirectoryName );
+
+    // Takes over the content of a binary file read by other means and indexes the trips.
+    // The vector is left empty
+    DriverTripDataMap& loadFileContent( std::vector<char>& fileContent );
+
+    // The number of trips
+    inline size_t numberOfTrips() const { return m_tripIds.size(); }
+
+    // The id of a trip
+    inline int tripId( size_t index ) const { return m_tripIds[index]; }
+
+    // The coordinates of a trip
+    inline const TripCoordinates& trip( size_t index ) const { return m_trips[index]; }
+
+    // Whether the trips are views into the file content rather than converted from an older format
+    inline bool viewsFileContent() const { return ! m_convertedData && ! m_tripIds.empty(); }
+
+private:
+    // No copying; the views point into the mapping
+    DriverTripDataMap( const DriverTripDataMap& );
+    DriverTripDataMap& operator=( const DriverTripDataMap& );
+
+    // Releases the mapping and the trips
+    void unmap();
+
+    // Releases the mapping or the file content, keeping the converted trips
+    void releaseFileContent();
+
+    // Verifies the checksum and indexes the trips of the file content
+    void indexTrips( const char* data, size_t fileSize );
+
+    // Indexes the trips of a raw file with the x and y values in separate blocks, starting at the driver id
+    void indexSeparatedCoordinates( const char* data, size_t size, size_t offset );
+
+    // Converts the trips of an older format into a store owned by the object and releases the file content
+    void convertTrips( const std::vector< std::pair< int, TripDataView > >& trips );
+
+    // The driver id
+    int m_driverId;
+
+    // The mapped region
+    void* m_address;
+    size_t m_size;
+
+    // The file content, when read instead of mapped
+    std::vector<char> m_fileContent;
+
+    // The trips converted from an older format
+    std::shared_ptr< const TripStore > m_convertedData;
+
+    // The trip ids and the views of their coordinates
+    std::vector< int > m_tripIds;
+    std::vector< TripCoordinates > m_trips;
+};
+
+#endif
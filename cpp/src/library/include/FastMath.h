@@ -0,0 +1,47 @@
+#ifndef FASTMATH_H
+#define FASTMATH_H
+
+#include <cstddef>
+#include <atomic>
+
+// Batched math functions of the feature path, applied to arrays of values. The results may overwrite the arguments.
+// In the exact mode every value goes through the standard library. In the fast mode the functions evaluate
+// polynomial approximations without branches or calls, which the compiler vectorises for the SSE2, AVX2 and
+// AVX-512 instruction sets, the best one being chosen at run time. Their error bounds are given below and apply
+// to the whole range of double arguments; within them the fast results may differ between processors.
+//
+// The mode applies to the direction values of the kinematics and to the logarithms of the trip metrics, and is
+// set once, before the trips are processed. The segmentation of the trips always uses the exact functions.
+class FastMath {
+public:
+    // The modes
+    enum Mode {
+        Exact,
+        Fast
+    };
+
+    // The mode of the feature path, exact by default
+    static void setMode( Mode mode );
+    static inline Mode mode() { return s_mode.load( std::memory_order_relaxed ); }
+
+    // Returns the name of a mode
+    static const char* name( Mode mode );
+
+    // atan2( y[i], x[i] ) of n pairs of finite values, as std::atan2, in [-pi, pi] with the sign of y.
+    // Fast mode: relative error below 1e-10, relative to the smallest normal double for the smaller angles
+    static void atan2( const double* y, const double* x, size_t n, double* result, Mode mode );
+
+    // The square roots of n values. The vectorised square root is correctly rounded and as fast as an
+    // approximation would be, so both modes give the exact results
+    static void sqrt( const double* values, size_t n, double* result, Mode mode );
+
+    // The decimal logarithms of n values, as std::log10, with -infinity for zeros and NaN for negative values.
+    // Fast mode: absolute error below 1e-15 plus a relative error below 1e-13
+    static void log10( const double* values, size_t n, double* result, Mode mode );
+
+private:
+    // The mode of the feature path
+    static std::atomic< Mode > s_mode;
+};
+
+#endif
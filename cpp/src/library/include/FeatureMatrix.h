@@ -0,0 +1,83 @@
+#ifndef FEATUREMATRIX_H
+#define FEATUREMATRIX_H
+
+#include <iosfwd>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// The metrics of many trips, stored column by column: the driver and trip ids, the binary metrics
+// packed in bitmaps and one contiguous column for each of the other metrics (the features).
+// The metrics follow the layout of TripMetrics::descriptions(), with the binary metrics first.
+// A binary metric may be undefined (NaN in TripMetrics), which is kept in a second bitmap.
+class FeatureMatrix
+{
+public:
+    // Constructor of an empty matrix
+    FeatureMatrix();
+
+    // Destructor
+    ~FeatureMatrix();
+
+    // Returns the number of metrics, binary metrics and features
+    static size_t numberOfMetrics();
+    static size_t numberOfBinaryMetrics();
+    static size_t numberOfFeatures();
+
+    // Reserves the memory for the given number of rows
+    FeatureMatrix& reserve( size_t numberOfRows );
+
+    // Appends the metrics of a trip, in the layout of TripMetrics::values()
+    FeatureMatrix& appendRow( long driverId, long tripId, const std::vector<double>& values );
+
+    // Appends the rows of another matrix
+    FeatureMatrix& append( const FeatureMatrix& other );
+
+    // Returns a matrix with the given rows of this matrix, in the given order
+    FeatureMatrix selectRows( const std::vector< size_t >& rows ) const;
+
+    // Returns the number of rows
+    inline size_t numberOfRows() const { return m_driverIds.size(); }
+    inline bool empty() const { return m_driverIds.empty(); }
+
+    // The id columns
+    inline const std::vector< long >& driverIds() const { return m_driverIds; }
+    inline const std::vector< long >& tripIds() const { return m_tripIds; }
+    inline long driverId( size_t row ) const { return m_driverIds[row]; }
+    inline long tripId( size_t row ) const { return m_tripIds[row]; }
+
+    // Returns whether a binary metric is defined and set for a row
+    inline bool flagDefined( size_t row, size_t flag ) const { return testBit( m_flagsDefined[flag], row ); }
+    inline bool flag( size_t row, size_t flag ) const { return testBit( m_flags[flag], row ); }
+
+    // The column of a feature. Feature i is the metric numberOfBinaryMetrics() + i
+    inline const std::vector< double >& feature( size_t iFeature ) const { return m_features[iFeature]; }
+    inline std::vector< double >& feature( size_t iFeature ) { return m_features[iFeature]; }
+
+    // Returns a metric of a row as in TripMetrics::values(): 0 or 1 for the binary metrics, NaN if undefined
+    double value( size_t row, size_t metric ) const;
+
+    // Writes the metric descriptions to an output stream (space separated values)
+    static std::ostream& writeDescriptions( std::ostream& out );
+
+    // Writes the metrics of a row to an output stream (space separated values)
+    std::ostream& writeRow( std::ostream& out, size_t row ) const;
+
+private:
+    // Bitmap helpers
+    static inline bool testBit( const std::vector< uint64_t >& bits, size_t i ) { return ( bits[i / 64] >> ( i % 64 ) ) & 1; }
+    static void pushBit( std::vector< uint64_t >& bits, size_t i, bool value );
+
+    // The id columns
+    std::vector< long > m_driverIds;
+    std::vector< long > m_tripIds;
+
+    // The bitmaps of the binary metrics, 64 rows per word
+    std::vector< std::vector< uint64_t > > m_flags;
+    std::vector< std::vector< uint64_t > > m_flagsDefined;
+
+    // The feature columns
+    std::vector< std::vector< double > > m_features;
+};
+
+#endif
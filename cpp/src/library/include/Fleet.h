@@ -0,0 +1,66 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include "Driver.h"
+
+// The loaded drivers, indexed by driver id and by driver and trip id.
+// The drivers are kept in the order in which they are added and do not move once added,
+// so the pointers and references handed out stay valid for the lifetime of the fleet.
+class Fleet {
+public:
+    // Constructor of an empty fleet
+    Fleet();
+
+    // Fleets are not copyable, since their drivers are not, but can be moved
+    Fleet( const Fleet& rhs ) = delete;
+    Fleet& operator=( const Fleet& rhs ) = delete;
+    Fleet( Fleet&& rhs ) noexcept;
+    Fleet& operator=( Fleet&& rhs ) noexcept;
+
+    // Destructor
+    virtual ~Fleet();
+
+    // Reserves the space for the indices of the given numbers of drivers and trips
+    Fleet& reserve( size_t numberOfDrivers, size_t numberOfTrips = 0 );
+
+    // Takes over a driver and indexes its trips. Throws if a driver or trip id is already in the fleet,
+    // leaving the driver with the caller
+    const Driver& add( Driver&& driver );
+
+    // Returns the number of drivers
+    inline size_t size() const { return m_drivers.size(); }
+    inline bool empty() const { return m_drivers.empty(); }
+
+    // Returns the number of trips of all drivers
+    inline size_t numberOfTrips() const { return m_trips.size(); }
+
+    // Returns the i-th driver in the order of addition
+    inline const Driver& operator[]( size_t i ) const { return *m_drivers[i]; }
+
+    // Returns the driver with the given id, or 0 if not in the fleet
+    const Driver* driver( int driverId ) const;
+
+    // Returns the trip of a driver, or 0 if not in the fleet
+    const Trip* trip( int driverId, int tripId ) const;
+
+private:
+    // The key of a trip in the trip index
+    static inline uint64_t tripKey( int driverId, int tripId ) {
+        return ( static_cast<uint64_t>( static_cast<uint32_t>( driverId ) ) << 32 ) | static_cast<uint32_t>( tripId );
+    }
+
+    // The drivers, allocated one by one so that they never move
+    std::vector< std::unique_ptr< Driver > > m_drivers;
+
+    // The positions of the drivers by id
+    std::unordered_map< int, size_t > m_driverIndex;
+
+    // The trips by driver and trip id
+    std::unordered_map< uint64_t, const Trip* > m_trips;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef KINEMATICSKERNELS_H
+#define KINEMATICSKERNELS_H
+
+#include <cstddef>
+
+// The kernels computing the kinematic values of a segment from its velocity vectors, given with the x and y
+// components in separate arrays. On x86 processors there are SSE2, AVX2 and AVX-512 versions of the kernels
+// next to the scalar ones, and the best version for the processor is chosen at run time.
+// All versions give the same results as the scalar kernels, bit for bit. The direction kernels follow the mode
+// of FastMath.
+class KinematicsKernels {
+public:
+    // The instruction sets of the kernels
+    enum InstructionSet {
+        Scalar,
+        SSE2,
+        AVX2,
+        AVX512
+    };
+
+    // Returns the kernels for the best instruction set supported by the processor
+    static const KinematicsKernels& best();
+
+    // Returns the kernels for an instruction set. Throws if the processor does not support it
+    static const KinematicsKernels& forInstructionSet( InstructionSet instructionSet );
+
+    // Returns whether the processor supports an instruction set
+    static bool isSupported( InstructionSet instructionSet );
+
+    // Returns the name of an instruction set
+    static const char* name( InstructionSet instructionSet );
+
+    // Returns the instruction set of the kernels
+    inline InstructionSet instructionSet() const { return m_instructionSet; }
+
+    // The speed values of n velocity vectors
+    inline void speed( const float* vx, const float* vy, size_t n, double* speed ) const {
+        m_speed( vx, vy, n, speed );
+    }
+
+    // The n-1 acceleration and speed x acceleration values from n speed values
+    inline void acceleration( const double* speed, size_t n, double* acceleration, double* speedXacceleration ) const {
+        m_acceleration( speed, n, acceleration, speedXacceleration );
+    }
+
+    // The n-1 angles from each velocity vector to the next one, as angleAmongVectors, given their speed values
+    inline void direction( const float* vx, const float* vy, const double* speed, size_t n, double* direction ) const {
+        m_direction( vx, vy, speed, n, direction );
+    }
+
+private:
+    // The kernel signatures
+    typedef void (*SpeedKernel)( const float*, const float*, size_t, double* );
+    typedef void (*AccelerationKernel)( const double*, size_t, double*, double* );
+    typedef void (*DirectionKernel)( const float*, const float*, const double*, size_t, double* );
+
+    // Constructor
+    KinematicsKernels( InstructionSet instructionSet,
+                       SpeedKernel speedKernel,
+                       AccelerationKernel accelerationKernel,
+                       DirectionKernel directionKernel );
+
+    InstructionSet m_instructionSet;
+    SpeedKernel m_speed;
+    AccelerationKernel m_acceleration;
+    DirectionKernel m_direction;
+};
+
+#endif
@@ -5,6 +5,8 @@
 #include <utility>
 #include <iosfwd>
 
+class FeatureMatrix;
+
 // Simple PCA
 class PCA
 {
@@ -15,8 +17,8 @@ class PCA
     // Destructor
     ~PCA();
     
-    // Performs a PCA for a given data set
-    PCA& fit( const std::vector< std::vector< double > >& data );
+    // Performs a PCA on the feature columns of a data set
+    PCA& fit( const FeatureMatrix& data );
     
     // Transforms a vector to the principal component space
     std::vector< double > transform( const std::vector< double >& data,
@@ -0,0 +1,73 @@
+#ifndef QUANTILESELECTION_H
+#define QUANTILESELECTION_H
+
+#include <array>
+#include <vector>
+#include <cstddef>
+
+// The quantiles of a series used by the trip metrics: the 5th, 25th, 50th, 75th and 95th.
+// The quantile p of n values is the value of rank floor( n p / 100 ) in ascending order
+typedef std::array< double, 5 > QuantileValues;
+
+// The percentages of the quantiles
+extern const std::array< size_t, 5 > quantilePercentages;
+
+// Moves the values of the given ranks to their places in ascending order, in place, as nth_element would
+// for every rank. The values before a rank are not greater than its value and the values after it not less.
+// The ranks must be sorted and less than the number of values; repeated ranks are allowed.
+// One partitioning pass serves all the ranks: each partition hands the ranks on either side to that side,
+// and the sides without ranks are left alone.
+void multiSelect( double* begin, double* end, const size_t* ranks, size_t numberOfRanks );
+
+// Finds the quantiles of the values in place, reordering them. Returns false, leaving the quantiles
+// untouched, if there are no values
+bool selectQuantiles( double* begin, double* end, QuantileValues& quantiles );
+
+// Estimates the quantiles of a stream of values in bounded memory, with the summary of Greenwald and Khanna.
+// The summary keeps a sorted selection of the values with bounds on their ranks, and merges neighbouring entries
+// while the bounds allow. The rank of every estimate is within rankError x n of the exact rank, whatever the
+// order of the values, and the estimates are values of the stream. As long as no entries are merged, with fewer
+// than 1 / ( 2 rankError ) values, the quantiles are exact.
+// It is a visitor of the trip value series, e.g. trip.visitSpeedValues( StreamingQuantiles() ).quantiles( q )
+class StreamingQuantiles {
+public:
+    // Constructor
+    explicit StreamingQuantiles( double rankError = 0.005 );
+
+    // Adds a value
+    void add( double value );
+    inline void operator()( double value ) { this->add( value ); }
+
+    // The number of values added
+    inline size_t numberOfValues() const { return m_numberOfValues; }
+
+    // Returns the estimates of the quantiles. Returns false, leaving the quantiles untouched, if there are no values
+    bool quantiles( QuantileValues& quantiles );
+
+    // The number of entries in the summary
+    inline size_t summarySize() const { return m_entries.size(); }
+
+private:
+    // An entry of the summary: a value, the number of values it stands for, and the uncertainty of its rank
+    struct Entry {
+        double value;
+        size_t count;
+        size_t rankUncertainty;
+    };
+
+    // Merges the buffered values into the summary and merges the entries the bounds allow
+    void flush();
+
+    double m_rankError;
+    size_t m_numberOfValues;
+
+    // The values not merged into the summary yet, up to the buffer size
+    size_t m_bufferSize;
+    std::vector< double > m_buffer;
+
+    // The summary, sorted by value, and its scratch copy
+    std::vector< Entry > m_entries;
+    std::vector< Entry > m_mergedEntries;
+};
+
+#endif
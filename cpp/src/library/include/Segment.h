@@ -1,17 +1,23 @@
 #ifndef SEGMENT_H
 #define SEGMENT_H
 
+#include <cstddef>
 #include <vector>
 #include <utility>
 #include <tuple>
 
+// A trip segment: its point of origin and a view of its velocity vectors, with the x and y components
+// in separate arrays. The arrays are owned by the trip and must outlive the segment.
 class Segment{
 public:
     // Constructor
-    explicit Segment( const std::vector< std::pair<float, float> >& segmentCoordinates );
+    Segment( const std::pair<float, float>& origin,
+             const float* velocityX,
+             const float* velocityY,
+             size_t numberOfVelocityVectors );
     
     // Destructor
-    virtual ~Segment();
+    ~Segment();
     
     // The speed values
     std::vector<double> speedValues() const;
@@ -35,17 +41,24 @@ public:
     long travelDuration() const;
 
     // The number of data points
-    inline long numberOfDataPoints() const { return m_velocityVectors.size() + 1; }
+    inline long numberOfDataPoints() const { return m_numberOfVelocityVectors + 1; }
     
     // The data points
     std::vector< std::pair<float,float> > dataPoints() const;
     
+    // The velocity vectors
+    inline size_t numberOfVelocityVectors() const { return m_numberOfVelocityVectors; }
+    inline const float* velocityX() const { return m_velocityX; }
+    inline const float* velocityY() const { return m_velocityY; }
+    
 private:
     // The point of origin
     std::pair<float, float> m_origin;
 
     // the velocity vectors
-    std::vector< std::pair<float,float> > m_velocityVectors;
+    const float* m_velocityX;
+    const float* m_velocityY;
+    size_t m_numberOfVelocityVectors;
 };
 
 #endif
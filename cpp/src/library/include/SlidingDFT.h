@@ -0,0 +1,64 @@
+#ifndef SLIDINGDFT_H
+#define SLIDINGDFT_H
+
+#include <vector>
+#include <cstddef>
+
+#include "DFTPlan.h"
+
+// The first bins of the DFT of a window sliding over a series one value at a time. Each step updates
+// every bin in constant time from the value leaving and the value entering the window:
+//   X'[k] = exp( 2 pi i k / N ) ( X[k] - x_leaving + x_entering )
+// The rounding errors of the updates add up, so the bins are recomputed from the window itself
+// every few steps.
+//
+// The engine keeps its buffers between windows and series. An engine is used by one thread at a time.
+class SlidingDFT {
+public:
+    // Constructor. Throws if there are more bins than up to the Nyquist frequency, windowSize / 2 + 1
+    SlidingDFT( size_t windowSize, size_t numberOfBins, size_t resynchronisationInterval = 32 );
+
+    // Destructor
+    ~SlidingDFT();
+
+    // The size of the window and the number of bins
+    inline size_t windowSize() const { return m_plan.size(); }
+    inline size_t numberOfBins() const { return m_numberOfBins; }
+
+    // Computes the bins of the window starting at the given value
+    void start( const double* window );
+
+    // Moves on to the window starting at the given value, which is one value after the previous window
+    void slide( const double* window );
+
+    // The magnitudes of the bins of the current window
+    inline const std::vector< double >& magnitudes() const { return m_magnitudes; }
+
+private:
+    // No copying
+    SlidingDFT( const SlidingDFT& );
+    SlidingDFT& operator=( const SlidingDFT& );
+
+    // Updates the magnitudes from the bins
+    void computeMagnitudes();
+
+    // The plan of the exact transforms
+    DFTPlan m_plan;
+
+    size_t m_numberOfBins;
+    size_t m_resynchronisationInterval;
+
+    // The number of slides since the last exact transform
+    size_t m_numberOfSlides;
+
+    // cos( 2 pi k / N ) and sin( 2 pi k / N ) of the bins
+    std::vector< double > m_cos;
+    std::vector< double > m_sin;
+
+    // The bins of the current window, all of the plan's although only the first ones slide
+    std::vector< double > m_real;
+    std::vector< double > m_imaginary;
+    std::vector< double > m_magnitudes;
+};
+
+#endif
@@ -6,28 +6,56 @@
 #include <utility>
 #include <tuple>
 #include <valarray>
-
-class Segment;
+#include <memory>
+#include <atomic>
 
 #include "TripMetrics.h"
+#include "Segment.h"
+#include "TripKinematics.h"
+#include "TripDataView.h"
+#include "TripStore.h"
+#include "AlignedArray.h"
 
 class Trip {
 public:
     // Constructor
     explicit Trip( int tripId = 0 );
     
+    // Trips are not copyable; they are moved into and within containers
+    Trip( const Trip& rhs ) = delete;
+    Trip& operator=( const Trip& rhs ) = delete;
+    
+    // Move constructor and assignment. The segments are moved along with the velocity vectors they view
+    Trip( Trip&& rhs ) noexcept;
+    Trip& operator=( Trip&& rhs ) noexcept;
+    
     // Destructor
     virtual ~Trip();
     
+    // The segments and the cached kinematics are generated lazily by the first accessor that needs them.
+    // The generation is thread safe, so the const accessors may be called concurrently on the same trip;
+    // once generated, they are read without locking. Setting the data or moving the trip is not thread safe.
+    
+    // Generates the segments, and the kinematics if they are cached, ahead of concurrent use
+    const Trip& prepare() const;
+    
     // Returns the trip id
     inline int id() const { return m_tripId; }
     
-    // Sets the trip data
+    // Sets the trip data. The trip keeps its own copy of the data
     Trip& setTripData( const std::vector< std::pair<float,float> >& data );
+    Trip& setTripData( const TripDataView& data );
+    
+    // Sets the trip data to a trip of a store, which is shared with the trip
+    Trip& setTripData( const std::shared_ptr< const TripStore >& store, size_t index );
 
     // Returns the metrics of the trip
     TripMetrics metrics() const;
     
+    // Fills the metrics of the trip into a buffer, in the layout of TripMetrics::values(). They are computed
+    // in a single traversal of the segments, without the cached kinematics
+    void metrics( std::vector<double>& metricsValues ) const;
+    
     // Returns the travel duration
     long travelDuration() const;
     
@@ -57,6 +85,20 @@ public:
 
     // Returns the speed, acceleration and direction values as an assosiation
     std::vector< std::tuple<double,double,double> > speedAccelerationDirectionValues() const;
+    
+    // The visitors are called with every value of all segments in order, without copying the values.
+    // They are returned after the visit
+    template< typename Visitor > Visitor visitSpeedValues( Visitor visitor ) const;
+    template< typename Visitor > Visitor visitAccelerationValues( Visitor visitor ) const;
+    template< typename Visitor > Visitor visitSpeedXaccelerationValues( Visitor visitor ) const;
+    template< typename Visitor > Visitor visitDirectionValues( Visitor visitor ) const;
+    
+    // The visitor is called with the speed, acceleration and direction of every point after the first in a segment
+    template< typename Visitor > Visitor visitSpeedAccelerationDirectionValues( Visitor visitor ) const;
+    
+    // Returns the kinematics, holding the values of all segments. With the cache they are shared with the trip,
+    // otherwise they are computed for the caller
+    std::shared_ptr< const TripKinematics > kinematics() const;
 
     // Returns the 5th, 25th, 50th, 75th and 95th quantile of the speed distribution
     std::vector< double > speedQuantiles() const;
@@ -74,10 +116,17 @@ public:
     std::valarray< double > rollingFFT_direction( long sampleSize = 20 ) const;
     
     // Returns the raw data
-    inline const std::vector< std::pair< float, float > >& rawData() const { return m_rawData; }
+    inline const TripCoordinates& rawData() const { return m_rawData; }
     
     // Returns the segments
-    const std::vector< Segment* >& segments() const;
+    const std::vector< Segment >& segments() const;
+    
+    // Returns the memory held by the cached kinematics, in bytes
+    size_t kinematicsMemoryUsage() const;
+    
+    // Sets whether the trips keep their kinematics once computed, which is the default.
+    // Without the cache every value accessor recomputes them. Set before the trips are processed
+    static void setKinematicsCaching( bool cacheKinematics );
     
     // Operator for searching in a vector
     inline bool operator==( const Trip& rhs ) const { return this->id() == rhs.id(); }
@@ -87,14 +136,28 @@ private:
     // The trip id
     int m_tripId;
     
-    // The raw data
-    std::vector< std::pair< float, float > > m_rawData;
+    // The store holding the raw data
+    std::shared_ptr< const TripStore > m_store;
+    
+    // The view of the raw data
+    TripCoordinates m_rawData;
     
-    // The trip segments
-    std::vector< Segment* > m_segments;
+    // The velocity vectors of all segments, one segment after the other
+    AlignedArray< float > m_velocityX;
+    AlignedArray< float > m_velocityY;
     
-    // Flags if segments have been generated
-    bool m_segmentsGenerated;
+    // The trip segments, viewing the velocity vectors
+    std::vector< Segment > m_segments;
+    
+    // The kinematics of the segments, if cached
+    std::shared_ptr< const TripKinematics > m_kinematics;
+    
+    // Flags if the kinematics are cached
+    static std::atomic< bool > s_cacheKinematics;
+    
+    // Flags if segments have been generated and the kinematics cached
+    std::atomic< bool > m_segmentsGenerated;
+    std::atomic< bool > m_kinematicsCached;
     
     // The travel duration and length not included in the segments
     long m_extraTravelDuration;
@@ -106,20 +169,114 @@ private:
     // Private methods. This is for segment generation
     Trip& generateSegments();
     
-    // Identifies the gaps and corrects the jitter generating segment data
-    Trip& identifyGapsCorrectJitter( const std::vector< std::pair< float, float > >& rawData,
-				     std::vector< std::vector< std::pair< float, float > > >& segments );
+    // Clears the segments
+    void clearSegments();
+    
+    // Returns the cached kinematics, computing them if needed, or zero without the cache
+    const TripKinematics* cachedKinematics() const;
     
-    // Removes the zero speed segments
-    Trip& removeZeroSpeedSegments( const std::vector< std::pair< float, float > >& tripData,
-				   std::vector< std::vector< std::pair< float, float > > >& segments );
+    // The kinematics computed for a single call when they are not cached. A thread computes them into its own
+    // buffer, which keeps its memory from trip to trip, so that the value accessors allocate nothing once the
+    // buffer has grown to the longest trip. A call nested in another, e.g. from a visitor, uses a buffer of its own
+    class ScratchKinematics {
+    public:
+        // Constructor. Takes the buffer of the thread if it is not in use
+        ScratchKinematics();
+        
+        // Destructor. Hands the buffer of the thread back
+        ~ScratchKinematics();
+        
+        // The kinematics to compute into
+        inline TripKinematics& kinematics() { return m_threadKinematics != 0 ? *m_threadKinematics : m_ownKinematics; }
+        
+    private:
+        // No copying
+        ScratchKinematics( const ScratchKinematics& );
+        ScratchKinematics& operator=( const ScratchKinematics& );
+        
+        // The buffer of the thread, or zero if it is in use by an enclosing call
+        TripKinematics* m_threadKinematics;
+        
+        // The buffer of a nested call; empty kinematics allocate nothing
+        TripKinematics m_ownKinematics;
+    };
     
-    // Removes the segments with spurious angles
-    Trip& removeAccuteAngleSegments( const std::vector< std::pair< float, float > >& tripData,
-				     std::vector< std::vector< std::pair< float, float > > >& segments );
+    // Returns the kinematics of the segments. Without the cache they are computed in the scratch kinematics
+    const TripKinematics& kinematics( ScratchKinematics& scratch ) const;
     
-    // Returns the number of points for a minimum valid trip
-    long numberOfValidPoints() const;
+    // Calls the visitor with every value of a series
+    template< typename Visitor > static void visitValues( const std::vector< double >& values, Visitor& visitor );
+    
+    // The metrics calculations on given kinematics
+    double totalDirectionChange( const TripKinematics& kinematics ) const;
+    std::valarray< double > rollingFFT( const TripKinematics& kinematics, long sampleSize ) const;
 };
 
+
+template< typename Visitor >
+void
+Trip::visitValues( const std::vector< double >& values, Visitor& visitor )
+{
+    for ( std::vector< double >::const_iterator iValue = values.begin(); iValue != values.end(); ++iValue )
+        visitor( *iValue );
+}
+
+template< typename Visitor >
+Visitor
+Trip::visitSpeedValues( Visitor visitor ) const
+{
+    ScratchKinematics scratch;
+    visitValues( this->kinematics( scratch ).speedValues(), visitor );
+    return visitor;
+}
+
+template< typename Visitor >
+Visitor
+Trip::visitAccelerationValues( Visitor visitor ) const
+{
+    ScratchKinematics scratch;
+    visitValues( this->kinematics( scratch ).accelerationValues(), visitor );
+    return visitor;
+}
+
+template< typename Visitor >
+Visitor
+Trip::visitSpeedXaccelerationValues( Visitor visitor ) const
+{
+    ScratchKinematics scratch;
+    visitValues( this->kinematics( scratch ).speedXaccelerationValues(), visitor );
+    return visitor;
+}
+
+template< typename Visitor >
+Visitor
+Trip::visitDirectionValues( Visitor visitor ) const
+{
+    ScratchKinematics scratch;
+    visitValues( this->kinematics( scratch ).directionValues(), visitor );
+    return visitor;
+}
+
+template< typename Visitor >
+Visitor
+Trip::visitSpeedAccelerationDirectionValues( Visitor visitor ) const
+{
+    ScratchKinematics scratch;
+    const TripKinematics& kinematics = this->kinematics( scratch );
+    const std::vector<double>& speedValues = kinematics.speedValues();
+    const std::vector<double>& accelerationValues = kinematics.accelerationValues();
+    const std::vector<double>& directionValues = kinematics.directionValues();
+    
+    for ( size_t iSegment = 0; iSegment < kinematics.numberOfSegments(); ++iSegment ) {
+        const size_t speedOffset = kinematics.speedOffset( iSegment );
+        const size_t accelerationOffset = kinematics.accelerationOffset( iSegment );
+            // The direction values of the segment follow its leading zeros
+        const size_t numberOfValues = kinematics.accelerationOffset( iSegment + 1 ) - accelerationOffset;
+        const size_t directionOffset = kinematics.directionOffset( iSegment ) + numberOfValues;
+        for ( size_t i = 0; i < numberOfValues; ++i )
+            visitor( speedValues[speedOffset + i + 1], accelerationValues[accelerationOffset + i], directionValues[directionOffset + i] );
+    }
+    return visitor;
+}
+
 #endif
@@ -0,0 +1,77 @@
+#ifndef TRIPDATAARCHIVE_H
+#define TRIPDATAARCHIVE_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <cstdint>
+
+// A directory entry of the fleet archive. Locates the points of one trip
+struct TripDataArchiveEntry {
+    int32_t driverId;
+    int32_t tripId;
+    uint64_t offset;      // Byte offset of the first point in the archive
+    uint64_t pointCount;  // Number of (x,y) float pairs
+};
+
+// The fixed width header at the start of the fleet archive
+struct TripDataArchiveHeader {
+    char magic[8];              // "AXATRIPS"
+    uint32_t version;           // Format version
+    uint32_t entrySize;         // sizeof( TripDataArchiveEntry )
+    uint64_t numberOfEntries;   // Number of directory entries
+    uint64_t directoryOffset;   // Byte offset of the directory
+};
+
+// Reader for the single file archive holding the trip data of every driver.
+// The layout is: header, point data of all trips, directory of entries sorted by driver and trip id.
+// All values are stored in the native byte order.
+class TripDataArchive {
+public:
+    // The format version written and understood by this code
+    static const uint32_t currentVersion = 1;
+    
+    // Constructor. Opens the archive and reads the directory. Throws if the directory does not fit in the file,
+    // is not sorted, or locates points outside the point data region
+    explicit TripDataArchive( const std::string& archiveFileName );
+    
+    // Destructor
+    virtual ~TripDataArchive();
+    
+    // Returns the directory entries, sorted by driver and trip id
+    inline const std::vector< TripDataArchiveEntry >& entries() const { return m_entries; }
+    
+    // Returns the sorted ids of the drivers in the archive
+    std::vector< int > driverIds() const;
+    
+    // Returns the entry of a trip, or 0 if not in the archive
+    const TripDataArchiveEntry* findTrip( int driverId, int tripId ) const;
+    
+    // Returns the range [first,last) of the entries of a driver
+    std::pair< size_t, size_t > driverEntries( int driverId ) const;
+    
+    // Returns the range [first,last) of the entries whose point data starts within [beginOffset,endOffset). Used for sharding
+    std::pair< size_t, size_t > entriesInByteRange( uint64_t beginOffset, uint64_t endOffset ) const;
+    
+    // Reads the points of a trip with a single seek. Throws if the entry lies outside the point data region
+    std::vector< std::pair<float,float> > readTrip( const TripDataArchiveEntry& entry );
+    
+    // Reads all the trips of a driver, in the format of DriverTripDataIO::rawData
+    std::vector< std::pair< int, std::vector< std::pair<float,float> > > > readDriver( int driverId );
+    
+    // Returns the size of the point data region, i.e. the end offset for sharding
+    inline uint64_t dataEndOffset() const { return m_header.directoryOffset; }
+    
+private:
+    // The archive file
+    std::ifstream m_file;
+    
+    // The header
+    TripDataArchiveHeader m_header;
+    
+    // The directory
+    std::vector< TripDataArchiveEntry > m_entries;
+};
+
+#endif
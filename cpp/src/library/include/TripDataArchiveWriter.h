@@ -0,0 +1,38 @@
+#ifndef TRIPDATAARCHIVEWRITER_H
+#define TRIPDATAARCHIVEWRITER_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+
+#include "TripDataArchive.h"
+
+// Writes the single file fleet archive read by TripDataArchive
+class TripDataArchiveWriter {
+public:
+    // Constructor. Creates the archive file
+    explicit TripDataArchiveWriter( const std::string& archiveFileName );
+    
+    // Destructor. Finalises the archive if not yet done
+    virtual ~TripDataArchiveWriter();
+    
+    // Appends the trips of a driver
+    TripDataArchiveWriter& addDriver( int driverId,
+                                      const std::vector< std::pair< int, std::vector< std::pair<float,float> > > >& tripData );
+    
+    // Writes the directory and the final header
+    void close();
+    
+private:
+    // The output file
+    std::ofstream m_file;
+    
+    // The current write offset
+    uint64_t m_offset;
+    
+    // The directory collected so far
+    std::vector< TripDataArchiveEntry > m_entries;
+};
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef TRIPDATACOMPRESSION_H
+#define TRIPDATACOMPRESSION_H
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+// Compressed encoding of the points of a trip.
+//
+// The Kaggle coordinates have a resolution of 0.1 metres, so they are quantised to integers in units of
+// 0.1 metres. Consecutive positions are one second apart, so the second differences (the changes of the
+// per-second velocity vectors) are small. The x and y streams are stored separately as the first value,
+// the first difference and the zig-zag encoded second differences, bit-packed in blocks of 32 values
+// with a bit width per block. Trips whose values do not survive the quantisation bit for bit are stored
+// as raw floats, so the encoding is always lossless.
+
+// Appends the encoding of a trip to the output buffer
+void compressTripData( const std::pair<float,float>* points,
+                       size_t numberOfPoints,
+                       std::vector<char>& output );
+
+// Decodes a trip encoded by compressTripData into the points array, which must hold numberOfPoints values.
+// Returns false if the encoding is malformed.
+bool decompressTripData( const char* input,
+                         size_t inputSize,
+                         std::pair<float,float>* points,
+                         size_t numberOfPoints );
+
+// Compressed driver files start with a signature and version, followed by the driver id, the number of
+// trips and for every trip its id, number of points, encoded size and encoding.
+// From version 2 on, the files end with a checksum trailer (see Checksum.h).
+
+// Returns true if the data start with the signature of a compressed driver file
+bool isCompressedDriverData( const char* data, size_t size );
+
+// Returns true if a compressed driver file is of a version that ends with a checksum trailer
+bool compressedDriverDataHasChecksum( const char* data, size_t size );
+
+// Appends a compressed driver file to the output buffer
+void compressDriverData( int driverId,
+                         const std::vector< std::pair< int, std::vector< std::pair<float,float> > > >& tripData,
+                         std::vector<char>& output );
+
+// Decodes a compressed driver file. Throws if the data are malformed
+void decompressDriverData( const char* data,
+                           size_t size,
+                           int& driverId,
+                           std::vector< std::pair< int, std::vector< std::pair<float,float> > > >& tripData );
+
+#endif
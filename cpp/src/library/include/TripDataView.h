@@ -0,0 +1,38 @@
+#ifndef TRIPDATAVIEW_H
+#define TRIPDATAVIEW_H
+
+#include <cstddef>
+#include <utility>
+
+// Read-only view over a contiguous sequence of trip coordinates.
+// The view does not own the data; the owner must outlive it.
+class TripDataView {
+public:
+    typedef const std::pair<float,float>* const_iterator;
+    
+    // Constructors
+    TripDataView(): m_begin( 0 ), m_size( 0 ) {}
+    TripDataView( const std::pair<float,float>* begin, size_t size ): m_begin( begin ), m_size( size ) {}
+    
+    // Iterators
+    inline const_iterator begin() const { return m_begin; }
+    inline const_iterator end() const { return m_begin + m_size; }
+    
+    // The number of points
+    inline size_t size() const { return m_size; }
+    inline bool empty() const { return m_size == 0; }
+    
+    // Element access
+    inline const std::pair<float,float>& operator[]( size_t i ) const { return m_begin[i]; }
+    inline const std::pair<float,float>& front() const { return m_begin[0]; }
+    inline const std::pair<float,float>& back() const { return m_begin[m_size - 1]; }
+    
+private:
+    // The first point
+    const std::pair<float,float>* m_begin;
+    
+    // The number of points
+    size_t m_size;
+};
+
+#endif
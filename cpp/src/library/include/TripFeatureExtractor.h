@@ -0,0 +1,50 @@
+#ifndef TRIPFEATUREEXTRACTOR_H
+#define TRIPFEATUREEXTRACTOR_H
+
+#include <vector>
+#include <cstddef>
+
+#include "Segment.h"
+#include "SlidingDFT.h"
+
+// Computes the metrics of a trip in a single traversal of its segments. For each segment in turn the
+// kinematic values are computed into scratch arrays, and while they are at hand the travel length and
+// duration, the turns and the rolling spectrum of the speed are accumulated. The quantiles are selected
+// at the end, in place in the scratch arrays. The direction values are kept without the leading zeros
+// of the segments, which are accounted for in the ranks of the direction quantiles.
+// The metrics are those of the separate calculations on the trip kinematics, bit for bit.
+//
+// The extractor keeps its scratch arrays between trips; one extractor per thread avoids allocations
+// when many trips are processed.
+class TripFeatureExtractor {
+public:
+    // Constructor
+    TripFeatureExtractor();
+
+    // Destructor
+    ~TripFeatureExtractor();
+
+    // Fills the metrics of a trip into a buffer, in the layout of TripMetrics::values(), given its segments,
+    // the travel duration and length not included in them and the distance of its end point
+    void extract( const std::vector< Segment >& segments,
+                  long extraTravelDuration,
+                  double extraTravelLength,
+                  double distanceOfEndPoint,
+                  std::vector< double >& metricsValues );
+
+private:
+    // No copying
+    TripFeatureExtractor( const TripFeatureExtractor& );
+    TripFeatureExtractor& operator=( const TripFeatureExtractor& );
+
+    // The kinematic values of all segments, laid out as in TripKinematics but for the direction values
+    std::vector< double > m_speedValues;
+    std::vector< double > m_accelerationValues;
+    std::vector< double > m_speedXaccelerationValues;
+    std::vector< double > m_directionValues;
+
+    // The rolling spectrum of the speed values
+    SlidingDFT m_slidingDFT;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef TRIPKINEMATICS_H
+#define TRIPKINEMATICS_H
+
+#include <vector>
+#include <cstddef>
+
+class Segment;
+
+// The kinematic values of a trip, computed in one pass over the velocity vectors of its segments.
+// The values of the segments follow one another in the arrays, in the same layout as the value
+// accessors of the segments: for a segment of n velocity vectors there are n speed values,
+// n-1 acceleration and speed x acceleration values, and n-1 zeros followed by n-1 direction values.
+class TripKinematics {
+public:
+    // Constructor of empty kinematics. Nothing is allocated until the kinematics are computed
+    TripKinematics();
+
+    // Destructor
+    ~TripKinematics();
+
+    // Computes the kinematics of the segments, reusing the memory of the arrays
+    TripKinematics& compute( const std::vector< Segment >& segments );
+    
+    // Computes the kinematic values of a segment of n velocity vectors into arrays of n speed values and
+    // n-1 acceleration, speed x acceleration and direction values. Returns the distance travelled,
+    // summed up as in Segment::travelLength
+    static double computeSegment( const Segment& segment, double* speed, double* acceleration,
+                                  double* speedXacceleration, double* direction );
+    
+    // Returns the direction change up to which a change is noise and not counted as a turn, 2 degrees
+    static double directionNoiseThreshold();
+
+    // The values of all segments
+    inline const std::vector< double >& speedValues() const { return m_speedValues; }
+    inline const std::vector< double >& accelerationValues() const { return m_accelerationValues; }
+    inline const std::vector< double >& speedXaccelerationValues() const { return m_speedXaccelerationValues; }
+    inline const std::vector< double >& directionValues() const { return m_directionValues; }
+
+    // The number of segments
+    inline size_t numberOfSegments() const { return m_speedOffsets.empty() ? 0 : m_speedOffsets.size() - 1; }
+
+    // The ranges of the values of a segment are [offset(i), offset(i+1))
+    inline size_t speedOffset( size_t segment ) const { return m_speedOffsets[segment]; }
+    inline size_t accelerationOffset( size_t segment ) const { return m_speedOffsets[segment] - segment; }
+    inline size_t directionOffset( size_t segment ) const { return 2 * ( m_speedOffsets[segment] - segment ); }
+
+    // The travel length and duration of the segments
+    inline double travelLength() const { return m_travelLength; }
+    inline long travelDuration() const { return m_travelDuration; }
+
+    // The allocated memory in bytes
+    size_t memoryUsage() const;
+
+private:
+    std::vector< double > m_speedValues;
+    std::vector< double > m_accelerationValues;
+    std::vector< double > m_speedXaccelerationValues;
+    std::vector< double > m_directionValues;
+
+    // The offsets of the segments in the speed values, with the total number at the end
+    std::vector< size_t > m_speedOffsets;
+
+    double m_travelLength;
+    long m_travelDuration;
+};
+
+#endif
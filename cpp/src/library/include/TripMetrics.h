@@ -34,6 +34,9 @@ public:
     // Returns the number of binary metrics (which appear in the beginning)
     static long numberOfBinaryMetrics();
     
+    // Returns the number of points below which a trip is flagged by the FewPoints metric, without further metrics
+    static long minimumNumberOfPoints();
+    
     // Writes the descriptions to an output stream (space separated values)
     std::ostream& writeDescriptions( std::ostream& out ) const;
     
@@ -1,7 +1,7 @@
 #ifndef TRIPMETRICSREFERENCE_H
 #define TRIPMETRICSREFERENCE_H
 
-#include "TripMetrics.h"
+#include "FeatureMatrix.h"
 
 #include <vector>
 
@@ -11,20 +11,22 @@ class PCA;
 class TripMetricsReference
 {
 public:
-    // Constructor
-    TripMetricsReference( const std::vector< TripMetrics >& input,
+    // Constructor from all rows of the metrics
+    TripMetricsReference( const FeatureMatrix& input,
                          long binsForHistograms );
     
-    // Constructor for driver data
-    TripMetricsReference( const std::vector< TripMetrics >& input,
+    // Constructor for driver data, from the rows [beginRow, endRow) of the metrics
+    TripMetricsReference( const FeatureMatrix& input,
+                         size_t beginRow,
+                         size_t endRow,
                          long binsForHistograms,
                          const TripMetricsReference& reference );
 
     // Destructor
     ~TripMetricsReference();
 
-    // Returns the probability values for a given metrics set
-    std::vector<double> scoreMetrics( const TripMetrics& input ) const;
+    // Returns the probability values for the metrics of a row
+    std::vector<double> scoreMetrics( const FeatureMatrix& input, size_t row ) const;
     
 private: // Members
     
@@ -46,7 +48,7 @@ private: // Members
 
 private:
     // Performs a PCA to the metrics
-    void performPCA( const std::vector< std::vector<double> >& input );    
+    void performPCA( const FeatureMatrix& input );
 };
 
 #endif
@@ -0,0 +1,67 @@
+#ifndef TRIPSEGMENTATION_H
+#define TRIPSEGMENTATION_H
+
+#include <vector>
+#include <cstddef>
+
+#include "TripStore.h"
+
+// Splits the coordinates of a trip into clean segments. Four rules are applied in turn:
+// the zero speed stretches are removed, the gaps and jitter spikes are cut out, the segments are
+// split at spurious sharp turns, and the gaps and jitter are treated once more. The travel time
+// and distance of the removed parts are accumulated separately.
+//
+// Every rule only ever cuts its input into sub-ranges, so the segments are views of the trip
+// coordinates and no points are copied. The engine keeps its scratch buffers between calls;
+// one engine per thread avoids allocations when many trips are segmented.
+class TripSegmentation {
+public:
+    // Constructor
+    TripSegmentation();
+
+    // Destructor
+    ~TripSegmentation();
+
+    // Segments a trip. The segments are views of the trip and stay valid until the next call
+    const std::vector< TripCoordinates >& segment( const TripCoordinates& trip );
+
+    // Returns the segments of the last call
+    inline const std::vector< TripCoordinates >& segments() const { return m_segments; }
+
+    // Returns the travel duration and length not included in the segments of the last call
+    inline long extraTravelDuration() const { return m_extraTravelDuration; }
+    inline double extraTravelLength() const { return m_extraTravelLength; }
+
+private:
+    // No copying
+    TripSegmentation( const TripSegmentation& );
+    TripSegmentation& operator=( const TripSegmentation& );
+
+    // Removes the zero speed segments
+    void removeZeroSpeedSegments( const TripCoordinates& tripData,
+                                  std::vector< TripCoordinates >& segments );
+
+    // Identifies the gaps and jitter spikes and cuts them out
+    void identifyGapsCorrectJitter( const TripCoordinates& tripData,
+                                    std::vector< TripCoordinates >& segments );
+
+    // Removes the segments with spurious angles
+    void removeAccuteAngleSegments( const TripCoordinates& tripData,
+                                    std::vector< TripCoordinates >& segments );
+
+    // The resulting segments
+    std::vector< TripCoordinates > m_segments;
+
+    // The travel duration not included in the segments
+    long m_extraTravelDuration;
+
+    // The travel length not included in the segments
+    double m_extraTravelLength;
+
+    // Scratch segments of the intermediate rules
+    std::vector< TripCoordinates > m_zeroSpeedSegments;
+    std::vector< TripCoordinates > m_gapSegments;
+    std::vector< TripCoordinates > m_angleSegments;
+};
+
+#endif
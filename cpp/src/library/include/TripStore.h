@@ -0,0 +1,99 @@
+#ifndef TRIPSTORE_H
+#define TRIPSTORE_H
+
+#include <vector>
+#include <utility>
+#include <memory>
+
+#include "AlignedArray.h"
+#include "TripDataView.h"
+
+// Read-only view of the coordinates of a trip, with the x and y values in separate arrays.
+// The view does not own the data; the owner must outlive it.
+class TripCoordinates {
+public:
+    // Constructors
+    TripCoordinates(): m_x( 0 ), m_y( 0 ), m_size( 0 ) {}
+    TripCoordinates( const float* x, const float* y, size_t size ): m_x( x ), m_y( y ), m_size( size ) {}
+
+    // The coordinate arrays
+    inline const float* x() const { return m_x; }
+    inline const float* y() const { return m_y; }
+
+    // The number of points
+    inline size_t size() const { return m_size; }
+    inline bool empty() const { return m_size == 0; }
+
+    // Point access
+    inline std::pair<float,float> operator[]( size_t i ) const { return std::make_pair( m_x[i], m_y[i] ); }
+    inline std::pair<float,float> front() const { return (*this)[0]; }
+    inline std::pair<float,float> back() const { return (*this)[m_size - 1]; }
+
+private:
+    const float* m_x;
+    const float* m_y;
+    size_t m_size;
+};
+
+
+class DriverTripDataMap;
+
+// Keeps the coordinates of all trips of a driver in two aligned arrays, one for x and one for y.
+// Every trip starts on a cache line and is padded with zeros up to the next one.
+// A store built on a DriverTripDataMap does not copy the coordinates: it views the arrays of the map, which have
+// the same layout, and keeps the map alive.
+// The store is filled on construction and is not modified afterwards.
+// The segments are not kept here: they are found lazily per trip, after the store is shared between threads,
+// so each trip keeps its own segments.
+class TripStore {
+public:
+    // Constructor of an empty store
+    TripStore();
+
+    // Constructors storing the trips of a driver, in the given order
+    explicit TripStore( const std::vector< std::pair< int, TripDataView > >& trips );
+    explicit TripStore( const std::vector< std::pair< int, std::vector< std::pair<float,float> > > >& trips );
+
+    // Constructor storing a single trip
+    TripStore( int tripId, const TripDataView& trip );
+
+    // Constructor viewing the trips of a driver file. Only the trip ids and views are copied
+    explicit TripStore( const std::shared_ptr< const DriverTripDataMap >& mappedData );
+
+    // Destructor
+    ~TripStore();
+
+    // The number of trips
+    inline size_t numberOfTrips() const { return m_tripIds.size(); }
+
+    // The id of a trip
+    inline int tripId( size_t index ) const { return m_tripIds[index]; }
+
+    // The coordinates of a trip
+    inline TripCoordinates trip( size_t index ) const { return m_trips[index]; }
+
+    // The memory holding the coordinates, with the padding, and the trip index in bytes.
+    // The coordinates viewed in a driver file are counted as well
+    size_t memoryUsage() const;
+
+private:
+    // No copying; the views point into the arrays
+    TripStore( const TripStore& );
+    TripStore& operator=( const TripStore& );
+
+    // Copies the trips into the arrays
+    void store( const std::vector< std::pair< int, TripDataView > >& trips );
+
+    // The coordinates, when stored here
+    AlignedArray<float> m_x;
+    AlignedArray<float> m_y;
+
+    // The driver file, when its coordinates are viewed
+    std::shared_ptr< const DriverTripDataMap > m_mappedData;
+
+    // The trip ids and the views of their coordinates
+    std::vector< int > m_tripIds;
+    std::vector< TripCoordinates > m_trips;
+};
+
+#endif
@@ -5,6 +5,8 @@
 #include <utility>
 #include <valarray>
 
+class FeatureMatrix;
+
 
 double
 innerProduct( const std::pair<float,float>& v1,
@@ -34,6 +36,11 @@ std::pair<float,float>
 operator/( const std::pair<float,float>& v,
 	   double f );
 
+// The signed angle from v2 to v1, in (-pi, pi]. Zero if either vector is null
+double
+angleAmongVectors( const std::pair<float,float>& v1,
+                   const std::pair<float,float>& v2 );
+
 std::vector< double >
 findQuantiles( std::vector<double>& values );
 
@@ -41,11 +48,14 @@ double
 r2_correlation( const std::vector<double>& x,
 		const std::vector<double>& y );
 
+// The magnitudes of the DFT bins of the data, from the zero to the Nyquist frequency.
+// Repeated transforms of the same size are cheaper with a DFTPlan
 std::valarray< double >
 vfft( const std::vector<double>& data );
 
 
-std::vector<std::vector<double> >
-tripExtremesFromColumns( const std::vector<std::vector<double> >& input, double percentageToKeep );
+// The rows of the matrix whose features are all within the central percentage of their column
+std::vector< size_t >
+rowsWithoutExtremes( const FeatureMatrix& input, double percentageToKeep );
 
 #endif
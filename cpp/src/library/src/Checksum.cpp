@@ -0,0 +1,142 @@
+#include "Checksum.h"
+
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <nmmintrin.h>
+#define CHECKSUM_X86_CRC32
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#define CHECKSUM_ARM_CRC32
+#endif
+
+// The tag closing the checksum trailer. The file formats with a version say whether the trailer must be present;
+// in the older files without one, the tag only makes a trailer likely, as any 8 bytes may be float data
+static const char trailerTag[8] = { 'A', 'X', 'A', 'C', 'R', 'C', '3', '2' };
+
+// The reflected Castagnoli polynomial
+static const uint32_t polynomial = 0x82f63b78;
+
+
+// Software implementation, slicing by 8 bytes
+class Crc32cTables {
+public:
+    Crc32cTables() {
+        for ( uint32_t i = 0; i < 256; ++i ) {
+            uint32_t crc = i;
+            for ( int j = 0; j < 8; ++j ) crc = ( crc & 1 ) ? ( crc >> 1 ) ^ polynomial : ( crc >> 1 );
+            table[0][i] = crc;
+        }
+        for ( uint32_t i = 0; i < 256; ++i )
+            for ( int k = 1; k < 8; ++k )
+                table[k][i] = ( table[k-1][i] >> 8 ) ^ table[0][ table[k-1][i] & 0xff ];
+    }
+    uint32_t table[8][256];
+};
+
+static uint32_t crc32cSoftware( const unsigned char* p, size_t size, uint32_t crc )
+{
+    static const Crc32cTables tables;
+    const uint32_t (*t)[256] = tables.table;
+    
+    while ( size >= 8 ) {
+        uint32_t low, high;
+        std::memcpy( &low, p, 4 );
+        std::memcpy( &high, p + 4, 4 );
+        low ^= crc;
+        crc = t[7][ low & 0xff ] ^ t[6][ ( low >> 8 ) & 0xff ] ^ t[5][ ( low >> 16 ) & 0xff ] ^ t[4][ low >> 24 ] ^
+              t[3][ high & 0xff ] ^ t[2][ ( high >> 8 ) & 0xff ] ^ t[1][ ( high >> 16 ) & 0xff ] ^ t[0][ high >> 24 ];
+        p += 8;
+        size -= 8;
+    }
+    while ( size-- > 0 ) crc = ( crc >> 8 ) ^ t[0][ ( crc ^ *p++ ) & 0xff ];
+    return crc;
+}
+
+
+#if defined(CHECKSUM_X86_CRC32)
+__attribute__(( target( "sse4.2" ) ))
+static uint32_t crc32cHardware( const unsigned char* p, size_t size, uint32_t crc )
+{
+#if defined(__x86_64__)
+    uint64_t crc64 = crc;
+    while ( size >= 8 ) {
+        uint64_t value;
+        std::memcpy( &value, p, 8 );
+        crc64 = _mm_crc32_u64( crc64, value );
+        p += 8;
+        size -= 8;
+    }
+    crc = static_cast<uint32_t>( crc64 );
+#endif
+    while ( size-- > 0 ) crc = _mm_crc32_u8( crc, *p++ );
+    return crc;
+}
+
+static bool hardwareAvailable()
+{
+    static const bool available = __builtin_cpu_supports( "sse4.2" );
+    return available;
+}
+#elif defined(CHECKSUM_ARM_CRC32)
+static uint32_t crc32cHardware( const unsigned char* p, size_t size, uint32_t crc )
+{
+    while ( size >= 8 ) {
+        uint64_t value;
+        std::memcpy( &value, p, 8 );
+        crc = __crc32cd( crc, value );
+        p += 8;
+        size -= 8;
+    }
+    while ( size-- > 0 ) crc = __crc32cb( crc, *p++ );
+    return crc;
+}
+
+static bool hardwareAvailable()
+{
+    return true;
+}
+#endif
+
+
+uint32_t
+crc32c( const void* data, size_t size, uint32_t crc )
+{
+    const unsigned char* p = static_cast<const unsigned char*>( data );
+    crc = ~crc;
+#if defined(CHECKSUM_X86_CRC32) || defined(CHECKSUM_ARM_CRC32)
+    if ( hardwareAvailable() ) return ~crc32cHardware( p, size, crc );
+#endif
+    return ~crc32cSoftware( p, size, crc );
+}
+
+
+void
+appendChecksumTrailer( std::vector<char>& buffer )
+{
+    const uint32_t crc = crc32c( buffer.data(), buffer.size() );
+    const char* bytes = reinterpret_cast<const char*>( &crc );
+    buffer.insert( buffer.end(), bytes, bytes + sizeof(crc) );
+    buffer.insert( buffer.end(), trailerTag, trailerTag + sizeof(trailerTag) );
+}
+
+
+size_t
+verifyChecksumTrailer( const char* data, size_t size, bool trailerRequired )
+{
+    const size_t trailerSize = sizeof(uint32_t) + sizeof(trailerTag);
+    if ( size < trailerSize || std::memcmp( data + size - sizeof(trailerTag), trailerTag, sizeof(trailerTag) ) != 0 ) {
+        if ( trailerRequired )
+            throw std::runtime_error( "verifyChecksumTrailer : missing checksum trailer, the file is truncated" );
+        return size;
+    }
+    
+    const size_t payloadSize = size - trailerSize;
+    uint32_t storedCrc;
+    std::memcpy( &storedCrc, data + payloadSize, sizeof(storedCrc) );
+    if ( crc32c( data, payloadSize ) != storedCrc )
+        throw std::runtime_error( "verifyChecksumTrailer : checksum mismatch, the file is corrupt" );
+    return payloadSize;
+}
@@ -0,0 +1,214 @@
+#include "ConversionManifest.h"
+#include "DirectoryListing.h"
+#include "Checksum.h"
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <stdexcept>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+// The first line of a manifest file
+static const std::string manifestHeader = "# AXA trip data conversion manifest, version 1";
+
+
+DriverSourceState::DriverSourceState():
+  numberOfFiles( 0 ),
+  totalSize( 0 ),
+  lastModification( 0 ),
+  contentHash( 0 ),
+  format( 0 )
+{}
+
+
+bool
+DriverSourceState::sameFiles( const DriverSourceState& rhs ) const
+{
+    return numberOfFiles == rhs.numberOfFiles &&
+           totalSize == rhs.totalSize &&
+           lastModification == rhs.lastModification;
+}
+
+
+ConversionManifest::ConversionManifest( const std::string& fileName ):
+  m_fileName( fileName ),
+  m_entries(),
+  m_mutex()
+{}
+
+
+ConversionManifest::~ConversionManifest()
+{}
+
+
+std::string
+ConversionManifest::manifestFileName( const std::string& outputDirectory )
+{
+    std::string directory = outputDirectory;
+    while ( directory.size() > 1 && directory[ directory.size() - 1 ] == '/' )
+        directory.erase( directory.size() - 1 );
+    return directory + ".manifest";
+}
+
+
+ConversionManifest&
+ConversionManifest::load()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_entries.clear();
+
+    std::ifstream inputFile( m_fileName );
+    if ( ! inputFile.is_open() ) return *this;
+
+    std::string lineBuffer;
+    std::getline( inputFile, lineBuffer );
+    if ( lineBuffer != manifestHeader )
+        throw std::runtime_error( "ConversionManifest::load : " + m_fileName + " is not a conversion manifest" );
+
+    // Each line : driver id, number of files, total size, last modification, content hash, format
+    while ( std::getline( inputFile, lineBuffer ) ) {
+        if ( lineBuffer.empty() ) continue;
+        std::istringstream is( lineBuffer );
+        int driverId = 0;
+        DriverSourceState state;
+        is >> driverId >> state.numberOfFiles >> state.totalSize >> state.lastModification >> state.contentHash >> state.format;
+        if ( is.fail() )
+            throw std::runtime_error( "ConversionManifest::load : malformed line in " + m_fileName + " : " + lineBuffer );
+        m_entries[driverId] = state;
+    }
+
+    return *this;
+}
+
+
+const ConversionManifest&
+ConversionManifest::save() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    const std::string temporaryFileName = m_fileName + ".tmp";
+    std::ofstream outputFile( temporaryFileName );
+    if ( ! outputFile.is_open() )
+        throw std::runtime_error( "ConversionManifest::save : could not open " + temporaryFileName );
+
+    outputFile << manifestHeader << "\n";
+    for ( std::map< int, DriverSourceState >::const_iterator iEntry = m_entries.begin();
+         iEntry != m_entries.end(); ++iEntry ) {
+        const DriverSourceState& state = iEntry->second;
+        outputFile << iEntry->first << " " << state.numberOfFiles << " " << state.totalSize << " "
+                   << state.lastModification << " " << state.contentHash << " " << state.format << "\n";
+    }
+    outputFile.close();
+    if ( outputFile.fail() ) {
+        std::remove( temporaryFileName.c_str() );
+        throw std::runtime_error( "ConversionManifest::save : could not write " + temporaryFileName );
+    }
+
+    if ( std::rename( temporaryFileName.c_str(), m_fileName.c_str() ) != 0 ) {
+        std::remove( temporaryFileName.c_str() );
+        throw std::runtime_error( "ConversionManifest::save : could not rename " + temporaryFileName );
+    }
+
+    return *this;
+}
+
+
+bool
+ConversionManifest::find( int driverId, DriverSourceState& state ) const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    std::map< int, DriverSourceState >::const_iterator iEntry = m_entries.find( driverId );
+    if ( iEntry == m_entries.end() ) return false;
+    state = iEntry->second;
+    return true;
+}
+
+
+ConversionManifest&
+ConversionManifest::update( int driverId, const DriverSourceState& state )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_entries[driverId] = state;
+    return *this;
+}
+
+
+ConversionManifest&
+ConversionManifest::remove( int driverId )
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_entries.erase( driverId );
+    return *this;
+}
+
+
+std::vector<int>
+ConversionManifest::driverIds() const
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+    std::vector<int> result;
+    result.reserve( m_entries.size() );
+    for ( std::map< int, DriverSourceState >::const_iterator iEntry = m_entries.begin();
+         iEntry != m_entries.end(); ++iEntry )
+        result.push_back( iEntry->first );
+    return result;
+}
+
+
+// Returns the directory holding the csv files of a driver
+static std::string driverCSVDirectory( const std::string& driverDirectoryName, int driverId )
+{
+    std::ostringstream osDirectoryName;
+    osDirectoryName << driverDirectoryName << "/" << driverId;
+    return osDirectoryName.str();
+}
+
+
+DriverSourceState
+ConversionManifest::scanDriverFiles( const std::string& driverDirectoryName, int driverId )
+{
+    const std::string directoryName = driverCSVDirectory( driverDirectoryName, driverId );
+
+    DriverSourceState state;
+    DirectoryListing dirListing( directoryName );
+    dirListing.setExtensionFilter( ".csv" ).setOrdering( DirectoryListing::NoOrdering );
+    for ( DirectoryListing::const_iterator iFile = dirListing.begin(); iFile != dirListing.end(); ++iFile ) {
+        struct stat fileStatus;
+        if ( ::stat( ( directoryName + "/" + *iFile ).c_str(), &fileStatus ) != 0 )
+            throw std::runtime_error( "ConversionManifest::scanDriverFiles : could not stat " + directoryName + "/" + *iFile );
+        ++state.numberOfFiles;
+        state.totalSize += fileStatus.st_size;
+        if ( fileStatus.st_mtime > state.lastModification ) state.lastModification = fileStatus.st_mtime;
+    }
+    return state;
+}
+
+
+uint32_t
+ConversionManifest::hashDriverFiles( const std::string& driverDirectoryName, int driverId )
+{
+    const std::string directoryName = driverCSVDirectory( driverDirectoryName, driverId );
+
+    // The files are hashed in name order, so that the hash does not depend on the file system order
+    DirectoryListing dirListing( directoryName );
+    dirListing.setExtensionFilter( ".csv" );
+    std::list<std::string> fileNames = dirListing.directoryContent();
+
+    uint32_t hash = 0;
+    std::vector<char> buffer;
+    for ( std::list<std::string>::const_iterator iFileName = fileNames.begin();
+         iFileName != fileNames.end(); ++iFileName ) {
+        std::ifstream inputFile( directoryName + "/" + *iFileName, std::ios::in | std::ios::binary );
+        if ( ! inputFile.is_open() )
+            throw std::runtime_error( "ConversionManifest::hashDriverFiles : could not open " + directoryName + "/" + *iFileName );
+        inputFile.seekg( 0, std::ios::end );
+        buffer.resize( static_cast<size_t>( inputFile.tellg() ) );
+        inputFile.seekg( 0, std::ios::beg );
+        inputFile.read( buffer.data(), buffer.size() );
+
+        hash = crc32c( iFileName->c_str(), iFileName->size() + 1, hash );
+        hash = crc32c( buffer.data(), inputFile.gcount(), hash );
+    }
+    return hash;
+}
@@ -0,0 +1,132 @@
+#include "DFTPlan.h"
+#include <cmath>
+#include <stdexcept>
+
+DFTPlan::DFTPlan( size_t size ):
+  m_size( size ),
+  m_powerOfTwo( size > 0 && ( size & ( size - 1 ) ) == 0 ),
+  m_cos( size ),
+  m_sin( size ),
+  m_bitReversal(),
+  m_real(),
+  m_imaginary(),
+  m_binsReal( size / 2 + 1 ),
+  m_binsImaginary( size / 2 + 1 )
+{
+    if ( size == 0 ) throw std::runtime_error( "DFTPlan : the size must be positive" );
+
+    const double pi = std::atan( 1.0 ) * 4;
+    for ( size_t k = 0; k < size; ++k ) {
+        const double angle = 2 * pi * k / size;
+        m_cos[k] = std::cos( angle );
+        m_sin[k] = std::sin( angle );
+    }
+
+    if ( m_powerOfTwo && size > 1 ) {
+        // The complex transform of half the size
+        const size_t halfSize = size / 2;
+        m_real.resize( halfSize );
+        m_imaginary.resize( halfSize );
+        m_bitReversal.resize( halfSize );
+        size_t numberOfBits = 0;
+        while ( ( size_t( 1 ) << numberOfBits ) < halfSize ) ++numberOfBits;
+        for ( size_t i = 0; i < halfSize; ++i ) {
+            size_t reversed = 0;
+            for ( size_t bit = 0; bit < numberOfBits; ++bit )
+                if ( i & ( size_t( 1 ) << bit ) ) reversed |= size_t( 1 ) << ( numberOfBits - 1 - bit );
+            m_bitReversal[i] = reversed;
+        }
+    }
+}
+
+
+DFTPlan::~DFTPlan()
+{}
+
+
+void
+DFTPlan::transform( const double* data, double* real, double* imaginary )
+{
+    if ( m_powerOfTwo ) this->radix2Transform( data, real, imaginary );
+    else this->directTransform( data, real, imaginary );
+}
+
+
+void
+DFTPlan::magnitudes( const double* data, double* magnitudes )
+{
+    this->transform( data, m_binsReal.data(), m_binsImaginary.data() );
+    for ( size_t k = 0; k < m_binsReal.size(); ++k )
+        magnitudes[k] = std::hypot( m_binsReal[k], m_binsImaginary[k] );
+}
+
+
+void
+DFTPlan::directTransform( const double* data, double* real, double* imaginary ) const
+{
+    const size_t numberOfBins = this->numberOfBins();
+    for ( size_t k = 0; k < numberOfBins; ++k ) {
+        // The twiddle factor of value n is exp( -2 pi i k n / size ), stepping through the table by k
+        double sumReal = 0;
+        double sumImaginary = 0;
+        size_t twiddle = 0;
+        for ( size_t n = 0; n < m_size; ++n ) {
+            sumReal += data[n] * m_cos[twiddle];
+            sumImaginary -= data[n] * m_sin[twiddle];
+            twiddle += k;
+            if ( twiddle >= m_size ) twiddle -= m_size;
+        }
+        real[k] = sumReal;
+        imaginary[k] = sumImaginary;
+    }
+}
+
+
+void
+DFTPlan::radix2Transform( const double* data, double* real, double* imaginary )
+{
+    if ( m_size == 1 ) {
+        real[0] = data[0];
+        imaginary[0] = 0;
+        return;
+    }
+
+    // Pack the even and odd values into the real and imaginary parts, in bit reversed order
+    const size_t halfSize = m_size / 2;
+    for ( size_t i = 0; i < halfSize; ++i ) {
+        m_real[ m_bitReversal[i] ] = data[2 * i];
+        m_imaginary[ m_bitReversal[i] ] = data[2 * i + 1];
+    }
+
+    // The butterflies. The twiddle factors of a stage of length l are every size / l th entry of the tables
+    for ( size_t length = 2; length <= halfSize; length *= 2 ) {
+        const size_t half = length / 2;
+        const size_t step = m_size / length;
+        for ( size_t j = 0; j < half; ++j ) {
+            const double wr = m_cos[j * step];
+            const double wi = - m_sin[j * step];
+            for ( size_t start = j; start < halfSize; start += length ) {
+                const size_t partner = start + half;
+                const double vr = m_real[partner] * wr - m_imaginary[partner] * wi;
+                const double vi = m_real[partner] * wi + m_imaginary[partner] * wr;
+                m_real[partner] = m_real[start] - vr;
+                m_imaginary[partner] = m_imaginary[start] - vi;
+                m_real[start] += vr;
+                m_imaginary[start] += vi;
+            }
+        }
+    }
+
+    // Separate the transforms of the even and odd values, E = ( Z[k] + Z*[M-k] ) / 2 and
+    // O = ( Z[k] - Z*[M-k] ) / 2i, and combine them into X[k] = E + exp( -2 pi i k / size ) O
+    for ( size_t k = 0; k <= halfSize; ++k ) {
+        const size_t i = k % halfSize;
+        const size_t j = ( halfSize - k ) % halfSize;
+        const double evenReal = ( m_real[i] + m_real[j] ) / 2;
+        const double evenImaginary = ( m_imaginary[i] - m_imaginary[j] ) / 2;
+        const double oddReal = ( m_imaginary[i] + m_imaginary[j] ) / 2;
+        const double oddImaginary = ( m_real[j] - m_real[i] ) / 2;
+        real[k] = evenReal + m_cos[k] * oddReal + m_sin[k] * oddImaginary;
+        imaginary[k] = evenImaginary + m_cos[k] * oddImaginary - m_sin[k] * oddReal;
+    }
+}
@@ -1,12 +1,58 @@
 #include "DirectoryListing.h"
 
-#include <sstream>
 #include <cstdlib>
 #include <exception>
+#include <stdexcept>
+
+
+DirectoryListing::const_iterator::const_iterator():
+m_directory(),
+m_extension(),
+m_entry()
+{}
+
+DirectoryListing::const_iterator::const_iterator( const std::string& directory, const std::string& extension ):
+m_directory(),
+m_extension( extension ),
+m_entry()
+{
+    DIR* dir = opendir( directory.c_str() );
+    if ( dir == 0 ) throw std::runtime_error( "DirectoryListing : could not open directory " + directory );
+    m_directory.reset( dir, closedir );
+    this->advance();
+}
+
+DirectoryListing::const_iterator&
+DirectoryListing::const_iterator::operator++()
+{
+    this->advance();
+    return *this;
+}
+
+void
+DirectoryListing::const_iterator::advance()
+{
+    while ( m_directory ) {
+        const struct dirent* entry = readdir( m_directory.get() );
+        if ( entry == 0 ) {
+            m_directory.reset();
+            m_entry.clear();
+            return;
+        }
+        const char* name = entry->d_name;
+        if ( name[0] == '.' ) continue;
+        m_entry = name;
+        if ( m_entry.size() >= m_extension.size() &&
+             m_entry.compare( m_entry.size() - m_extension.size(), m_extension.size(), m_extension ) == 0 )
+            return;
+    }
+}
 
 
 DirectoryListing::DirectoryListing( std::string targetDirectory ):
-m_currentDirectory( targetDirectory )
+m_currentDirectory( targetDirectory ),
+m_extension(),
+m_ordering( NameOrdering )
 {}
 
 DirectoryListing&
@@ -15,33 +61,43 @@ DirectoryListing::setWorkingDirectory( const std::string& cwd ) {
     return *this;
 }
 
+DirectoryListing&
+DirectoryListing::setExtensionFilter( const std::string& extension ) {
+    m_extension = extension;
+    return *this;
+}
+
+DirectoryListing&
+DirectoryListing::setOrdering( Ordering ordering ) {
+    m_ordering = ordering;
+    return *this;
+}
+
+DirectoryListing::const_iterator
+DirectoryListing::begin() const {
+    return const_iterator( m_currentDirectory, m_extension );
+}
+
+DirectoryListing::const_iterator
+DirectoryListing::end() const {
+    return const_iterator();
+}
+
+
+static bool numericLess( const std::string& lhs, const std::string& rhs )
+{
+    const long lhsNumber = std::strtol( lhs.c_str(), 0, 10 );
+    const long rhsNumber = std::strtol( rhs.c_str(), 0, 10 );
+    if ( lhsNumber != rhsNumber ) return lhsNumber < rhsNumber;
+    return lhs < rhs;
+}
+
 std::list<std::string>
 DirectoryListing::directoryContent() const {
-    std::list<std::string> result;
-    
-    std::string command = "ls " + m_currentDirectory;
-    
-    FILE* pipe = popen( command.c_str(), "r" );
-    if (!pipe ) throw std::runtime_error( "Could not open pipe" );
-    
-    char buffer[128];
-    std::string output = "";
-    while ( !feof(pipe) ) {
-        if ( fgets(buffer, 128, pipe ) ) {
-            output += buffer;
-        }
-    }
-    pclose(pipe);
+    std::list<std::string> result( this->begin(), this->end() );
     
-    std::istringstream is(output);
-    
-    while (is) {
-        
-        std::string content;
-        is >> std::skipws >> content >> std::ws;
-        if ( content.empty() ) break;
-        result.push_back(content);
-    }
+    if ( m_ordering == NameOrdering ) result.sort();
+    else if ( m_ordering == NumericOrdering ) result.sort( numericLess );
     
     return result;
 }
@@ -1,10 +1,27 @@
 #include "Driver.h"
+#include "DriverTripDataMap.h"
 
 Driver::Driver( int driverId ):
   m_driverId( driverId ),
-  m_trips()
+  m_trips(),
+  m_tripStore()
 {}
 
+Driver::Driver( Driver&& rhs ) noexcept:
+  m_driverId( rhs.m_driverId ),
+  m_trips( std::move( rhs.m_trips ) ),
+  m_tripStore( std::move( rhs.m_tripStore ) )
+{}
+
+Driver&
+Driver::operator=( Driver&& rhs ) noexcept
+{
+    m_driverId = rhs.m_driverId;
+    m_trips = std::move( rhs.m_trips );
+    m_tripStore = std::move( rhs.m_tripStore );
+    return *this;
+}
+
 Driver::~Driver()
 {}
 
@@ -12,26 +29,49 @@ Driver&
 Driver::loadTripData( const std::vector< std::pair< int, std::vector< std::pair<float,float> > > >& tripData )
 {
     m_trips.clear();
+    m_tripStore = std::make_shared< const TripStore >( tripData );
     m_trips.reserve( tripData.size() );
-    for ( std::vector< std::pair< int, std::vector< std::pair<float,float> > > >::const_iterator iTrip = tripData.begin();
-         iTrip != tripData.end(); ++iTrip ) {
-        m_trips.push_back( Trip( iTrip->first ) );
-        m_trips.back().setTripData( iTrip->second );
+    for ( size_t i = 0; i < m_tripStore->numberOfTrips(); ++i ) {
+        m_trips.push_back( Trip( m_tripStore->tripId( i ) ) );
+        m_trips.back().setTripData( m_tripStore, i );
+    }
+    
+    return *this;
+}
+
+Driver&
+Driver::loadTripData( const std::shared_ptr< const DriverTripDataMap >& mappedData )
+{
+    m_trips.clear();
+    m_driverId = mappedData->id();
+    m_tripStore = std::make_shared< const TripStore >( mappedData );
+    m_trips.reserve( m_tripStore->numberOfTrips() );
+    for ( size_t i = 0; i < m_tripStore->numberOfTrips(); ++i ) {
+        m_trips.push_back( Trip( m_tripStore->tripId( i ) ) );
+        m_trips.back().setTripData( m_tripStore, i );
     }
     
     return *this;
 }
 
-std::vector< TripMetrics >
+FeatureMatrix
 Driver::tripMetrics() const
 {
-    std::vector< TripMetrics > localMetrics;
+    FeatureMatrix localMetrics;
     localMetrics.reserve( m_trips.size() );
+    this->appendTripMetrics( localMetrics );
+    return localMetrics;
+}
+
+
+const Driver&
+Driver::appendTripMetrics( FeatureMatrix& output ) const
+{
+    std::vector<double> metricsValues;
     for ( std::vector< Trip >::const_iterator iTrip = m_trips.begin();
 	  iTrip != m_trips.end(); ++iTrip ) {
-        TripMetrics m = iTrip->metrics();
-        m.setDriverId( m_driverId );
-        localMetrics.push_back( m );
+        iTrip->metrics( metricsValues );
+        output.appendRow( m_driverId, iTrip->id(), metricsValues );
     }
-    return localMetrics;
+    return *this;
 }
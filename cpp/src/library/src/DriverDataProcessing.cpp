@@ -1,17 +1,24 @@
 #include "DriverDataProcessing.h"
-#include "DriverTripDataIO.h"
+#include "DriverTripDataMap.h"
 #include "DirectoryListing.h"
 #include "ProcessLogger.h"
 #include "TripMetricsReference.h"
+#include "BoundedQueue.h"
+#include "DriverFileBatchLoader.h"
 
 #include <thread>
 #include <mutex>
+#include <chrono>
+#include <iostream>
 #include <sstream>
 #include <exception>
 #include <cmath>
 
 DriverDataProcessing::DriverDataProcessing( const std::string& driversDirectory ):
-m_driversDirectory( driversDirectory )
+m_driversDirectory( driversDirectory ),
+m_readAheadDepth( 16 ),
+m_numberOfIOThreads( 2 ),
+m_fileLoading( DriverFileBatchLoader::IOUring )
 {}
 
 
@@ -19,86 +26,240 @@ DriverDataProcessing::~DriverDataProcessing()
 {}
 
 
-static void readThreadFunction( std::mutex* pinputMutex,
-                               std::list<std::string>* pdriverFiles,
+DriverDataProcessing&
+DriverDataProcessing::setReadAhead( int depth, int numberOfIOThreads )
+{
+    m_readAheadDepth = depth > 0 ? depth : 0;
+    m_numberOfIOThreads = numberOfIOThreads > 0 ? numberOfIOThreads : 1;
+    return *this;
+}
+
+
+DriverDataProcessing&
+DriverDataProcessing::setFileLoading( DriverFileBatchLoader::Backend backend )
+{
+    m_fileLoading = backend;
+    return *this;
+}
+
+
+// Supplies the loaded driver files to the worker threads.
+// With a read-ahead depth, dedicated I/O threads load the files in batches up to that many drivers ahead
+// of the workers. Without, every worker maps the next file itself.
+// Keeps track of the time the workers spend waiting for the data.
+class DriverFileSource {
+public:
+    DriverFileSource( const std::string& driversDirectory, int readAheadDepth, int numberOfIOThreads,
+                      DriverFileBatchLoader::Backend fileLoading ):
+    m_driversDirectory( driversDirectory ),
+    m_driverIds(),
+    m_numberOfDrivers( 0 ),
+    m_inputMutex(),
+    m_readAhead( readAheadDepth > 0 ? readAheadDepth : 1 ),
+    m_batchSize( readAheadDepth > 0 ? ( readAheadDepth + numberOfIOThreads - 1 ) / numberOfIOThreads : 1 ),
+    m_fileLoading( fileLoading ),
+    m_ioThreads(),
+    m_activeIOThreads( readAheadDepth > 0 ? numberOfIOThreads : 0 ),
+    m_waitingTime( 0 ),
+    m_timeMutex()
+    {
+        DirectoryListing dirList( driversDirectory );
+        dirList.setExtensionFilter( ".data" ).setOrdering( DirectoryListing::NumericOrdering );
+        std::list<std::string> driverFiles = dirList.directoryContent();
+        for (std::list<std::string>::const_iterator iDriverFile = driverFiles.begin();
+             iDriverFile != driverFiles.end(); ++iDriverFile ) {
+            int driverId = 0;
+            std::istringstream isId( *iDriverFile );
+            isId >> driverId;
+            m_driverIds.push_back( driverId );
+        }
+        m_numberOfDrivers = m_driverIds.size();
+        
+        // The I/O threads are all counted before the first one starts, as the last one to finish closes the queue
+        const int numberOfThreads = m_activeIOThreads;
+        try {
+            for ( int i = 0; i < numberOfThreads; ++i )
+                m_ioThreads.push_back( std::thread( &DriverFileSource::readAheadThreadFunction, this ) );
+        }
+        catch ( ... ) {
+            // The missing threads would never close the queue, so close it for the started ones
+            m_readAhead.close();
+            for ( size_t i = 0; i < m_ioThreads.size(); ++i ) m_ioThreads[i].join();
+            throw;
+        }
+    }
+    
+    ~DriverFileSource() {
+        m_readAhead.close();
+        for ( size_t i = 0; i < m_ioThreads.size(); ++i ) m_ioThreads[i].join();
+    }
+    
+    // The number of driver files
+    inline size_t numberOfDrivers() const { return m_numberOfDrivers; }
+    
+    // Returns the next loaded driver file, or an empty pointer when all have been handed out
+    std::shared_ptr< DriverTripDataMap > next() {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::shared_ptr< DriverTripDataMap > result;
+        if ( m_ioThreads.empty() ) {
+            std::vector<int> driverIds;
+            if ( this->nextDrivers( 1, driverIds ) ) {
+                result = std::make_shared< DriverTripDataMap >( driverIds.front() );
+                result->mapBinaryFile( m_driversDirectory );
+            }
+        }
+        else {
+            DriverFileBatchLoader::LoadedDriver item;
+            if ( m_readAhead.pop( item ) ) {
+                if ( item.error ) std::rethrow_exception( item.error );
+                result = item.data;
+            }
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::lock_guard<std::mutex> lock( m_timeMutex );
+        m_waitingTime += elapsed.count();
+        return result;
+    }
+    
+    // The total time the workers spent waiting for driver data
+    double waitingTime() const {
+        std::lock_guard<std::mutex> lock( m_timeMutex );
+        return m_waitingTime;
+    }
+    
+private:
+    // Takes up to a number of drivers from the list
+    bool nextDrivers( size_t numberOfDrivers, std::vector<int>& driverIds ) {
+        driverIds.clear();
+        std::lock_guard<std::mutex> lock( m_inputMutex );
+        while ( driverIds.size() < numberOfDrivers && ! m_driverIds.empty() ) {
+            driverIds.push_back( m_driverIds.front() );
+            m_driverIds.pop_front();
+        }
+        return ! driverIds.empty();
+    }
+    
+    // Loads the files ahead of the workers. The last thread to finish closes the queue
+    void readAheadThreadFunction() {
+        DriverFileBatchLoader loader( m_fileLoading, m_batchSize );
+        std::vector<int> driverIds;
+        bool closed = false;
+        while ( ! closed && this->nextDrivers( m_batchSize, driverIds ) ) {
+            std::vector< DriverFileBatchLoader::LoadedDriver > batch;
+            try {
+                batch = loader.load( m_driversDirectory, driverIds );
+            }
+            catch ( ... ) {
+                // Every driver of the batch reports the error
+                batch.assign( driverIds.size(), DriverFileBatchLoader::LoadedDriver() );
+                for ( size_t i = 0; i < batch.size(); ++i ) batch[i].error = std::current_exception();
+            }
+            for ( size_t i = 0; i < batch.size() && ! closed; ++i )
+                closed = ! m_readAhead.push( batch[i] );
+        }
+        std::lock_guard<std::mutex> lock( m_inputMutex );
+        if ( --m_activeIOThreads == 0 ) m_readAhead.close();
+    }
+    
+    // The drivers not yet handed out
+    std::string m_driversDirectory;
+    std::list<int> m_driverIds;
+    size_t m_numberOfDrivers;
+    std::mutex m_inputMutex;
+    
+    // The drivers read ahead
+    BoundedQueue< DriverFileBatchLoader::LoadedDriver > m_readAhead;
+    size_t m_batchSize;
+    DriverFileBatchLoader::Backend m_fileLoading;
+    std::vector< std::thread > m_ioThreads;
+    int m_activeIOThreads;
+    
+    // The waiting time of the workers
+    double m_waitingTime;
+    mutable std::mutex m_timeMutex;
+};
+
+
+// Reports the time the workers spent waiting for data
+static void reportWaitingTime( const DriverFileSource& source,
+                               std::chrono::steady_clock::time_point start,
+                               int numberOfThreads )
+{
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double workerTime = elapsed.count() * numberOfThreads;
+    std::cout << "Time waiting for driver data : " << source.waitingTime() << " s ("
+              << ( workerTime > 0 ? 100 * source.waitingTime() / workerTime : 0 ) << "% of the worker time)" << std::endl;
+}
+
+
+// Loads the drivers into the fleet. The first error of any worker is kept for rethrowing after the join,
+// and stops the other workers at their next driver
+static void readThreadFunction( DriverFileSource* psource,
                                std::mutex* poutputMutex,
-                               std::vector< Driver* >* pdrivers,
+                               std::exception_ptr* perror,
+                               Fleet* pfleet,
                                ProcessLogger* plog )
 {
-    std::mutex& inputMutex = *pinputMutex;
-    std::list<std::string>& driverFiles = *pdriverFiles;
+    DriverFileSource& source = *psource;
     std::mutex& outputMutex = *poutputMutex;
-    std::vector< Driver* >& drivers = *pdrivers;
+    std::exception_ptr& error = *perror;
+    Fleet& fleet = *pfleet;
     ProcessLogger& log = *plog;
     
-    while (true) {
-        inputMutex.lock();
-        if ( driverFiles.empty() ) {
-            inputMutex.unlock();
-            break;
+    try {
+        while (true) {
+            std::shared_ptr< DriverTripDataMap > driverTripDataMap = source.next();
+            if ( ! driverTripDataMap ) break;
+            
+            Driver driver( driverTripDataMap->id() );
+            driver.loadTripData( driverTripDataMap );
+            
+            {
+                std::lock_guard<std::mutex> lock( outputMutex );
+                if ( error ) break;
+                fleet.add( std::move( driver ) );
+            }
+            
+            log.taskEnded();
         }
-        std::string driverFile = driverFiles.front();
-        driverFiles.pop_front();
-        inputMutex.unlock();
-        
-        size_t pos = driverFile.find( "/" );
-        
-        int driverId = 0;
-        std::istringstream isId( driverFile.substr(pos+1) );
-        isId >> driverId;
-        
-        DriverTripDataIO driverTripDataIO( driverId );
-        driverTripDataIO.readDataFromBinaryFile( driverFile.substr(0,pos) );
-        
-        Driver* driver = new Driver( driverTripDataIO.id() );
-        driver->loadTripData( driverTripDataIO.rawData() );
-        
-        outputMutex.lock();
-        drivers.push_back( driver );
-        outputMutex.unlock();
-        
-        log.taskEnded();
+    }
+    catch ( ... ) {
+        std::lock_guard<std::mutex> lock( outputMutex );
+        if ( ! error ) error = std::current_exception();
     }
 }
 
 
-std::vector< std::auto_ptr<Driver> >
+Fleet
 DriverDataProcessing::loadAllData( int numberOfThreads ) const
 {
-        // The driver vector
-    std::vector< Driver* > drivers;
-    DirectoryListing dirList( m_driversDirectory );
-    std::list<std::string> driverFiles = dirList.directoryContent();
-    for (std::list<std::string>::iterator iDriverFile = driverFiles.begin();
-         iDriverFile != driverFiles.end(); ++iDriverFile ) {
-        *iDriverFile = m_driversDirectory + "/" + *iDriverFile;
-    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    
+        // The loaded drivers
+    Fleet fleet;
+    DriverFileSource source( m_driversDirectory, m_readAheadDepth, m_numberOfIOThreads, m_fileLoading );
     
-    drivers.reserve( driverFiles.size() );
+    fleet.reserve( source.numberOfDrivers() );
     
-    std::mutex inputMutex; // Mutex for protecting the input driver list operations
-    std::mutex outputMutex; // Mutex for protecting the output driver vector operations
+    std::mutex outputMutex; // Mutex for protecting the fleet operations and the error
+    std::exception_ptr error; // The first error of the workers
     
-    ProcessLogger log( driverFiles.size(), "Loading all trips from all drivers : " );
+    ProcessLogger log( source.numberOfDrivers(), "Loading all trips from all drivers : " );
     
     std::vector<std::thread> threads;
     for ( int i = 0; i < numberOfThreads; ++i ) {
-        threads.push_back( std::thread( readThreadFunction, &inputMutex, &driverFiles, &outputMutex, &drivers, &log ) );
+        threads.push_back( std::thread( readThreadFunction, &source, &outputMutex, &error, &fleet, &log ) );
     }
     
     for ( int i = 0; i < numberOfThreads; ++i ) {
         threads[i].join();
     }
     
-    std::vector< std::auto_ptr<Driver> > result;
-    result.reserve( drivers.size() );
+    if ( error ) std::rethrow_exception( error );
     
-    for ( std::vector< Driver* >::iterator iDriverPtr = drivers.begin();
-         iDriverPtr != drivers.end(); ++iDriverPtr ) {
-        result.push_back( std::auto_ptr<Driver>(*iDriverPtr) );
-    }
+    reportWaitingTime( source, start, numberOfThreads );
     
-    return result;
+    return fleet;
 }
 
 
@@ -109,86 +270,79 @@ DriverDataProcessing::loadAllData( int numberOfThreads ) const
 
 
 
+// Calculates the trip metrics of the drivers. The first error of any worker is kept for rethrowing after the join,
+// and stops the other workers at their next driver
 static
-void metricsThreadFunction( std::mutex* pinputMutex,
-                           std::list<std::string>* pdriverFiles,
+void metricsThreadFunction( DriverFileSource* psource,
                            std::mutex* poutputMutex,
-                           std::vector< TripMetrics >* pmetrics,
+                           std::exception_ptr* perror,
+                           FeatureMatrix* pmetrics,
                            ProcessLogger* plog )
 {
-    std::mutex& inputMutex = *pinputMutex;
-    std::list<std::string>& driverFiles = *pdriverFiles;
+    DriverFileSource& source = *psource;
     std::mutex& outputMutex = *poutputMutex;
-    std::vector< TripMetrics >& metrics = *pmetrics;
+    std::exception_ptr& error = *perror;
+    FeatureMatrix& metrics = *pmetrics;
     ProcessLogger& log = *plog;
     
-    while (true) {
-        inputMutex.lock();
-        if ( driverFiles.empty() ) {
-            inputMutex.unlock();
-            break;
+    try {
+        while (true) {
+            std::shared_ptr< DriverTripDataMap > driverTripDataMap = source.next();
+            if ( ! driverTripDataMap ) break;
+            
+            Driver driver( driverTripDataMap->id() );
+            driver.loadTripData( driverTripDataMap );
+            
+            FeatureMatrix localMetrics = driver.tripMetrics();
+            
+            {
+                std::lock_guard<std::mutex> lock( outputMutex );
+                if ( error ) break;
+                metrics.append( localMetrics );
+            }
+            log.taskEnded();
         }
-        std::string driverFile = driverFiles.front();
-        driverFiles.pop_front();
-        inputMutex.unlock();
-        
-        size_t pos = driverFile.find( "/" );
-        
-        int driverId = 0;
-        std::istringstream isId( driverFile.substr(pos+1) );
-        isId >> driverId;
-        
-        DriverTripDataIO driverTripDataIO( driverId );
-        driverTripDataIO.readDataFromBinaryFile( driverFile.substr(0,pos) );
-        
-        Driver driver( driverTripDataIO.id() );
-        driver.loadTripData( driverTripDataIO.rawData() );
-        const std::vector< Trip >& trips = driver.trips();
-        
-        std::vector< TripMetrics > localMetrics = driver.tripMetrics();
-        
-        outputMutex.lock();
-        for ( std::vector< TripMetrics >::const_iterator iMetrics = localMetrics.begin();
-             iMetrics != localMetrics.end(); ++iMetrics )
-            metrics.push_back( *iMetrics );
-        outputMutex.unlock();
-        log.taskEnded();
+    }
+    catch ( ... ) {
+        std::lock_guard<std::mutex> lock( outputMutex );
+        if ( ! error ) error = std::current_exception();
     }
 }
 
 
 
 size_t
-DriverDataProcessing::produceTripMetrics( std::vector< TripMetrics >& outputData,
+DriverDataProcessing::produceTripMetrics( FeatureMatrix& outputData,
                                          int numberOfThreads ) const
 {
-        // The driver vector
-    DirectoryListing dirList( m_driversDirectory );
-    std::list<std::string> driverFiles = dirList.directoryContent();
-    for (std::list<std::string>::iterator iDriverFile = driverFiles.begin();
-         iDriverFile != driverFiles.end(); ++iDriverFile ) {
-        *iDriverFile = m_driversDirectory + "/" + *iDriverFile;
-    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
     
-    size_t numberOfDrivers = driverFiles.size();
+        // The driver files
+    DriverFileSource source( m_driversDirectory, m_readAheadDepth, m_numberOfIOThreads, m_fileLoading );
     
-    outputData.clear();
+    size_t numberOfDrivers = source.numberOfDrivers();
+    
+    outputData = FeatureMatrix();
     outputData.reserve( numberOfDrivers * 200 );
     
-    std::mutex inputMutex; // Mutex for protecting the input driver list operations
-    std::mutex outputMutex; // Mutex for protecting the output driver vector operations
+    std::mutex outputMutex; // Mutex for protecting the output driver vector operations and the error
+    std::exception_ptr error; // The first error of the workers
     
     ProcessLogger log( numberOfDrivers, "Producing trip metrics from all drivers : " );
     
     std::vector<std::thread> threads;
     for ( int i = 0; i < numberOfThreads; ++i ) {
-        threads.push_back( std::thread( metricsThreadFunction, &inputMutex, &driverFiles, &outputMutex, &outputData, &log ) );
+        threads.push_back( std::thread( metricsThreadFunction, &source, &outputMutex, &error, &outputData, &log ) );
     }
     
     for ( int i = 0; i < numberOfThreads; ++i ) {
         threads[i].join();
     }
     
+    if ( error ) std::rethrow_exception( error );
+    
+    reportWaitingTime( source, start, numberOfThreads );
+    
     return numberOfDrivers;
 }
 
@@ -208,36 +362,32 @@ DriverDataProcessing::scoreTrips( std::vector< std::tuple< long, long, double >
     const double signalProportion = 1.0 - backgroundProportion;
     
     // First calculate the trip metrics
-    std::vector< TripMetrics > tripMetrics;
+    FeatureMatrix tripMetrics;
     size_t numberOfDrivers = this->produceTripMetrics( tripMetrics, numberOfThreads );
     TripMetricsReference masterReference( tripMetrics, numberOfBinsBackground );
     
     ProcessLogger log( numberOfDrivers, "Calculating the trip scores from metrics : " );
     
     // For each driver construct the local reference and then score the trips within the metrics set.
-    long driverId = tripMetrics.front().driverId();
+    long driverId = tripMetrics.driverId( 0 );
     size_t startingIndex = 0;
-    for ( size_t i = 1; i < tripMetrics.size(); ++i ) {
+    for ( size_t i = 1; i < tripMetrics.numberOfRows(); ++i ) {
         
-        long currentDriverId = tripMetrics[i].driverId();
-        if ( currentDriverId == driverId && i < tripMetrics.size() - 1 )
+        long currentDriverId = tripMetrics.driverId( i );
+        if ( currentDriverId == driverId && i < tripMetrics.numberOfRows() - 1 )
             continue;
         
         size_t lastIndex = i - 1;
-        if ( i == tripMetrics.size() - 1 ) ++lastIndex;
-        
-        // Select the metrics of the driver
-        std::vector< TripMetrics > driverMetrics( tripMetrics.begin() + startingIndex, tripMetrics.begin() + lastIndex + 1 );
+        if ( i == tripMetrics.numberOfRows() - 1 ) ++lastIndex;
         
-        // Create the driver reference
-        TripMetricsReference driverReference ( driverMetrics, numberOfBinsDriver, masterReference );
+        // Create the driver reference from the rows of the driver
+        TripMetricsReference driverReference ( tripMetrics, startingIndex, lastIndex + 1, numberOfBinsDriver, masterReference );
         
         // Score the trips
-        for ( std::vector< TripMetrics >::const_iterator iTripMetrics = driverMetrics.begin();
-             iTripMetrics != driverMetrics.end(); ++iTripMetrics ) {
+        for ( size_t row = startingIndex; row <= lastIndex; ++row ) {
             
-            std::vector<double> scoreFromAll = masterReference.scoreMetrics( *iTripMetrics );
-            std::vector<double> scoreFromDriver = driverReference.scoreMetrics( *iTripMetrics );
+            std::vector<double> scoreFromAll = masterReference.scoreMetrics( tripMetrics, row );
+            std::vector<double> scoreFromDriver = driverReference.scoreMetrics( tripMetrics, row );
             
             if ( scoreFromDriver.size() != scoreFromAll.size() )
                 throw std::runtime_error( "DriverDataProcessing::scoreTrips : unequal sizes for reference and driver" );
@@ -253,7 +403,7 @@ DriverDataProcessing::scoreTrips( std::vector< std::tuple< long, long, double >
                     std::ostringstream os;
                     os << "DriverDataProcessing::scoreTrips : nan probability calculated!" << std::endl;
                     os << "   driver id       : " << driverId << std::endl;
-                    os << "   trip id         : " << iTripMetrics->tripId() << std::endl;
+                    os << "   trip id         : " << tripMetrics.tripId( row ) << std::endl;
                     os << "   iMetric         : " << iMetric << std::endl;
                     os << "   scoreFromDriver : " << scoreFromDriver[iMetric] << std::endl;
                     os << "   scoreFromAll    : " << scoreFromAll[iMetric] << std::endl;
@@ -268,7 +418,7 @@ DriverDataProcessing::scoreTrips( std::vector< std::tuple< long, long, double >
             
             score /= totalWeight;
             
-            long tripId = iTripMetrics->tripId();
+            long tripId = tripMetrics.tripId( row );
             
             output.push_back( std::make_tuple(driverId, tripId, score ) );
         }
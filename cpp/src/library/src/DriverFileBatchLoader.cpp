@@ -0,0 +1,519 @@
+#include "DriverFileBatchLoader.h"
+
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) && defined(__NR_io_uring_register)
+#define DRIVERFILEBATCHLOADER_IOURING
+#endif
+#endif
+#endif
+
+#ifdef DRIVERFILEBATCHLOADER_IOURING
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+
+// Returns the name of the binary file of a driver
+static std::string driverFileName( const std::string& driverDirectoryName, int driverId )
+{
+    std::ostringstream osFileName;
+    osFileName << driverDirectoryName << "/" << driverId << ".data";
+    return osFileName.str();
+}
+
+
+#ifdef DRIVERFILEBATCHLOADER_IOURING
+
+// The shared ring indices are read with acquire and written with release semantics
+static inline unsigned loadAcquire( const unsigned* p ) { return __atomic_load_n( p, __ATOMIC_ACQUIRE ); }
+static inline void storeRelease( unsigned* p, unsigned value ) { __atomic_store_n( p, value, __ATOMIC_RELEASE ); }
+
+
+// A minimal io_uring instance driven through the raw system calls
+class DriverFileBatchLoader::Ring {
+public:
+    // Sets up the ring. Throws if io_uring or one of the operations used is not available
+    explicit Ring( unsigned int entries );
+    
+    ~Ring();
+    
+    // Returns a cleared submission entry. Throws if the submission queue is full
+    io_uring_sqe* nextEntry();
+    
+    // Submits the pending entries and waits until at least the given number of completions are available
+    void submitAndWait( unsigned int numberOfCompletions );
+    
+    // Takes the next completion. Returns false if there is none
+    bool nextCompletion( io_uring_cqe& completion );
+    
+    // Gives up the operations of a failed batch. The entries not yet visible to the kernel are dropped, the
+    // others are submitted, and the completions of all the operations in flight are waited for and appended.
+    // Returns false if the kernel does not take or complete them, in which case they may still be in flight
+    bool abandon( std::vector< io_uring_cqe >& completions );
+
+private:
+    Ring( const Ring& );
+    Ring& operator=( const Ring& );
+    
+    // Releases the mappings and the ring
+    void release();
+    
+    int m_fd;
+    
+    void* m_sqRing;
+    size_t m_sqRingSize;
+    void* m_cqRing;
+    size_t m_cqRingSize;
+    io_uring_sqe* m_sqes;
+    size_t m_sqesSize;
+    
+    unsigned* m_sqHead;
+    unsigned* m_sqTail;
+    unsigned* m_sqMask;
+    unsigned* m_sqArray;
+    unsigned m_sqEntries;
+    unsigned m_prepared;   // Filled in but not yet visible to the kernel
+    unsigned m_pending;    // Visible to the kernel but not yet submitted
+    unsigned m_inFlight;   // Submitted, with the completion not yet taken
+    
+    unsigned* m_cqHead;
+    unsigned* m_cqTail;
+    unsigned* m_cqMask;
+    io_uring_cqe* m_cqes;
+};
+
+
+DriverFileBatchLoader::Ring::Ring( unsigned int entries ):
+  m_fd( -1 ),
+  m_sqRing( MAP_FAILED ), m_sqRingSize( 0 ),
+  m_cqRing( MAP_FAILED ), m_cqRingSize( 0 ),
+  m_sqes( 0 ), m_sqesSize( 0 ),
+  m_sqHead( 0 ), m_sqTail( 0 ), m_sqMask( 0 ), m_sqArray( 0 ), m_sqEntries( 0 ), m_prepared( 0 ), m_pending( 0 ), m_inFlight( 0 ),
+  m_cqHead( 0 ), m_cqTail( 0 ), m_cqMask( 0 ), m_cqes( 0 )
+{
+    io_uring_params parameters;
+    std::memset( &parameters, 0, sizeof(parameters) );
+    m_fd = static_cast<int>( syscall( __NR_io_uring_setup, entries, &parameters ) );
+    if ( m_fd < 0 )
+        throw std::runtime_error( "DriverFileBatchLoader : io_uring is not available" );
+    
+    try {
+        // Check that the kernel knows the operations used
+        std::vector<char> probeBuffer( sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0 );
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>( probeBuffer.data() );
+        if ( syscall( __NR_io_uring_register, m_fd, IORING_REGISTER_PROBE, probe, 256 ) < 0 )
+            throw std::runtime_error( "DriverFileBatchLoader : io_uring probing is not available" );
+        const unsigned char operations[] = { IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE };
+        for ( size_t i = 0; i < sizeof(operations); ++i ) {
+            if ( operations[i] > probe->last_op || ! ( probe->ops[ operations[i] ].flags & IO_URING_OP_SUPPORTED ) )
+                throw std::runtime_error( "DriverFileBatchLoader : io_uring operation not supported" );
+        }
+        
+        // Map the queues
+        m_sqRingSize = parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned);
+        m_cqRingSize = parameters.cq_off.cqes + parameters.cq_entries * sizeof(io_uring_cqe);
+        const bool singleMapping = ( parameters.features & IORING_FEAT_SINGLE_MMAP ) != 0;
+        if ( singleMapping ) m_sqRingSize = m_cqRingSize = std::max( m_sqRingSize, m_cqRingSize );
+        
+        m_sqRing = mmap( 0, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING );
+        if ( m_sqRing == MAP_FAILED )
+            throw std::runtime_error( "DriverFileBatchLoader : could not map the io_uring submission queue" );
+        if ( singleMapping ) {
+            m_cqRing = m_sqRing;
+        }
+        else {
+            m_cqRing = mmap( 0, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING );
+            if ( m_cqRing == MAP_FAILED )
+                throw std::runtime_error( "DriverFileBatchLoader : could not map the io_uring completion queue" );
+        }
+        m_sqesSize = parameters.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = mmap( 0, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES );
+        if ( sqes == MAP_FAILED )
+            throw std::runtime_error( "DriverFileBatchLoader : could not map the io_uring submission entries" );
+        m_sqes = static_cast<io_uring_sqe*>( sqes );
+    }
+    catch ( ... ) {
+        this->release();
+        throw;
+    }
+    
+    char* sqRing = static_cast<char*>( m_sqRing );
+    m_sqHead = reinterpret_cast<unsigned*>( sqRing + parameters.sq_off.head );
+    m_sqTail = reinterpret_cast<unsigned*>( sqRing + parameters.sq_off.tail );
+    m_sqMask = reinterpret_cast<unsigned*>( sqRing + parameters.sq_off.ring_mask );
+    m_sqArray = reinterpret_cast<unsigned*>( sqRing + parameters.sq_off.array );
+    m_sqEntries = parameters.sq_entries;
+    
+    char* cqRing = static_cast<char*>( m_cqRing );
+    m_cqHead = reinterpret_cast<unsigned*>( cqRing + parameters.cq_off.head );
+    m_cqTail = reinterpret_cast<unsigned*>( cqRing + parameters.cq_off.tail );
+    m_cqMask = reinterpret_cast<unsigned*>( cqRing + parameters.cq_off.ring_mask );
+    m_cqes = reinterpret_cast<io_uring_cqe*>( cqRing + parameters.cq_off.cqes );
+}
+
+
+DriverFileBatchLoader::Ring::~Ring()
+{
+    this->release();
+}
+
+
+void
+DriverFileBatchLoader::Ring::release()
+{
+    if ( m_sqes != 0 ) munmap( m_sqes, m_sqesSize );
+    if ( m_cqRing != MAP_FAILED && m_cqRing != m_sqRing ) munmap( m_cqRing, m_cqRingSize );
+    if ( m_sqRing != MAP_FAILED ) munmap( m_sqRing, m_sqRingSize );
+    if ( m_fd >= 0 ) close( m_fd );
+    m_sqes = 0;
+    m_cqRing = m_sqRing = MAP_FAILED;
+    m_fd = -1;
+}
+
+
+io_uring_sqe*
+DriverFileBatchLoader::Ring::nextEntry()
+{
+    const unsigned tail = *m_sqTail + m_prepared;
+    if ( tail - loadAcquire( m_sqHead ) >= m_sqEntries )
+        throw std::runtime_error( "DriverFileBatchLoader : io_uring submission queue full" );
+    const unsigned index = tail & *m_sqMask;
+    io_uring_sqe* entry = m_sqes + index;
+    std::memset( entry, 0, sizeof(io_uring_sqe) );
+    m_sqArray[index] = index;
+    ++m_prepared;
+    return entry;
+}
+
+
+void
+DriverFileBatchLoader::Ring::submitAndWait( unsigned int numberOfCompletions )
+{
+    // Publish the prepared entries
+    storeRelease( m_sqTail, *m_sqTail + m_prepared );
+    m_pending += m_prepared;
+    m_prepared = 0;
+    
+    while ( true ) {
+        long result = syscall( __NR_io_uring_enter, m_fd, m_pending, numberOfCompletions, IORING_ENTER_GETEVENTS, 0, 0 );
+        if ( result < 0 ) {
+            if ( errno == EINTR ) continue;
+            throw std::runtime_error( "DriverFileBatchLoader : io_uring submission failed" );
+        }
+        m_pending -= static_cast<unsigned>( result );
+        m_inFlight += static_cast<unsigned>( result );
+        if ( m_pending == 0 ) return;
+    }
+}
+
+
+bool
+DriverFileBatchLoader::Ring::nextCompletion( io_uring_cqe& completion )
+{
+    const unsigned head = *m_cqHead;
+    if ( head == loadAcquire( m_cqTail ) ) return false;
+    completion = m_cqes[ head & *m_cqMask ];
+    storeRelease( m_cqHead, head + 1 );
+    --m_inFlight;
+    return true;
+}
+
+
+bool
+DriverFileBatchLoader::Ring::abandon( std::vector< io_uring_cqe >& completions )
+{
+    m_prepared = 0;
+    io_uring_cqe completion;
+    while ( true ) {
+        while ( this->nextCompletion( completion ) ) completions.push_back( completion );
+        if ( m_pending == 0 && m_inFlight == 0 ) return true;
+        long result = syscall( __NR_io_uring_enter, m_fd, m_pending, 1, IORING_ENTER_GETEVENTS, 0, 0 );
+        if ( result < 0 ) {
+            if ( errno == EINTR || errno == EAGAIN || errno == EBUSY ) continue;
+            return false;
+        }
+        if ( result == 0 && m_inFlight == 0 ) return false;
+        m_pending -= static_cast<unsigned>( result );
+        m_inFlight += static_cast<unsigned>( result );
+    }
+}
+
+
+// The operation a completion belongs to is encoded in the lowest bits of the user data
+enum RingOperation { OpenOperation = 0, SizeOperation = 1, ReadOperation = 2, CloseOperation = 3 };
+
+static inline unsigned long long userData( unsigned int file, RingOperation operation )
+{
+    return ( static_cast<unsigned long long>( file ) << 2 ) | operation;
+}
+
+
+// Leaves the storage of a vector allocated for good, for operations of the kernel that may still write into it
+template< typename T >
+static void abandonToKernel( std::vector< T >& values )
+{
+    std::vector< T >* abandoned = new std::vector< T >();
+    abandoned->swap( values );
+}
+
+
+// Returns an error for a file from a negative result of an operation
+static std::exception_ptr fileError( const std::string& fileName, const char* what, int result )
+{
+    return std::make_exception_ptr( std::runtime_error( "DriverFileBatchLoader : could not " + std::string( what ) + " " +
+                                                        fileName + " : " + std::strerror( -result ) ) );
+}
+
+
+void
+DriverFileBatchLoader::loadBatch( const std::string& driverDirectoryName,
+                                  const int* driverIds, unsigned int numberOfDrivers,
+                                  LoadedDriver* results )
+{
+    std::vector< std::string > fileNames( numberOfDrivers );
+    std::vector< int > fds( numberOfDrivers, -1 );
+    std::vector< struct statx > fileStatus( numberOfDrivers );
+    std::vector< std::vector<char> > contents( numberOfDrivers );
+    std::vector< size_t > bytesRead( numberOfDrivers, 0 );
+    io_uring_cqe completion;
+    
+    try {
+        // Open and size all files
+        for ( unsigned int i = 0; i < numberOfDrivers; ++i ) {
+            fileNames[i] = driverFileName( driverDirectoryName, driverIds[i] );
+            
+            io_uring_sqe* entry = m_ring->nextEntry();
+            entry->opcode = IORING_OP_OPENAT;
+            entry->fd = AT_FDCWD;
+            entry->addr = reinterpret_cast<unsigned long long>( fileNames[i].c_str() );
+            entry->open_flags = O_RDONLY | O_CLOEXEC;
+            entry->user_data = userData( i, OpenOperation );
+            
+            entry = m_ring->nextEntry();
+            entry->opcode = IORING_OP_STATX;
+            entry->fd = AT_FDCWD;
+            entry->addr = reinterpret_cast<unsigned long long>( fileNames[i].c_str() );
+            entry->len = STATX_SIZE;
+            entry->off = reinterpret_cast<unsigned long long>( &fileStatus[i] );
+            entry->user_data = userData( i, SizeOperation );
+        }
+        m_ring->submitAndWait( 2 * numberOfDrivers );
+        for ( unsigned int numberOfCompletions = 0; numberOfCompletions < 2 * numberOfDrivers; ) {
+            if ( ! m_ring->nextCompletion( completion ) ) {
+                m_ring->submitAndWait( 1 );
+                continue;
+            }
+            ++numberOfCompletions;
+            const unsigned int i = static_cast<unsigned int>( completion.user_data >> 2 );
+            if ( ( completion.user_data & 3 ) == OpenOperation ) {
+                if ( completion.res >= 0 ) fds[i] = completion.res;
+                else if ( ! results[i].error ) results[i].error = fileError( fileNames[i], "open", completion.res );
+            }
+            else if ( completion.res < 0 && ! results[i].error ) {
+                results[i].error = fileError( fileNames[i], "stat", completion.res );
+            }
+        }
+        
+        // Read the files completely, resubmitting short reads
+        unsigned int readsInFlight = 0;
+        for ( unsigned int i = 0; i < numberOfDrivers; ++i ) {
+            if ( results[i].error || fds[i] < 0 ) continue;
+            if ( fileStatus[i].stx_size == 0 ) {
+                results[i].error = std::make_exception_ptr( std::runtime_error( "DriverFileBatchLoader : empty file " + fileNames[i] ) );
+                continue;
+            }
+            contents[i].resize( static_cast<size_t>( fileStatus[i].stx_size ) );
+            io_uring_sqe* entry = m_ring->nextEntry();
+            entry->opcode = IORING_OP_READ;
+            entry->fd = fds[i];
+            entry->addr = reinterpret_cast<unsigned long long>( contents[i].data() );
+            entry->len = static_cast<unsigned>( std::min( contents[i].size(), static_cast<size_t>( 1 ) << 30 ) );
+            entry->off = 0;
+            entry->user_data = userData( i, ReadOperation );
+            ++readsInFlight;
+        }
+        if ( readsInFlight > 0 ) m_ring->submitAndWait( 1 );
+        while ( readsInFlight > 0 ) {
+            if ( ! m_ring->nextCompletion( completion ) ) {
+                m_ring->submitAndWait( 1 );
+                continue;
+            }
+            --readsInFlight;
+            const unsigned int i = static_cast<unsigned int>( completion.user_data >> 2 );
+            if ( completion.res == -EINTR || completion.res == -EAGAIN ) {
+                // Retried below
+            }
+            else if ( completion.res < 0 ) {
+                results[i].error = fileError( fileNames[i], "read", completion.res );
+                continue;
+            }
+            else if ( completion.res == 0 ) {
+                results[i].error = std::make_exception_ptr( std::runtime_error( "DriverFileBatchLoader : file shrank while reading " + fileNames[i] ) );
+                continue;
+            }
+            else {
+                bytesRead[i] += completion.res;
+            }
+            if ( bytesRead[i] < contents[i].size() ) {
+                io_uring_sqe* entry = m_ring->nextEntry();
+                entry->opcode = IORING_OP_READ;
+                entry->fd = fds[i];
+                entry->addr = reinterpret_cast<unsigned long long>( contents[i].data() + bytesRead[i] );
+                entry->len = static_cast<unsigned>( std::min( contents[i].size() - bytesRead[i], static_cast<size_t>( 1 ) << 30 ) );
+                entry->off = bytesRead[i];
+                entry->user_data = userData( i, ReadOperation );
+                ++readsInFlight;
+                m_ring->submitAndWait( 0 );
+            }
+        }
+        
+        // Close the files
+        unsigned int closesInFlight = 0;
+        for ( unsigned int i = 0; i < numberOfDrivers; ++i ) {
+            if ( fds[i] < 0 ) continue;
+            io_uring_sqe* entry = m_ring->nextEntry();
+            entry->opcode = IORING_OP_CLOSE;
+            entry->fd = fds[i];
+            entry->user_data = userData( i, CloseOperation );
+            ++closesInFlight;
+        }
+        if ( closesInFlight > 0 ) m_ring->submitAndWait( closesInFlight );
+        while ( closesInFlight > 0 ) {
+            if ( ! m_ring->nextCompletion( completion ) ) {
+                m_ring->submitAndWait( 1 );
+                continue;
+            }
+            --closesInFlight;
+            fds[ completion.user_data >> 2 ] = -1;
+        }
+        
+    }
+    catch ( ... ) {
+        // The operations in flight point at the file names, the status and the contents: all of them complete
+        // before these are freed. Then the files left open are closed
+        std::vector< io_uring_cqe > completions;
+        if ( ! m_ring->abandon( completions ) ) {
+            abandonToKernel( fileNames );
+            abandonToKernel( fileStatus );
+            abandonToKernel( contents );
+            delete m_ring;
+            m_ring = 0;
+        }
+        for ( std::vector< io_uring_cqe >::const_iterator iCompletion = completions.begin(); iCompletion != completions.end(); ++iCompletion ) {
+            const unsigned int i = static_cast<unsigned int>( iCompletion->user_data >> 2 );
+            if ( ( iCompletion->user_data & 3 ) == OpenOperation && iCompletion->res >= 0 ) fds[i] = iCompletion->res;
+            else if ( ( iCompletion->user_data & 3 ) == CloseOperation ) fds[i] = -1;
+        }
+        for ( unsigned int i = 0; i < numberOfDrivers; ++i )
+            if ( fds[i] >= 0 ) close( fds[i] );
+        throw;
+    }
+    
+    // Index the trips
+    for ( unsigned int i = 0; i < numberOfDrivers; ++i ) {
+        if ( results[i].error ) continue;
+        try {
+            results[i].data = std::make_shared< DriverTripDataMap >( driverIds[i] );
+            results[i].data->loadFileContent( contents[i] );
+        }
+        catch ( ... ) {
+            results[i].data.reset();
+            results[i].error = std::current_exception();
+        }
+    }
+}
+
+#else
+
+// Without io_uring the ring is never created
+class DriverFileBatchLoader::Ring {};
+
+void
+DriverFileBatchLoader::loadBatch( const std::string&, const int*, unsigned int, LoadedDriver* )
+{
+    throw std::logic_error( "DriverFileBatchLoader : io_uring is not available on this platform" );
+}
+
+#endif
+
+
+DriverFileBatchLoader::DriverFileBatchLoader( Backend backend, unsigned int batchSize ):
+  m_ring( 0 ),
+  m_batchSize( std::max( 1U, std::min( batchSize, 1024U ) ) )
+{
+#ifdef DRIVERFILEBATCHLOADER_IOURING
+    if ( backend == IOUring ) {
+        // Every file needs two entries while opening; fall back to mapping if the ring cannot be set up
+        try {
+            m_ring = new Ring( 2 * m_batchSize );
+        }
+        catch ( std::exception& ) {
+            m_ring = 0;
+        }
+    }
+#else
+    (void) backend;
+#endif
+}
+
+
+DriverFileBatchLoader::~DriverFileBatchLoader()
+{
+    delete m_ring;
+}
+
+
+DriverFileBatchLoader::Backend
+DriverFileBatchLoader::backend() const
+{
+    return m_ring != 0 ? IOUring : MemoryMapping;
+}
+
+
+std::vector< DriverFileBatchLoader::LoadedDriver >
+DriverFileBatchLoader::load( const std::string& driverDirectoryName,
+                             const std::vector<int>& driverIds )
+{
+    std::vector< LoadedDriver > results( driverIds.size() );
+    
+    for ( size_t first = 0; first < driverIds.size(); first += m_batchSize ) {
+        const unsigned int numberOfDrivers = static_cast<unsigned int>( std::min( driverIds.size() - first, static_cast<size_t>( m_batchSize ) ) );
+        
+        // A failure of the ring fails every driver of the batch. The ring is dropped if it cannot be reused
+        if ( m_ring != 0 ) {
+            try {
+                this->loadBatch( driverDirectoryName, driverIds.data() + first, numberOfDrivers, results.data() + first );
+            }
+            catch ( ... ) {
+                for ( size_t i = first; i < first + numberOfDrivers; ++i ) {
+                    results[i].data.reset();
+                    results[i].error = std::current_exception();
+                }
+            }
+            continue;
+        }
+        
+        for ( size_t i = first; i < first + numberOfDrivers; ++i ) {
+            try {
+                results[i].data = std::make_shared< DriverTripDataMap >( driverIds[i] );
+                results[i].data->mapBinaryFile( driverDirectoryName );
+            }
+            catch ( ... ) {
+                results[i].data.reset();
+                results[i].error = std::current_exception();
+            }
+        }
+    }
+    return results;
+}
@@ -1,35 +1,204 @@
 #include "DriverTripDataIO.h"
+#include "DriverTripDataMap.h"
+#include "AlignedArray.h"
 #include "DirectoryListing.h"
+#include "TripDataCompression.h"
+#include "Checksum.h"
 
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <locale>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <stdint.h>
 
 #include <exception>
 
+// The signature of the raw binary files
+static const char rawSignature[8] = { 'A', 'X', 'A', 'D', 'R', 'I', 'V', 'R' };
+
+const uint32_t DriverTripDataIO::rawVersion;
+
 DriverTripDataIO::DriverTripDataIO( int driverId ):
   m_driverId( driverId ),
-  m_rawData()
+  m_rawData(),
+  m_numberOfSkippedRows( 0 ),
+  m_contentHash( 0 )
 {}
 
 DriverTripDataIO::~DriverTripDataIO()
 {}
 
 
+// Reads a trip csv file line by line through string streams. Returns the number of rows without a valid point
+static size_t readTripFileWithStreams( const std::string& tripFileName,
+                                       std::vector< std::pair< float, float > >& tripData )
+{
+    size_t numberOfSkippedRows = 0;
+    tripData.reserve(2000);
+    
+    // Open the file
+    std::ifstream inputFile( tripFileName );
+    // Create a line buffer
+    std::string lineBuffer;
+    std::getline( inputFile, lineBuffer );
+    
+    // Read the file and store the raw data
+    while ( std::getline( inputFile, lineBuffer ) ) {
+        float x,y;
+        char c;
+        std::istringstream is( lineBuffer );
+        // A row is two numbers separated by a comma, with nothing but white space after them
+        if ( is >> x >> c >> y && c == ',' && ! ( is >> c ) )
+            tripData.push_back( std::make_pair(x,y) );
+        else
+            ++numberOfSkippedRows;
+    }
+    
+    tripData.shrink_to_fit();
+    return numberOfSkippedRows;
+}
+
+
+// Powers of ten that are exact in single precision
+static const float exactPowersOfTen[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+inline static bool isNumberCharacter( char c )
+{
+    return ( c >= '0' && c <= '9' ) || c == '.' || c == '-' || c == '+' || c == 'e' || c == 'E';
+}
+
+// Parses the number in [begin,end) independently of the global locale.
+// Plain decimals with at most 24 bits of mantissa and 10 decimals are converted with a single
+// correctly rounded division, giving the same result as the stream parser. Anything else falls back to it.
+static bool parseFloat( const char* begin, const char* end, float& value )
+{
+    if ( begin == end ) return false;
+    
+    const char* p = begin;
+    bool negative = false;
+    if ( *p == '-' || *p == '+' ) {
+        negative = ( *p == '-' );
+        ++p;
+    }
+    
+    unsigned long mantissa = 0;
+    int numberOfDigits = 0;
+    int numberOfDecimals = 0;
+    bool decimalPointFound = false;
+    for ( ; p != end; ++p ) {
+        const char c = *p;
+        if ( c >= '0' && c <= '9' ) {
+            if ( numberOfDigits < 18 ) mantissa = mantissa * 10 + ( c - '0' );
+            ++numberOfDigits;
+            if ( decimalPointFound ) ++numberOfDecimals;
+        }
+        else if ( c == '.' && ! decimalPointFound ) {
+            decimalPointFound = true;
+        }
+        else break;
+    }
+    
+    if ( p == end && numberOfDigits > 0 && numberOfDigits <= 18 &&
+         mantissa < ( 1UL << 24 ) && numberOfDecimals <= 10 ) {
+        value = static_cast<float>( mantissa ) / exactPowersOfTen[numberOfDecimals];
+        if ( negative ) value = -value;
+        return true;
+    }
+    
+    // Exponents, long mantissas and malformed numbers. The whole field must be a number, as a valid prefix
+    // followed by more number characters, e.g. 1.2.3, is not a point for the stream parser either
+    std::istringstream is( std::string( begin, end ) );
+    is.imbue( std::locale::classic() );
+    is >> value;
+    return ! is.fail() && is.peek() == std::istringstream::traits_type::eof();
+}
+
+
+// Reads a trip csv file with a single read and parses it in place, continuing the hash with the file content.
+// Returns the number of rows without a valid point, which are skipped as by the stream parser
+static size_t readTripFileFast( const std::string& tripFileName,
+                                std::vector<char>& buffer,
+                                std::vector< std::pair< float, float > >& tripData,
+                                uint32_t& hash )
+{
+    size_t numberOfSkippedRows = 0;
+    std::ifstream inputFile( tripFileName, std::ios::in | std::ios::binary );
+    if (! inputFile.is_open() ) return numberOfSkippedRows;
+    inputFile.seekg( 0, std::ios::end );
+    const size_t fileSize = static_cast<size_t>( inputFile.tellg() );
+    inputFile.seekg( 0, std::ios::beg );
+    buffer.resize( fileSize );
+    inputFile.read( buffer.data(), fileSize );
+    
+    const char* p = buffer.data();
+    const char* end = p + inputFile.gcount();
+    hash = crc32c( p, end - p, hash );
+    
+    // Size the output by the number of lines
+    tripData.reserve( std::count( p, end, '\n' ) + 1 );
+    
+    // Skip the header line
+    p = std::find( p, end, '\n' );
+    
+    while ( p != end ) {
+        ++p;
+        // A final line break does not start a row
+        if ( p == end ) break;
+        const char* endOfLine = std::find( p, end, '\n' );
+        
+        while ( p != endOfLine && ( *p == ' ' || *p == '\t' ) ) ++p;
+        const char* xBegin = p;
+        while ( p != endOfLine && isNumberCharacter( *p ) ) ++p;
+        const char* xEnd = p;
+        while ( p != endOfLine && ( *p == ' ' || *p == '\t' ) ) ++p;
+        bool valid = false;
+        if ( p != endOfLine && *p == ',' ) {
+            ++p;
+            while ( p != endOfLine && ( *p == ' ' || *p == '\t' ) ) ++p;
+            const char* yBegin = p;
+            while ( p != endOfLine && isNumberCharacter( *p ) ) ++p;
+            const char* yEnd = p;
+            while ( p != endOfLine && ( *p == ' ' || *p == '\t' || *p == '\r' ) ) ++p;
+            
+            float x, y;
+            if ( p == endOfLine && parseFloat( xBegin, xEnd, x ) && parseFloat( yBegin, yEnd, y ) ) {
+                tripData.push_back( std::make_pair(x,y) );
+                valid = true;
+            }
+        }
+        if ( ! valid ) ++numberOfSkippedRows;
+        
+        p = endOfLine;
+    }
+    return numberOfSkippedRows;
+}
+
+
 DriverTripDataIO&
-DriverTripDataIO::readTripDataFromCSVFiles( const std::string& driverDirectoryName )
+DriverTripDataIO::readTripDataFromCSVFiles( const std::string& driverDirectoryName,
+                                            CSVParsing parsing )
 {
     m_rawData.clear();
     m_rawData.reserve(200);
+    m_numberOfSkippedRows = 0;
+    m_contentHash = 0;
     
     std::ostringstream osDriverDirectoryName;
     osDriverDirectoryName << driverDirectoryName << "/" << m_driverId;
     
+    // The file buffer for the fast parsing, reused for all trips
+    std::vector<char> buffer;
+    
+    // The trips keep the name ordering of the files, so that the binary files do not change
     DirectoryListing dirListing( osDriverDirectoryName.str() );
+    dirListing.setExtensionFilter( ".csv" );
     std::list<std::string> tripFileNames = dirListing.directoryContent();
     for (std::list<std::string>::const_iterator iTripFileName = tripFileNames.begin();
          iTripFileName != tripFileNames.end(); ++iTripFileName ) {
         std::vector< std::pair< float, float > > tripData;
-        tripData.reserve(2000);
         int tripId = 0;
         std::istringstream isTripId( *iTripFileName );
         isTripId >> tripId;
@@ -37,59 +206,114 @@ DriverTripDataIO::readTripDataFromCSVFiles( const std::string& driverDirectoryNa
         std::ostringstream osTripFileName;
         osTripFileName << driverDirectoryName << "/" << m_driverId << "/" << tripId << ".csv";
         
-        // Open the file
-        std::ifstream inputFile( osTripFileName.str() );
-        // Create a line buffer
-        std::string lineBuffer;
-        std::getline( inputFile, lineBuffer );
-        
-        // Read the file and store the raw data
-        while ( std::getline( inputFile, lineBuffer ) ) {
-            float x,y;
-            char c;
-            std::istringstream is( lineBuffer );
-            is >> x >> c >> y;
-            tripData.push_back( std::make_pair(x,y) );
+        if ( parsing == FastParsing ) {
+            m_contentHash = crc32c( iTripFileName->c_str(), iTripFileName->size() + 1, m_contentHash );
+            m_numberOfSkippedRows += readTripFileFast( osTripFileName.str(), buffer, tripData, m_contentHash );
+        }
+        else {
+            m_numberOfSkippedRows += readTripFileWithStreams( osTripFileName.str(), tripData );
         }
         
-        tripData.shrink_to_fit();
-        m_rawData.push_back( std::make_pair( tripId, tripData ) );
+        m_rawData.push_back( std::make_pair( tripId, std::move( tripData ) ) );
     }
     return *this;
 }
 
+// Appends the bytes of a value to a buffer
+template< typename T >
+inline static void appendValue( const T& value, std::vector<char>& buffer )
+{
+    const char* bytes = reinterpret_cast<const char*>( &value );
+    buffer.insert( buffer.end(), bytes, bytes + sizeof(value) );
+}
+
+// Copies a value of type T from a buffer, advancing the offset. Throws if the buffer is too short
+template< typename T >
+inline static T readValue( const char* data, size_t size, size_t& offset )
+{
+    if ( offset > size || size - offset < sizeof(T) )
+        throw std::runtime_error( "DriverTripDataIO : truncated file" );
+    T value;
+    std::memcpy( &value, data + offset, sizeof(T) );
+    offset += sizeof(T);
+    return value;
+}
+
+
 const DriverTripDataIO&
-DriverTripDataIO::writeDataToBinaryFile( const std::string& driverDirectoryName ) const
+DriverTripDataIO::writeDataToBinaryFile( const std::string& driverDirectoryName,
+                                         BinaryFormat format ) const
 {
-    // Open the output file
+    // Serialise the driver into a single buffer
+    std::vector<char> buffer;
+    if ( format == CompressedFormat ) {
+        compressDriverData( m_driverId, m_rawData, buffer );
+    }
+    else {
+        unsigned long numberOfTrips = m_rawData.size();
+        unsigned long numberOfValues = 0;
+        for ( unsigned long i = 0; i < numberOfTrips; ++ i )
+            numberOfValues += AlignedArray<float>::paddedSize( m_rawData[i].second.size() );
+        const size_t headerSize = sizeof(rawSignature) + sizeof(rawVersion) + sizeof(m_driverId) + sizeof(numberOfTrips) +
+            sizeof(numberOfValues) + numberOfTrips * ( 2 * sizeof(int) + sizeof(unsigned long) );
+        const size_t dataOffset = AlignedArray<char>::paddedSize( headerSize );
+        buffer.reserve( dataOffset + 2 * numberOfValues * sizeof(float) + 12 );
+        
+        // Write the signature and version, then the driver id, the number of trips and the number of values
+        buffer.insert( buffer.end(), rawSignature, rawSignature + sizeof(rawSignature) );
+        appendValue( rawVersion, buffer );
+        appendValue( m_driverId, buffer );
+        appendValue( numberOfTrips, buffer );
+        appendValue( numberOfValues, buffer );
+        
+        // Loop over the trips and write the trip id, the reserved value and the number of data points
+        for ( unsigned long i = 0; i < numberOfTrips; ++ i ) {
+            appendValue( m_rawData[i].first, buffer );
+            appendValue( int( 0 ), buffer );
+            unsigned long numberOfPoints = m_rawData[i].second.size();
+            appendValue( numberOfPoints, buffer );
+        }
+        
+        // Write the x values of all trips, then the y values, every trip starting on a cache line.
+        // The padding is zero
+        buffer.resize( dataOffset + 2 * numberOfValues * sizeof(float), 0 );
+        char* x = buffer.data() + dataOffset;
+        char* y = x + numberOfValues * sizeof(float);
+        for ( unsigned long i = 0; i < numberOfTrips; ++ i ) {
+            const std::vector< std::pair<float,float> >& tripData = m_rawData[i].second;
+            for ( size_t j = 0; j < tripData.size(); ++j ) {
+                std::memcpy( x + j * sizeof(float), &tripData[j].first, sizeof(float) );
+                std::memcpy( y + j * sizeof(float), &tripData[j].second, sizeof(float) );
+            }
+            x += AlignedArray<float>::paddedSize( tripData.size() ) * sizeof(float);
+            y += AlignedArray<float>::paddedSize( tripData.size() ) * sizeof(float);
+        }
+    }
+    appendChecksumTrailer( buffer );
+    
+    // Write to a temporary file and rename it, so that the file appears complete or not at all
     std::ostringstream osFileName;
     osFileName << driverDirectoryName << "/" << m_driverId << ".data";
+    const std::string fileName = osFileName.str();
+    const std::string temporaryFileName = fileName + ".tmp";
     
     std::ofstream outputFile;
-    outputFile.open( osFileName.str(), std::ios::out | std::ios::binary);
+    outputFile.open( temporaryFileName, std::ios::out | std::ios::binary);
     
     if (! outputFile.is_open() )
         throw std::runtime_error( "Could not open output file ");
     
-    // Write driver id and number of trips
-    outputFile.write( (const char*) &m_driverId, sizeof(m_driverId) );
-    unsigned long numberOfTrips = m_rawData.size();
-    outputFile.write( (const char*) &numberOfTrips, sizeof(numberOfTrips) );
-    
-    // Loop over the trips and write the trip id, the number of data points and the data points
-    for ( unsigned long i = 0; i < numberOfTrips; ++ i ) {
-        int tripId = m_rawData[i].first;
-        const std::vector< std::pair<float,float> >& tripData = m_rawData[i].second;
-        outputFile.write( (const char*) &tripId, sizeof(tripId) );
-        unsigned long numberOfPoints = tripData.size();
-        outputFile.write( (const char*) &numberOfPoints, sizeof(numberOfPoints) );
-        for ( unsigned long j = 0; j < numberOfPoints; ++j ) {
-            outputFile.write( (const char*) &tripData[j].first, sizeof(tripData[j].first) );
-            outputFile.write( (const char*) &tripData[j].second, sizeof(tripData[j].second) );
-        }
-    }
-    outputFile.flush();
+    outputFile.write( buffer.data(), buffer.size() );
     outputFile.close();
+    if ( outputFile.fail() ) {
+        std::remove( temporaryFileName.c_str() );
+        throw std::runtime_error( "DriverTripDataIO::writeDataToBinaryFile : could not write " + temporaryFileName );
+    }
+    
+    if ( std::rename( temporaryFileName.c_str(), fileName.c_str() ) != 0 ) {
+        std::remove( temporaryFileName.c_str() );
+        throw std::runtime_error( "DriverTripDataIO::writeDataToBinaryFile : could not rename " + temporaryFileName );
+    }
     
     return *this;
 }
@@ -109,29 +333,53 @@ DriverTripDataIO::readDataFromBinaryFile( const std::string& driverDirectoryName
     
     if (! inputFile.is_open() )
         throw std::runtime_error( "Could not open input file ");
-
-    // Read driver id and number of trips
-    inputFile.read( (char*) &m_driverId, sizeof(m_driverId) );
-    unsigned long numberOfTrips = 0;
-    inputFile.read( (char*) &numberOfTrips, sizeof(numberOfTrips) );
-    m_rawData.reserve( numberOfTrips );
     
-    // Loop over the trips and write the trip id, the number of data points and the data points
-    for ( unsigned long i = 0; i < numberOfTrips; ++ i ) {
-        int tripId = 0;
-        std::vector< std::pair<float,float> > tripData;
-        inputFile.read( ( char*) &tripId, sizeof(tripId) );
-        unsigned long numberOfPoints = 0;
-        inputFile.read( (char*) &numberOfPoints, sizeof(numberOfPoints) );
-        tripData.reserve( numberOfPoints );
-        for ( unsigned long j = 0; j < numberOfPoints; ++j ) {
-            float x, y;
-            inputFile.read( (char*) &x, sizeof(x) );
-            inputFile.read( (char*) &y, sizeof(y) );
-            tripData.push_back( std::make_pair(x,y) );
-        }
-        m_rawData.push_back(std::make_pair( tripId, tripData ) );
+    // Read the whole file in one go and verify the checksum
+    inputFile.seekg( 0, std::ios::end );
+    std::vector<char> buffer( static_cast<size_t>( inputFile.tellg() ) );
+    inputFile.seekg( 0, std::ios::beg );
+    inputFile.read( buffer.data(), buffer.size() );
+    if ( ! inputFile )
+        throw std::runtime_error( "DriverTripDataIO::readDataFromBinaryFile : could not read " + osFileName.str() );
+    
+    if ( isCompressedDriverData( buffer.data(), buffer.size() ) ) {
+        decompressDriverData( buffer.data(), verifyChecksum( buffer.data(), buffer.size() ), m_driverId, m_rawData );
+        return *this;
+    }
+    
+    // The raw formats are indexed by DriverTripDataMap
+    DriverTripDataMap dataMap( m_driverId );
+    dataMap.loadFileContent( buffer );
+    m_driverId = dataMap.id();
+    m_rawData.reserve( dataMap.numberOfTrips() );
+    for ( size_t i = 0; i < dataMap.numberOfTrips(); ++i ) {
+        const TripCoordinates& trip = dataMap.trip( i );
+        m_rawData.push_back( std::make_pair( dataMap.tripId( i ), std::vector< std::pair<float,float> >( trip.size() ) ) );
+        std::vector< std::pair<float,float> >& tripData = m_rawData.back().second;
+        for ( size_t j = 0; j < trip.size(); ++j ) tripData[j] = trip[j];
     }
     
     return *this;
 }
+
+
+uint32_t
+DriverTripDataIO::rawDataVersion( const char* data, size_t size, size_t& offset )
+{
+    offset = 0;
+    if ( size < sizeof(rawSignature) || std::memcmp( data, rawSignature, sizeof(rawSignature) ) != 0 ) return 0;
+    offset = sizeof(rawSignature);
+    const uint32_t version = readValue<uint32_t>( data, size, offset );
+    if ( version < 1 || version > rawVersion )
+        throw std::runtime_error( "DriverTripDataIO::rawDataVersion : unsupported version" );
+    return version;
+}
+
+
+size_t
+DriverTripDataIO::verifyChecksum( const char* data, size_t size )
+{
+    const bool versioned = isCompressedDriverData( data, size ) ? compressedDriverDataHasChecksum( data, size ) :
+        size >= sizeof(rawSignature) && std::memcmp( data, rawSignature, sizeof(rawSignature) ) == 0;
+    return verifyChecksumTrailer( data, size, versioned );
+}
@@ -0,0 +1,224 @@
+#include "DriverTripDataMap.h"
+#include "TripDataCompression.h"
+#include "DriverTripDataIO.h"
+#include "AlignedArray.h"
+
+#include <sstream>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+DriverTripDataMap::DriverTripDataMap( int driverId ):
+  m_driverId( driverId ),
+  m_address( 0 ),
+  m_size( 0 ),
+  m_fileContent(),
+  m_convertedData(),
+  m_tripIds(),
+  m_trips()
+{}
+
+DriverTripDataMap::~DriverTripDataMap()
+{
+    this->unmap();
+}
+
+
+void
+DriverTripDataMap::unmap()
+{
+    m_tripIds.clear();
+    m_trips.clear();
+    m_convertedData.reset();
+    this->releaseFileContent();
+}
+
+
+void
+DriverTripDataMap::releaseFileContent()
+{
+    std::vector<char>().swap( m_fileContent );
+    if ( m_address != 0 ) {
+        munmap( m_address, m_size );
+        m_address = 0;
+        m_size = 0;
+    }
+}
+
+
+// Copies a value of type T from the mapped data, advancing the offset. Throws if the file is too short.
+template< typename T >
+static T readValue( const char* data, size_t size, size_t& offset )
+{
+    if ( offset > size || size - offset < sizeof(T) )
+        throw std::runtime_error( "DriverTripDataMap : truncated file" );
+    T value;
+    std::memcpy( &value, data + offset, sizeof(T) );
+    offset += sizeof(T);
+    return value;
+}
+
+
+DriverTripDataMap&
+DriverTripDataMap::mapBinaryFile( const std::string& driverDirectoryName )
+{
+    this->unmap();
+    
+    std::ostringstream osFileName;
+    osFileName << driverDirectoryName << "/" << m_driverId << ".data";
+    
+    // Open and map the input file
+    int fd = open( osFileName.str().c_str(), O_RDONLY );
+    if ( fd < 0 )
+        throw std::runtime_error( "Could not open input file " );
+    
+    struct stat fileStatus;
+    if ( fstat( fd, &fileStatus ) != 0 || fileStatus.st_size == 0 ) {
+        close( fd );
+        throw std::runtime_error( "DriverTripDataMap::mapBinaryFile : could not determine the file size" );
+    }
+    
+    const size_t fileSize = static_cast<size_t>( fileStatus.st_size );
+    void* address = mmap( 0, fileSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+    close( fd );
+    if ( address == MAP_FAILED )
+        throw std::runtime_error( "DriverTripDataMap::mapBinaryFile : could not map the input file" );
+    
+    m_address = address;
+    m_size = fileSize;
+    madvise( m_address, m_size, MADV_SEQUENTIAL );
+    
+    try {
+        this->indexTrips( static_cast<const char*>( m_address ), m_size );
+    }
+    catch ( ... ) {
+        this->unmap();
+        throw;
+    }
+    
+    return *this;
+}
+
+
+DriverTripDataMap&
+DriverTripDataMap::loadFileContent( std::vector<char>& fileContent )
+{
+    this->unmap();
+    m_fileContent.swap( fileContent );
+    
+    try {
+        this->indexTrips( m_fileContent.data(), m_fileContent.size() );
+    }
+    catch ( ... ) {
+        this->unmap();
+        throw;
+    }
+    
+    return *this;
+}
+
+
+// Indexes the trips. The layouts are the ones written by DriverTripDataIO::writeDataToBinaryFile
+void
+DriverTripDataMap::indexTrips( const char* data, size_t fileSize )
+{
+    const size_t size = DriverTripDataIO::verifyChecksum( data, fileSize );
+    if ( isCompressedDriverData( data, size ) ) {
+        std::vector< std::pair< int, std::vector< std::pair<float,float> > > > decodedData;
+        decompressDriverData( data, size, m_driverId, decodedData );
+        std::vector< std::pair< int, TripDataView > > trips;
+        trips.reserve( decodedData.size() );
+        for ( std::vector< std::pair< int, std::vector< std::pair<float,float> > > >::const_iterator iTrip = decodedData.begin();
+             iTrip != decodedData.end(); ++iTrip )
+            trips.push_back( std::make_pair( iTrip->first, TripDataView( iTrip->second.data(), iTrip->second.size() ) ) );
+        this->convertTrips( trips );
+        return;
+    }
+    
+    size_t offset = 0;
+    if ( DriverTripDataIO::rawDataVersion( data, size, offset ) >= 2 ) {
+        this->indexSeparatedCoordinates( data, size, offset );
+        return;
+    }
+    
+    // The points of every trip are stored together
+    m_driverId = readValue<int>( data, size, offset );
+    unsigned long numberOfTrips = readValue<unsigned long>( data, size, offset );
+    if ( numberOfTrips > size )
+        throw std::runtime_error( "DriverTripDataMap : truncated file" );
+    std::vector< std::pair< int, TripDataView > > trips;
+    trips.reserve( numberOfTrips );
+    
+    for ( unsigned long i = 0; i < numberOfTrips; ++i ) {
+        int tripId = readValue<int>( data, size, offset );
+        unsigned long numberOfPoints = readValue<unsigned long>( data, size, offset );
+        if ( numberOfPoints > ( size - offset ) / sizeof( std::pair<float,float> ) )
+            throw std::runtime_error( "DriverTripDataMap : truncated file" );
+        const std::pair<float,float>* points = reinterpret_cast< const std::pair<float,float>* >( data + offset );
+        trips.push_back( std::make_pair( tripId, TripDataView( points, numberOfPoints ) ) );
+        offset += numberOfPoints * sizeof( std::pair<float,float> );
+    }
+    this->convertTrips( trips );
+}
+
+
+void
+DriverTripDataMap::indexSeparatedCoordinates( const char* data, size_t size, size_t offset )
+{
+    m_driverId = readValue<int>( data, size, offset );
+    unsigned long numberOfTrips = readValue<unsigned long>( data, size, offset );
+    unsigned long numberOfValues = readValue<unsigned long>( data, size, offset );
+    if ( numberOfTrips > size )
+        throw std::runtime_error( "DriverTripDataMap : truncated file" );
+    
+    // The trip ids and sizes, and the offsets of the trips in the x and y blocks
+    std::vector< size_t > tripOffsets;
+    std::vector< size_t > tripSizes;
+    tripOffsets.reserve( numberOfTrips );
+    tripSizes.reserve( numberOfTrips );
+    m_tripIds.reserve( numberOfTrips );
+    size_t totalSize = 0;
+    for ( unsigned long i = 0; i < numberOfTrips; ++i ) {
+        m_tripIds.push_back( readValue<int>( data, size, offset ) );
+        readValue<int>( data, size, offset );
+        unsigned long numberOfPoints = readValue<unsigned long>( data, size, offset );
+        if ( numberOfPoints > numberOfValues - totalSize ||
+             AlignedArray<float>::paddedSize( numberOfPoints ) > numberOfValues - totalSize )
+            throw std::runtime_error( "DriverTripDataMap : the trip sizes do not add up to the number of values" );
+        tripOffsets.push_back( totalSize );
+        tripSizes.push_back( numberOfPoints );
+        totalSize += AlignedArray<float>::paddedSize( numberOfPoints );
+    }
+    if ( totalSize != numberOfValues )
+        throw std::runtime_error( "DriverTripDataMap : the trip sizes do not add up to the number of values" );
+    
+    // The x block starts on the next cache line and is followed by the y block
+    const size_t dataOffset = AlignedArray<char>::paddedSize( offset );
+    if ( dataOffset > size || ( size - dataOffset ) % ( 2 * sizeof(float) ) != 0 ||
+         ( size - dataOffset ) / ( 2 * sizeof(float) ) != numberOfValues )
+        throw std::runtime_error( "DriverTripDataMap : truncated file" );
+    const float* x = reinterpret_cast< const float* >( data + dataOffset );
+    const float* y = x + numberOfValues;
+    m_trips.reserve( numberOfTrips );
+    for ( unsigned long i = 0; i < numberOfTrips; ++i )
+        m_trips.push_back( TripCoordinates( x + tripOffsets[i], y + tripOffsets[i], tripSizes[i] ) );
+}
+
+
+void
+DriverTripDataMap::convertTrips( const std::vector< std::pair< int, TripDataView > >& trips )
+{
+    m_convertedData = std::make_shared< const TripStore >( trips );
+    this->releaseFileContent();
+    m_tripIds.reserve( m_convertedData->numberOfTrips() );
+    m_trips.reserve( m_convertedData->numberOfTrips() );
+    for ( size_t i = 0; i < m_convertedData->numberOfTrips(); ++i ) {
+        m_tripIds.push_back( m_convertedData->tripId( i ) );
+        m_trips.push_back( m_convertedData->trip( i ) );
+    }
+}
@@ -0,0 +1,244 @@
+#include "FastMath.h"
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <stdint.h>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static const double pi = std::atan( 1.0 ) * 4;
+
+// The coefficients of atan( a ) / a as a polynomial of a^2, for a in [0, 1]. They are the Chebyshev interpolation
+// of degree 11, within 7.1e-11 of the function relative to it
+static const double atanCoefficients[] = {
+    0.99999999992930366,
+    -0.33333331290889995,
+    0.19999901102171863,
+    -0.14283813255747427,
+    0.11091922963713408,
+    -0.089741719584896892,
+    0.072282783457077934,
+    -0.053956680577002203,
+    0.033826218959009502,
+    -0.015828322753461539,
+    0.0047324841951261005,
+    -0.00066339545740371853
+};
+
+// The coefficients of atanh( t ) / t as a polynomial of t^2, for |t| up to ( sqrt(2) - 1 ) / ( sqrt(2) + 1 ).
+// They are the Chebyshev interpolation of degree 5, within 2.7e-14 of the function relative to it
+static const double atanhCoefficients[] = {
+    0.99999999999997358,
+    0.33333333339789634,
+    0.19999997445913797,
+    0.14286083073171971,
+    0.11087124946824754,
+    0.098040479135672542
+};
+
+#if defined(__GNUC__) && !defined(__clang__)
+// GCC keeps the selects of the fast loops as branches unless the floating point exceptions may be ignored,
+// which clang does by default
+#define FASTMATH_VECTORISED __attribute__(( optimize( "no-trapping-math" ) ))
+#else
+#define FASTMATH_VECTORISED
+#endif
+
+// The functions of the single values are inlined into the loops of every instruction set
+#define FASTMATH_INLINE FASTMATH_VECTORISED __attribute__(( always_inline ))
+
+#if ( defined(__x86_64__) || defined(__i386__) ) && defined(__GNUC__)
+#define FASTMATH_X86
+// The polynomials are evaluated with fused multiply-adds where the processor has them, which halves the time
+// of the loops and only makes them more accurate. The fast results thus depend on the processor
+#define FASTMATH_TARGET( isa ) FASTMATH_VECTORISED __attribute__(( target( isa ) ))
+#endif
+
+// 2^52, which scales the subnormal values into the normal range
+static const double subnormalScale = 4503599627370496.0;
+
+// The constants of the logarithms
+static const double sqrt2 = std::sqrt( 2.0 );
+static const double log10Of2 = std::log10( 2.0 );
+static const double log10OfE = 1 / std::log( 10.0 );
+
+
+// The fast atan2 of a pair. The angle of the smaller over the larger absolute value, in [0, pi/4], is mirrored
+// into the octant. The mirrors select constants rather than results, so that the loops have no branches and vectorise
+FASTMATH_INLINE static inline double
+fastAtan2( double y, double x )
+{
+    const double ax = std::fabs( x );
+    const double ay = std::fabs( y );
+    const bool steep = ax < ay;
+    const double larger = steep ? ay : ax;
+    const double smaller = steep ? ax : ay;
+    const double a = smaller / ( larger > 0 ? larger : 1 );
+    const double s = a * a;
+    double p = atanCoefficients[11];
+    p = p * s + atanCoefficients[10];
+    p = p * s + atanCoefficients[9];
+    p = p * s + atanCoefficients[8];
+    p = p * s + atanCoefficients[7];
+    p = p * s + atanCoefficients[6];
+    p = p * s + atanCoefficients[5];
+    p = p * s + atanCoefficients[4];
+    p = p * s + atanCoefficients[3];
+    p = p * s + atanCoefficients[2];
+    p = p * s + atanCoefficients[1];
+    p = p * s + atanCoefficients[0];
+    double angle = ( steep ? pi / 2 : 0.0 ) + ( steep ? -a : a ) * p;
+    const bool backwards = std::copysign( 1.0, x ) < 0;
+    angle = ( backwards ? pi : 0.0 ) + ( backwards ? -1.0 : 1.0 ) * angle;
+    return std::copysign( angle, y );
+}
+
+
+// The fast log10 of a value. v = 2^e m with m in [sqrt(1/2), sqrt(2)), and ln m = 2 atanh( t ) with
+// t = ( m - 1 ) / ( m + 1 ). The exponent is turned into a double through the bits of 2^52 + e, which vectorises
+// where a conversion does not
+FASTMATH_INLINE static inline double
+fastLog10( double value )
+{
+    const bool subnormal = value < DBL_MIN;
+    const double scaled = value * ( subnormal ? subnormalScale : 1.0 );
+    uint64_t bits;
+    std::memcpy( &bits, &scaled, sizeof(bits) );
+    uint64_t exponentBits = ( bits >> 52 & 0x7ff ) | 0x4330000000000000ULL;
+    double exponent;
+    std::memcpy( &exponent, &exponentBits, sizeof(exponent) );
+    exponent -= subnormalScale + 1023 + ( subnormal ? 52 : 0 );
+    bits = ( bits & 0x000fffffffffffffULL ) | 0x3ff0000000000000ULL;
+    double m;
+    std::memcpy( &m, &bits, sizeof(m) );
+    const bool high = m > sqrt2;
+    m *= high ? 0.5 : 1.0;
+    exponent += high ? 1 : 0;
+
+    const double t = ( m - 1 ) / ( m + 1 );
+    const double u = t * t;
+    double p = atanhCoefficients[5];
+    p = p * u + atanhCoefficients[4];
+    p = p * u + atanhCoefficients[3];
+    p = p * u + atanhCoefficients[2];
+    p = p * u + atanhCoefficients[1];
+    p = p * u + atanhCoefficients[0];
+    double logarithm = exponent * log10Of2 + 2 * t * p * log10OfE;
+
+    // Zeros, negative values, infinity and NaN
+    logarithm = value > 0 ? logarithm : ( value == 0 ? -HUGE_VAL : NAN );
+    return value <= DBL_MAX ? logarithm : value;
+}
+
+
+// The loops of the fast functions, vectorised for the instruction set of each loop
+
+FASTMATH_VECTORISED static void
+fastAtan2Loop( const double* y, const double* x, size_t n, double* result )
+{
+    for ( size_t i = 0; i < n; ++i ) result[i] = fastAtan2( y[i], x[i] );
+}
+
+
+FASTMATH_VECTORISED static void
+fastLog10Loop( const double* values, size_t n, double* result )
+{
+    for ( size_t i = 0; i < n; ++i ) result[i] = fastLog10( values[i] );
+}
+
+
+#ifdef FASTMATH_X86
+
+FASTMATH_TARGET( "avx2,fma" ) static void
+fastAtan2AVX2( const double* y, const double* x, size_t n, double* result )
+{
+    for ( size_t i = 0; i < n; ++i ) result[i] = fastAtan2( y[i], x[i] );
+}
+
+
+FASTMATH_TARGET( "avx2,fma" ) static void
+fastLog10AVX2( const double* values, size_t n, double* result )
+{
+    for ( size_t i = 0; i < n; ++i ) result[i] = fastLog10( values[i] );
+}
+
+
+FASTMATH_TARGET( "avx512f" ) static void
+fastAtan2AVX512( const double* y, const double* x, size_t n, double* result )
+{
+    for ( size_t i = 0; i < n; ++i ) result[i] = fastAtan2( y[i], x[i] );
+}
+
+
+FASTMATH_TARGET( "avx512f" ) static void
+fastLog10AVX512( const double* values, size_t n, double* result )
+{
+    for ( size_t i = 0; i < n; ++i ) result[i] = fastLog10( values[i] );
+}
+
+#endif
+
+
+// The loops for the best instruction set of the processor
+typedef void (*Atan2Loop)( const double*, const double*, size_t, double* );
+typedef void (*Log10Loop)( const double*, size_t, double* );
+
+static std::pair< Atan2Loop, Log10Loop >
+bestLoops()
+{
+#ifdef FASTMATH_X86
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports( "avx512f" ) ) return std::make_pair( fastAtan2AVX512, fastLog10AVX512 );
+    if ( __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" ) ) return std::make_pair( fastAtan2AVX2, fastLog10AVX2 );
+#endif
+    return std::make_pair( fastAtan2Loop, fastLog10Loop );
+}
+
+static const std::pair< Atan2Loop, Log10Loop > fastLoops = bestLoops();
+
+
+std::atomic< FastMath::Mode > FastMath::s_mode( FastMath::Exact );
+
+void
+FastMath::setMode( Mode mode )
+{
+    s_mode = mode;
+}
+
+
+const char*
+FastMath::name( Mode mode )
+{
+    return mode == Fast ? "fast" : "exact";
+}
+
+
+void
+FastMath::atan2( const double* y, const double* x, size_t n, double* result, Mode mode )
+{
+    if ( mode == Fast ) fastLoops.first( y, x, n, result );
+    else for ( size_t i = 0; i < n; ++i ) result[i] = std::atan2( y[i], x[i] );
+}
+
+
+void
+FastMath::sqrt( const double* values, size_t n, double* result, Mode )
+{
+    // The compilers keep the calls of std::sqrt for errno, so the square roots are vectorised by hand
+    size_t i = 0;
+#ifdef __SSE2__
+    for ( ; i + 2 <= n; i += 2 ) _mm_storeu_pd( result + i, _mm_sqrt_pd( _mm_loadu_pd( values + i ) ) );
+#endif
+    for ( ; i < n; ++i ) result[i] = std::sqrt( values[i] );
+}
+
+
+void
+FastMath::log10( const double* values, size_t n, double* result, Mode mode )
+{
+    if ( mode == Fast ) fastLoops.second( values, n, result );
+    else for ( size_t i = 0; i < n; ++i ) result[i] = std::log10( values[i] );
+}
@@ -0,0 +1,155 @@
+#include "FeatureMatrix.h"
+#include "TripMetrics.h"
+#include <ostream>
+#include <cmath>
+#include <stdexcept>
+
+FeatureMatrix::FeatureMatrix():
+  m_driverIds(),
+  m_tripIds(),
+  m_flags( numberOfBinaryMetrics() ),
+  m_flagsDefined( numberOfBinaryMetrics() ),
+  m_features( numberOfFeatures() )
+{}
+
+
+FeatureMatrix::~FeatureMatrix()
+{}
+
+
+size_t
+FeatureMatrix::numberOfMetrics()
+{
+    return TripMetrics::descriptions().size();
+}
+
+
+size_t
+FeatureMatrix::numberOfBinaryMetrics()
+{
+    return static_cast<size_t>( TripMetrics::numberOfBinaryMetrics() );
+}
+
+
+size_t
+FeatureMatrix::numberOfFeatures()
+{
+    return numberOfMetrics() - numberOfBinaryMetrics();
+}
+
+
+void
+FeatureMatrix::pushBit( std::vector< uint64_t >& bits, size_t i, bool value )
+{
+    if ( i % 64 == 0 ) bits.push_back( 0 );
+    if ( value ) bits.back() |= uint64_t( 1 ) << ( i % 64 );
+}
+
+
+FeatureMatrix&
+FeatureMatrix::reserve( size_t numberOfRows )
+{
+    m_driverIds.reserve( numberOfRows );
+    m_tripIds.reserve( numberOfRows );
+    for ( size_t i = 0; i < m_flags.size(); ++i ) {
+        m_flags[i].reserve( ( numberOfRows + 63 ) / 64 );
+        m_flagsDefined[i].reserve( ( numberOfRows + 63 ) / 64 );
+    }
+    for ( size_t i = 0; i < m_features.size(); ++i )
+        m_features[i].reserve( numberOfRows );
+    return *this;
+}
+
+
+FeatureMatrix&
+FeatureMatrix::appendRow( long driverId, long tripId, const std::vector<double>& values )
+{
+    if ( values.size() != numberOfMetrics() )
+        throw std::runtime_error( "FeatureMatrix::appendRow : invalid number of metrics" );
+
+    const size_t row = this->numberOfRows();
+    m_driverIds.push_back( driverId );
+    m_tripIds.push_back( tripId );
+    for ( size_t i = 0; i < m_flags.size(); ++i ) {
+        pushBit( m_flagsDefined[i], row, ! std::isnan( values[i] ) );
+        pushBit( m_flags[i], row, values[i] == 1 );
+    }
+    for ( size_t i = 0; i < m_features.size(); ++i )
+        m_features[i].push_back( values[m_flags.size() + i] );
+    return *this;
+}
+
+
+FeatureMatrix&
+FeatureMatrix::append( const FeatureMatrix& other )
+{
+    const size_t firstRow = this->numberOfRows();
+    m_driverIds.insert( m_driverIds.end(), other.m_driverIds.begin(), other.m_driverIds.end() );
+    m_tripIds.insert( m_tripIds.end(), other.m_tripIds.begin(), other.m_tripIds.end() );
+    for ( size_t i = 0; i < m_flags.size(); ++i ) {
+        for ( size_t row = 0; row < other.numberOfRows(); ++row ) {
+            pushBit( m_flagsDefined[i], firstRow + row, other.flagDefined( row, i ) );
+            pushBit( m_flags[i], firstRow + row, other.flag( row, i ) );
+        }
+    }
+    for ( size_t i = 0; i < m_features.size(); ++i )
+        m_features[i].insert( m_features[i].end(), other.m_features[i].begin(), other.m_features[i].end() );
+    return *this;
+}
+
+
+FeatureMatrix
+FeatureMatrix::selectRows( const std::vector< size_t >& rows ) const
+{
+    FeatureMatrix result;
+    result.reserve( rows.size() );
+    for ( size_t row = 0; row < rows.size(); ++row ) {
+        result.m_driverIds.push_back( m_driverIds[ rows[row] ] );
+        result.m_tripIds.push_back( m_tripIds[ rows[row] ] );
+    }
+    for ( size_t i = 0; i < m_flags.size(); ++i ) {
+        for ( size_t row = 0; row < rows.size(); ++row ) {
+            pushBit( result.m_flagsDefined[i], row, this->flagDefined( rows[row], i ) );
+            pushBit( result.m_flags[i], row, this->flag( rows[row], i ) );
+        }
+    }
+    for ( size_t i = 0; i < m_features.size(); ++i ) {
+        const std::vector< double >& column = m_features[i];
+        std::vector< double >& resultColumn = result.m_features[i];
+        for ( size_t row = 0; row < rows.size(); ++row )
+            resultColumn.push_back( column[ rows[row] ] );
+    }
+    return result;
+}
+
+
+double
+FeatureMatrix::value( size_t row, size_t metric ) const
+{
+    if ( metric >= m_flags.size() ) return m_features[metric - m_flags.size()][row];
+    if ( ! this->flagDefined( row, metric ) ) return NAN;
+    return this->flag( row, metric ) ? 1 : 0;
+}
+
+
+std::ostream&
+FeatureMatrix::writeDescriptions( std::ostream& out )
+{
+    const std::vector< std::string >& descriptions = TripMetrics::descriptions();
+    for (size_t i = 0; i < descriptions.size(); ++i ) {
+        if (i > 0 ) out << " ";
+        out << descriptions[i];
+    }
+    return out;
+}
+
+
+std::ostream&
+FeatureMatrix::writeRow( std::ostream& out, size_t row ) const
+{
+    for (size_t i = 0; i < numberOfMetrics(); ++i ) {
+        if (i > 0 ) out << " ";
+        out << this->value( row, i );
+    }
+    return out;
+}
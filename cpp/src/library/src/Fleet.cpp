@@ -0,0 +1,95 @@
+#include "Fleet.h"
+#include <sstream>
+#include <stdexcept>
+
+Fleet::Fleet():
+  m_drivers(),
+  m_driverIndex(),
+  m_trips()
+{}
+
+
+Fleet::Fleet( Fleet&& rhs ) noexcept:
+  m_drivers( std::move( rhs.m_drivers ) ),
+  m_driverIndex( std::move( rhs.m_driverIndex ) ),
+  m_trips( std::move( rhs.m_trips ) )
+{}
+
+
+Fleet&
+Fleet::operator=( Fleet&& rhs ) noexcept
+{
+    if ( this != &rhs ) {
+        m_drivers = std::move( rhs.m_drivers );
+        m_driverIndex = std::move( rhs.m_driverIndex );
+        m_trips = std::move( rhs.m_trips );
+    }
+    return *this;
+}
+
+
+Fleet::~Fleet()
+{}
+
+
+Fleet&
+Fleet::reserve( size_t numberOfDrivers, size_t numberOfTrips )
+{
+    m_drivers.reserve( numberOfDrivers );
+    m_driverIndex.reserve( numberOfDrivers );
+    if ( numberOfTrips > 0 ) m_trips.reserve( numberOfTrips );
+    return *this;
+}
+
+
+const Driver&
+Fleet::add( Driver&& driver )
+{
+    if ( m_driverIndex.find( driver.id() ) != m_driverIndex.end() ) {
+        std::ostringstream os;
+        os << "Driver " << driver.id() << " is already in the fleet";
+        throw std::runtime_error( os.str() );
+    }
+
+        // Reserve the keys of the trips before taking over the driver. A duplicate trip id leaves the fleet
+        // and the driver as they were
+    const std::vector< Trip >& trips = driver.trips();
+    for ( std::vector< Trip >::const_iterator iTrip = trips.begin(); iTrip != trips.end(); ++iTrip ) {
+        if ( ! m_trips.insert( std::make_pair( tripKey( driver.id(), iTrip->id() ), static_cast< const Trip* >( 0 ) ) ).second ) {
+            std::ostringstream os;
+            os << "Trip " << iTrip->id() << " of driver " << driver.id() << " appears more than once";
+            for ( std::vector< Trip >::const_iterator iAdded = trips.begin(); iAdded != iTrip; ++iAdded )
+                m_trips.erase( tripKey( driver.id(), iAdded->id() ) );
+            throw std::runtime_error( os.str() );
+        }
+    }
+
+    m_drivers.push_back( std::unique_ptr< Driver >( new Driver( std::move( driver ) ) ) );
+    const Driver& newDriver = *m_drivers.back();
+
+        // Index the trips at their places in the driver held by the fleet
+    const std::vector< Trip >& newTrips = newDriver.trips();
+    for ( std::vector< Trip >::const_iterator iTrip = newTrips.begin(); iTrip != newTrips.end(); ++iTrip )
+        m_trips[ tripKey( newDriver.id(), iTrip->id() ) ] = &( *iTrip );
+
+    m_driverIndex.insert( std::make_pair( newDriver.id(), m_drivers.size() - 1 ) );
+    return *m_drivers.back();
+}
+
+
+const Driver*
+Fleet::driver( int driverId ) const
+{
+    std::unordered_map< int, size_t >::const_iterator iDriver = m_driverIndex.find( driverId );
+    if ( iDriver == m_driverIndex.end() ) return 0;
+    return m_drivers[ iDriver->second ].get();
+}
+
+
+const Trip*
+Fleet::trip( int driverId, int tripId ) const
+{
+    std::unordered_map< uint64_t, const Trip* >::const_iterator iTrip = m_trips.find( tripKey( driverId, tripId ) );
+    if ( iTrip == m_trips.end() ) return 0;
+    return iTrip->second;
+}
@@ -0,0 +1,372 @@
+#include "KinematicsKernels.h"
+#include "FastMath.h"
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+
+#if ( defined(__x86_64__) || defined(__i386__) ) && defined(__GNUC__)
+#define KINEMATICSKERNELS_X86
+#include <immintrin.h>
+#if defined(__clang__)
+#define KINEMATICSKERNELS_TARGET( isa ) __attribute__(( target( isa ) ))
+#else
+// GCC would otherwise contract the products of the AVX-512 kernels into fused multiply-adds, which round differently
+#define KINEMATICSKERNELS_TARGET( isa ) __attribute__(( target( isa ), optimize( "fp-contract=off" ) ))
+#endif
+#endif
+
+static const double pi = std::atan( 1.0 ) * 4;
+
+// The number of angles whose sine and cosine are kept on the stack by the direction kernels
+static const size_t directionBlockSize = 256;
+
+
+// The angle from the sine and cosine ratios of two vectors with the given magnitudes, as angleAmongVectors
+static inline double
+angleFromRatios( double sint, double cost, double mv1, double mv2 )
+{
+    if ( mv1 == 0 || mv2 == 0 ) return 0;
+    if ( sint > 1 ) sint = 1;
+    if ( sint < -1 ) sint = -1;
+    if ( cost >= 0 ) return std::asin( sint );
+    if ( sint > 0 ) return pi - std::asin( sint );
+    if ( cost > 1 ) cost = 1;
+    if ( cost < -1 ) cost = -1;
+    return - std::acos( cost );
+}
+
+
+// The direction kernel for a kernel of the sine and cosine ratios of the vectors [begin, end) and their predecessors.
+// The ratios are computed block by block and turned into angles while they are in the cache. In the fast mode the
+// angles are the approximate atan2 of the ratios, with the signs and the zeros of angleAmongVectors
+template< void (*Ratios)( const float*, const float*, const double*, size_t, size_t, double*, double* ) >
+static void
+directionKernel( const float* vx, const float* vy, const double* speed, size_t n, double* direction )
+{
+    const bool fastMath = FastMath::mode() == FastMath::Fast;
+    double cost[directionBlockSize];
+    for ( size_t begin = 1; begin < n; begin += directionBlockSize ) {
+        const size_t end = std::min( n, begin + directionBlockSize );
+        double* sint = direction + begin - 1;
+        Ratios( vx, vy, speed, begin, end, sint, cost );
+        if ( fastMath ) {
+            // The angles already have the signs of the sines, except for the reversals, with a zero sine, which
+            // are -pi. The comparisons are all equalities, which do not trap on the NaN ratios of the stops,
+            // so that the loop vectorises
+            double* angle = cost;
+            FastMath::atan2( sint, cost, end - begin, angle, FastMath::Fast );
+            for ( size_t i = begin; i < end; ++i ) {
+                const double a = angle[i - begin];
+                const bool stopped = ( speed[i] == 0 ) | ( speed[i-1] == 0 );
+                const bool reversal = ( sint[i - begin] == 0 ) & ( a == pi );
+                sint[i - begin] = stopped ? 0.0 : ( reversal ? -pi : a );
+            }
+        }
+        else {
+            for ( size_t i = begin; i < end; ++i )
+                sint[i - begin] = angleFromRatios( sint[i - begin], cost[i - begin], speed[i], speed[i-1] );
+        }
+    }
+}
+
+
+//******************************************************************************
+// Scalar kernels
+
+
+static void
+speedScalar( const float* vx, const float* vy, size_t n, double* speed )
+{
+    // The squares of the float components are exact in double precision
+    for ( size_t i = 0; i < n; ++i ) {
+        const double x = vx[i];
+        const double y = vy[i];
+        speed[i] = std::sqrt( x * x + y * y );
+    }
+}
+
+
+static void
+accelerationScalar( const double* speed, size_t n, double* acceleration, double* speedXacceleration )
+{
+    for ( size_t i = 1; i < n; ++i ) {
+        const double a = speed[i] - speed[i-1];
+        acceleration[i-1] = a;
+        speedXacceleration[i-1] = speed[i] * a;
+    }
+}
+
+
+static void
+ratiosScalar( const float* vx, const float* vy, const double* speed, size_t begin, size_t end, double* sint, double* cost )
+{
+    // The products of the components are in single precision, as in angleAmongVectors
+    for ( size_t i = begin; i < end; ++i ) {
+        const double mvv = speed[i] * speed[i-1];
+        const float cross = vx[i] * vy[i-1] - vy[i] * vx[i-1];
+        const float dot = vx[i] * vx[i-1] + vy[i] * vy[i-1];
+        sint[i - begin] = cross / mvv;
+        cost[i - begin] = dot / mvv;
+    }
+}
+
+
+#ifdef KINEMATICSKERNELS_X86
+
+//******************************************************************************
+// SSE2 kernels
+
+
+KINEMATICSKERNELS_TARGET( "sse2" ) static void
+speedSSE2( const float* vx, const float* vy, size_t n, double* speed )
+{
+    size_t i = 0;
+    for ( ; i + 4 <= n; i += 4 ) {
+        const __m128 x = _mm_loadu_ps( vx + i );
+        const __m128 y = _mm_loadu_ps( vy + i );
+        const __m128d xLow = _mm_cvtps_pd( x );
+        const __m128d yLow = _mm_cvtps_pd( y );
+        const __m128d xHigh = _mm_cvtps_pd( _mm_movehl_ps( x, x ) );
+        const __m128d yHigh = _mm_cvtps_pd( _mm_movehl_ps( y, y ) );
+        _mm_storeu_pd( speed + i, _mm_sqrt_pd( _mm_add_pd( _mm_mul_pd( xLow, xLow ), _mm_mul_pd( yLow, yLow ) ) ) );
+        _mm_storeu_pd( speed + i + 2, _mm_sqrt_pd( _mm_add_pd( _mm_mul_pd( xHigh, xHigh ), _mm_mul_pd( yHigh, yHigh ) ) ) );
+    }
+    speedScalar( vx + i, vy + i, n - i, speed + i );
+}
+
+
+KINEMATICSKERNELS_TARGET( "sse2" ) static void
+accelerationSSE2( const double* speed, size_t n, double* acceleration, double* speedXacceleration )
+{
+    size_t i = 1;
+    for ( ; i + 2 <= n; i += 2 ) {
+        const __m128d current = _mm_loadu_pd( speed + i );
+        const __m128d a = _mm_sub_pd( current, _mm_loadu_pd( speed + i - 1 ) );
+        _mm_storeu_pd( acceleration + i - 1, a );
+        _mm_storeu_pd( speedXacceleration + i - 1, _mm_mul_pd( current, a ) );
+    }
+    if ( i < n ) accelerationScalar( speed + i - 1, n - i + 1, acceleration + i - 1, speedXacceleration + i - 1 );
+}
+
+
+KINEMATICSKERNELS_TARGET( "sse2" ) static void
+ratiosSSE2( const float* vx, const float* vy, const double* speed, size_t begin, size_t end, double* sint, double* cost )
+{
+    size_t i = begin;
+    for ( ; i + 4 <= end; i += 4 ) {
+        const __m128 x1 = _mm_loadu_ps( vx + i );
+        const __m128 y1 = _mm_loadu_ps( vy + i );
+        const __m128 x2 = _mm_loadu_ps( vx + i - 1 );
+        const __m128 y2 = _mm_loadu_ps( vy + i - 1 );
+        const __m128 cross = _mm_sub_ps( _mm_mul_ps( x1, y2 ), _mm_mul_ps( y1, x2 ) );
+        const __m128 dot = _mm_add_ps( _mm_mul_ps( x1, x2 ), _mm_mul_ps( y1, y2 ) );
+        const __m128d mvvLow = _mm_mul_pd( _mm_loadu_pd( speed + i ), _mm_loadu_pd( speed + i - 1 ) );
+        const __m128d mvvHigh = _mm_mul_pd( _mm_loadu_pd( speed + i + 2 ), _mm_loadu_pd( speed + i + 1 ) );
+        _mm_storeu_pd( sint + i - begin, _mm_div_pd( _mm_cvtps_pd( cross ), mvvLow ) );
+        _mm_storeu_pd( sint + i - begin + 2, _mm_div_pd( _mm_cvtps_pd( _mm_movehl_ps( cross, cross ) ), mvvHigh ) );
+        _mm_storeu_pd( cost + i - begin, _mm_div_pd( _mm_cvtps_pd( dot ), mvvLow ) );
+        _mm_storeu_pd( cost + i - begin + 2, _mm_div_pd( _mm_cvtps_pd( _mm_movehl_ps( dot, dot ) ), mvvHigh ) );
+    }
+    ratiosScalar( vx, vy, speed, i, end, sint + i - begin, cost + i - begin );
+}
+
+
+//******************************************************************************
+// AVX2 kernels
+
+
+KINEMATICSKERNELS_TARGET( "avx2" ) static void
+speedAVX2( const float* vx, const float* vy, size_t n, double* speed )
+{
+    size_t i = 0;
+    for ( ; i + 8 <= n; i += 8 ) {
+        const __m256 x = _mm256_loadu_ps( vx + i );
+        const __m256 y = _mm256_loadu_ps( vy + i );
+        const __m256d xLow = _mm256_cvtps_pd( _mm256_castps256_ps128( x ) );
+        const __m256d yLow = _mm256_cvtps_pd( _mm256_castps256_ps128( y ) );
+        const __m256d xHigh = _mm256_cvtps_pd( _mm256_extractf128_ps( x, 1 ) );
+        const __m256d yHigh = _mm256_cvtps_pd( _mm256_extractf128_ps( y, 1 ) );
+        _mm256_storeu_pd( speed + i, _mm256_sqrt_pd( _mm256_add_pd( _mm256_mul_pd( xLow, xLow ), _mm256_mul_pd( yLow, yLow ) ) ) );
+        _mm256_storeu_pd( speed + i + 4, _mm256_sqrt_pd( _mm256_add_pd( _mm256_mul_pd( xHigh, xHigh ), _mm256_mul_pd( yHigh, yHigh ) ) ) );
+    }
+    speedScalar( vx + i, vy + i, n - i, speed + i );
+}
+
+
+KINEMATICSKERNELS_TARGET( "avx2" ) static void
+accelerationAVX2( const double* speed, size_t n, double* acceleration, double* speedXacceleration )
+{
+    size_t i = 1;
+    for ( ; i + 4 <= n; i += 4 ) {
+        const __m256d current = _mm256_loadu_pd( speed + i );
+        const __m256d a = _mm256_sub_pd( current, _mm256_loadu_pd( speed + i - 1 ) );
+        _mm256_storeu_pd( acceleration + i - 1, a );
+        _mm256_storeu_pd( speedXacceleration + i - 1, _mm256_mul_pd( current, a ) );
+    }
+    if ( i < n ) accelerationScalar( speed + i - 1, n - i + 1, acceleration + i - 1, speedXacceleration + i - 1 );
+}
+
+
+KINEMATICSKERNELS_TARGET( "avx2" ) static void
+ratiosAVX2( const float* vx, const float* vy, const double* speed, size_t begin, size_t end, double* sint, double* cost )
+{
+    size_t i = begin;
+    for ( ; i + 8 <= end; i += 8 ) {
+        const __m256 x1 = _mm256_loadu_ps( vx + i );
+        const __m256 y1 = _mm256_loadu_ps( vy + i );
+        const __m256 x2 = _mm256_loadu_ps( vx + i - 1 );
+        const __m256 y2 = _mm256_loadu_ps( vy + i - 1 );
+        const __m256 cross = _mm256_sub_ps( _mm256_mul_ps( x1, y2 ), _mm256_mul_ps( y1, x2 ) );
+        const __m256 dot = _mm256_add_ps( _mm256_mul_ps( x1, x2 ), _mm256_mul_ps( y1, y2 ) );
+        const __m256d mvvLow = _mm256_mul_pd( _mm256_loadu_pd( speed + i ), _mm256_loadu_pd( speed + i - 1 ) );
+        const __m256d mvvHigh = _mm256_mul_pd( _mm256_loadu_pd( speed + i + 4 ), _mm256_loadu_pd( speed + i + 3 ) );
+        _mm256_storeu_pd( sint + i - begin, _mm256_div_pd( _mm256_cvtps_pd( _mm256_castps256_ps128( cross ) ), mvvLow ) );
+        _mm256_storeu_pd( sint + i - begin + 4, _mm256_div_pd( _mm256_cvtps_pd( _mm256_extractf128_ps( cross, 1 ) ), mvvHigh ) );
+        _mm256_storeu_pd( cost + i - begin, _mm256_div_pd( _mm256_cvtps_pd( _mm256_castps256_ps128( dot ) ), mvvLow ) );
+        _mm256_storeu_pd( cost + i - begin + 4, _mm256_div_pd( _mm256_cvtps_pd( _mm256_extractf128_ps( dot, 1 ) ), mvvHigh ) );
+    }
+    ratiosScalar( vx, vy, speed, i, end, sint + i - begin, cost + i - begin );
+}
+
+
+//******************************************************************************
+// AVX-512 kernels
+
+
+// The upper eight floats of a vector of sixteen, with AVX-512F only
+KINEMATICSKERNELS_TARGET( "avx512f" ) static inline __m256
+upperHalf( __m512 v )
+{
+    return _mm256_castpd_ps( _mm512_extractf64x4_pd( _mm512_castps_pd( v ), 1 ) );
+}
+
+
+KINEMATICSKERNELS_TARGET( "avx512f" ) static void
+speedAVX512( const float* vx, const float* vy, size_t n, double* speed )
+{
+    size_t i = 0;
+    for ( ; i + 16 <= n; i += 16 ) {
+        const __m512 x = _mm512_loadu_ps( vx + i );
+        const __m512 y = _mm512_loadu_ps( vy + i );
+        const __m512d xLow = _mm512_cvtps_pd( _mm512_castps512_ps256( x ) );
+        const __m512d yLow = _mm512_cvtps_pd( _mm512_castps512_ps256( y ) );
+        const __m512d xHigh = _mm512_cvtps_pd( upperHalf( x ) );
+        const __m512d yHigh = _mm512_cvtps_pd( upperHalf( y ) );
+        _mm512_storeu_pd( speed + i, _mm512_sqrt_pd( _mm512_add_pd( _mm512_mul_pd( xLow, xLow ), _mm512_mul_pd( yLow, yLow ) ) ) );
+        _mm512_storeu_pd( speed + i + 8, _mm512_sqrt_pd( _mm512_add_pd( _mm512_mul_pd( xHigh, xHigh ), _mm512_mul_pd( yHigh, yHigh ) ) ) );
+    }
+    speedScalar( vx + i, vy + i, n - i, speed + i );
+}
+
+
+KINEMATICSKERNELS_TARGET( "avx512f" ) static void
+accelerationAVX512( const double* speed, size_t n, double* acceleration, double* speedXacceleration )
+{
+    size_t i = 1;
+    for ( ; i + 8 <= n; i += 8 ) {
+        const __m512d current = _mm512_loadu_pd( speed + i );
+        const __m512d a = _mm512_sub_pd( current, _mm512_loadu_pd( speed + i - 1 ) );
+        _mm512_storeu_pd( acceleration + i - 1, a );
+        _mm512_storeu_pd( speedXacceleration + i - 1, _mm512_mul_pd( current, a ) );
+    }
+    if ( i < n ) accelerationScalar( speed + i - 1, n - i + 1, acceleration + i - 1, speedXacceleration + i - 1 );
+}
+
+
+KINEMATICSKERNELS_TARGET( "avx512f" ) static void
+ratiosAVX512( const float* vx, const float* vy, const double* speed, size_t begin, size_t end, double* sint, double* cost )
+{
+    size_t i = begin;
+    for ( ; i + 16 <= end; i += 16 ) {
+        const __m512 x1 = _mm512_loadu_ps( vx + i );
+        const __m512 y1 = _mm512_loadu_ps( vy + i );
+        const __m512 x2 = _mm512_loadu_ps( vx + i - 1 );
+        const __m512 y2 = _mm512_loadu_ps( vy + i - 1 );
+        const __m512 cross = _mm512_sub_ps( _mm512_mul_ps( x1, y2 ), _mm512_mul_ps( y1, x2 ) );
+        const __m512 dot = _mm512_add_ps( _mm512_mul_ps( x1, x2 ), _mm512_mul_ps( y1, y2 ) );
+        const __m512d mvvLow = _mm512_mul_pd( _mm512_loadu_pd( speed + i ), _mm512_loadu_pd( speed + i - 1 ) );
+        const __m512d mvvHigh = _mm512_mul_pd( _mm512_loadu_pd( speed + i + 8 ), _mm512_loadu_pd( speed + i + 7 ) );
+        _mm512_storeu_pd( sint + i - begin, _mm512_div_pd( _mm512_cvtps_pd( _mm512_castps512_ps256( cross ) ), mvvLow ) );
+        _mm512_storeu_pd( sint + i - begin + 8, _mm512_div_pd( _mm512_cvtps_pd( upperHalf( cross ) ), mvvHigh ) );
+        _mm512_storeu_pd( cost + i - begin, _mm512_div_pd( _mm512_cvtps_pd( _mm512_castps512_ps256( dot ) ), mvvLow ) );
+        _mm512_storeu_pd( cost + i - begin + 8, _mm512_div_pd( _mm512_cvtps_pd( upperHalf( dot ) ), mvvHigh ) );
+    }
+    ratiosScalar( vx, vy, speed, i, end, sint + i - begin, cost + i - begin );
+}
+
+#endif
+
+
+//******************************************************************************
+
+
+KinematicsKernels::KinematicsKernels( InstructionSet instructionSet,
+                                      SpeedKernel speedKernel,
+                                      AccelerationKernel accelerationKernel,
+                                      DirectionKernel directionKernel ):
+  m_instructionSet( instructionSet ),
+  m_speed( speedKernel ),
+  m_acceleration( accelerationKernel ),
+  m_direction( directionKernel )
+{}
+
+
+bool
+KinematicsKernels::isSupported( InstructionSet instructionSet )
+{
+    if ( instructionSet == Scalar ) return true;
+#ifdef KINEMATICSKERNELS_X86
+    __builtin_cpu_init();
+    switch ( instructionSet ) {
+        case SSE2: return __builtin_cpu_supports( "sse2" );
+        case AVX2: return __builtin_cpu_supports( "avx2" );
+        case AVX512: return __builtin_cpu_supports( "avx512f" );
+        default: return false;
+    }
+#else
+    return false;
+#endif
+}
+
+
+const char*
+KinematicsKernels::name( InstructionSet instructionSet )
+{
+    switch ( instructionSet ) {
+        case Scalar: return "Scalar";
+        case SSE2: return "SSE2";
+        case AVX2: return "AVX2";
+        case AVX512: return "AVX-512";
+        default: return "Unknown";
+    }
+}
+
+
+const KinematicsKernels&
+KinematicsKernels::forInstructionSet( InstructionSet instructionSet )
+{
+    if ( ! isSupported( instructionSet ) )
+        throw std::runtime_error( std::string( "KinematicsKernels : " ) + name( instructionSet ) + " is not supported by the processor" );
+
+    static const KinematicsKernels scalarKernels( Scalar, speedScalar, accelerationScalar, directionKernel< ratiosScalar > );
+#ifdef KINEMATICSKERNELS_X86
+    static const KinematicsKernels sse2Kernels( SSE2, speedSSE2, accelerationSSE2, directionKernel< ratiosSSE2 > );
+    static const KinematicsKernels avx2Kernels( AVX2, speedAVX2, accelerationAVX2, directionKernel< ratiosAVX2 > );
+    static const KinematicsKernels avx512Kernels( AVX512, speedAVX512, accelerationAVX512, directionKernel< ratiosAVX512 > );
+    if ( instructionSet == SSE2 ) return sse2Kernels;
+    if ( instructionSet == AVX2 ) return avx2Kernels;
+    if ( instructionSet == AVX512 ) return avx512Kernels;
+#endif
+    return scalarKernels;
+}
+
+
+const KinematicsKernels&
+KinematicsKernels::best()
+{
+    static const KinematicsKernels& kernels = forInstructionSet( isSupported( AVX512 ) ? AVX512 :
+                                                                 isSupported( AVX2 ) ? AVX2 :
+                                                                 isSupported( SSE2 ) ? SSE2 : Scalar );
+    return kernels;
+}
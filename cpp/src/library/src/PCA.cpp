@@ -1,8 +1,11 @@
 #include "PCA.h"
+#include "FeatureMatrix.h"
 
 #include <vector>
 #include <algorithm>
 #include <exception>
+#include <stdexcept>
+#include <cmath>
 #include <ostream>
 
 #define ARMA_NO_DEBUG
@@ -17,32 +20,41 @@ PCA::~PCA()
 {}
 
 PCA&
-PCA::fit( const std::vector< std::vector< double > >& data )
+PCA::fit( const FeatureMatrix& data )
 {
-    const size_t nSamples = data.size();
-    const size_t nFeatures = data.front().size();
+    const size_t nSamples = data.numberOfRows();
+    const size_t nFeatures = FeatureMatrix::numberOfFeatures();
     
-    // Calculate the means vector
-    arma::mat meansVector( nFeatures, 1 );
+    // Calculate the means vector and centre the columns
+    std::vector< std::vector< double > > centredColumns( nFeatures );
     for ( size_t iFeature = 0; iFeature < nFeatures; ++iFeature ) {
+        const std::vector< double >& column = data.feature( iFeature );
         double sx = 0;
         for ( size_t iSample = 0; iSample < nSamples; ++iSample ) {
-            const double value = data[iSample][iFeature];
+            const double value = column[iSample];
             if ( std::isnan(value) )
                 throw std::runtime_error( "PCA::fit : nan value encountered at input!" );
             sx += value;
         }
-        meansVector(iFeature, 0) = sx / nSamples;
+        const double mean = sx / nSamples;
+        std::vector< double >& centredColumn = centredColumns[iFeature];
+        centredColumn.resize( nSamples );
+        for ( size_t iSample = 0; iSample < nSamples; ++iSample )
+            centredColumn[iSample] = column[iSample] - mean;
     }
     
-    // Construct the covariance matrix from the scatter matrix
+    // Construct the covariance matrix from the inner products of the centred columns
     arma::mat covMatrix( nFeatures, nFeatures, arma::fill::zeros );
-    for ( size_t iSample = 0; iSample < nSamples; ++iSample ) {
-        arma::mat sampleData( data[iSample ] );
-        arma::mat d = sampleData - meansVector;
-        covMatrix += d * d.t();
+    for ( size_t i = 0; i < nFeatures; ++i ) {
+        const double* x = centredColumns[i].data();
+        for ( size_t j = 0; j <= i; ++j ) {
+            const double* y = centredColumns[j].data();
+            double sxy = 0;
+            for ( size_t iSample = 0; iSample < nSamples; ++iSample ) sxy += x[iSample] * y[iSample];
+            covMatrix( i, j ) = sxy / nSamples;
+            covMatrix( j, i ) = covMatrix( i, j );
+        }
     }
-    covMatrix /= nSamples;
     
     // Now find the eigenvalues and eigenvectors
     arma::cx_vec eigval;
@@ -0,0 +1,197 @@
+#include "QuantileSelection.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+const std::array< size_t, 5 > quantilePercentages = {{ 5, 25, 50, 75, 95 }};
+
+// The ranges up to this size are sorted rather than partitioned
+static const ptrdiff_t sortingThreshold = 16;
+
+
+// Returns the median of three values
+static inline double
+medianOfThree( double a, double b, double c )
+{
+    if ( a < b ) return b < c ? b : ( a < c ? c : a );
+    else return a < c ? a : ( b < c ? c : b );
+}
+
+
+// Moves the values for which the predicate holds before the others, and returns the cut between them. Every
+// value is swapped with the one at the cut, which only moves on past a value that belongs before it. There
+// is no branch on the values, which are in no particular order, so nothing is lost to mispredictions
+template< typename Predicate >
+static inline double*
+partition( double* begin, double* end, Predicate belongsBefore )
+{
+    double* cut = begin;
+    for ( double* iValue = begin; iValue != end; ++iValue ) {
+        const double value = *iValue;
+        *iValue = *cut;
+        *cut = value;
+        cut += belongsBefore( value ) ? 1 : 0;
+    }
+    return cut;
+}
+
+
+// Selects the ranks, relative to base, within [begin, end). Past the depth limit the range is sorted
+static void
+selectRanks( double* base, double* begin, double* end, const size_t* firstRank, const size_t* lastRank, int depthLimit )
+{
+    while ( firstRank != lastRank ) {
+        if ( end - begin <= sortingThreshold || depthLimit == 0 ) {
+            std::sort( begin, end );
+            return;
+        }
+        --depthLimit;
+        const double pivot = medianOfThree( begin[0], begin[ ( end - begin ) / 2 ], end[-1] );
+        double* cut = partition( begin, end, [pivot]( double value ) { return value < pivot; } );
+
+        // With the pivot the smallest value, the values equal to it are in place and the rest is left
+        if ( cut == begin ) {
+            cut = partition( begin, end, [pivot]( double value ) { return ! ( pivot < value ); } );
+            firstRank = std::lower_bound( firstRank, lastRank, static_cast<size_t>( cut - base ) );
+            begin = cut;
+            continue;
+        }
+
+        // The ranks before the cut go to the left side, the others to the right side
+        const size_t* middleRank = std::lower_bound( firstRank, lastRank, static_cast<size_t>( cut - base ) );
+        if ( middleRank - firstRank < lastRank - middleRank ) {
+            selectRanks( base, begin, cut, firstRank, middleRank, depthLimit );
+            begin = cut;
+            firstRank = middleRank;
+        }
+        else {
+            selectRanks( base, cut, end, middleRank, lastRank, depthLimit );
+            end = cut;
+            lastRank = middleRank;
+        }
+    }
+}
+
+
+void
+multiSelect( double* begin, double* end, const size_t* ranks, size_t numberOfRanks )
+{
+    int depthLimit = 0;
+    for ( ptrdiff_t n = end - begin; n > 1; n /= 2 ) depthLimit += 2;
+    selectRanks( begin, begin, end, ranks, ranks + numberOfRanks, depthLimit );
+}
+
+
+bool
+selectQuantiles( double* begin, double* end, QuantileValues& quantiles )
+{
+    const size_t numberOfValues = end - begin;
+    if ( numberOfValues == 0 ) return false;
+
+    std::array< size_t, 5 > ranks;
+    for ( size_t i = 0; i < ranks.size(); ++i ) ranks[i] = ( numberOfValues * quantilePercentages[i] ) / 100;
+    multiSelect( begin, end, ranks.data(), ranks.size() );
+    for ( size_t i = 0; i < ranks.size(); ++i ) quantiles[i] = begin[ ranks[i] ];
+    return true;
+}
+
+
+//******************************************************************************
+
+
+StreamingQuantiles::StreamingQuantiles( double rankError ):
+  m_rankError( rankError ),
+  m_numberOfValues( 0 ),
+  m_bufferSize( static_cast<size_t>( std::ceil( 1 / rankError ) ) ),
+  m_buffer(),
+  m_entries(),
+  m_mergedEntries()
+{
+    if ( ! ( rankError > 0 && rankError < 1 ) )
+        throw std::runtime_error( "StreamingQuantiles : the rank error must be in (0, 1)" );
+    m_buffer.reserve( m_bufferSize );
+}
+
+
+void
+StreamingQuantiles::add( double value )
+{
+    m_buffer.push_back( value );
+    ++m_numberOfValues;
+    if ( m_buffer.size() >= m_bufferSize ) this->flush();
+}
+
+
+void
+StreamingQuantiles::flush()
+{
+    if ( m_buffer.empty() ) return;
+    std::sort( m_buffer.begin(), m_buffer.end() );
+
+    // Insert the values in order. A value inside the summary lies between two entries, and its rank is uncertain
+    // by the span of the rank bounds of the entry after it, which keeps count + rankUncertainty within 2 rankError n
+    m_mergedEntries.clear();
+    std::vector< Entry >::iterator iEntry = m_entries.begin();
+    for ( size_t i = 0; i < m_buffer.size(); ++i ) {
+        while ( iEntry != m_entries.end() && iEntry->value <= m_buffer[i] ) m_mergedEntries.push_back( *iEntry++ );
+        Entry entry;
+        entry.value = m_buffer[i];
+        entry.count = 1;
+        entry.rankUncertainty = ( iEntry == m_entries.begin() || iEntry == m_entries.end() ) ? 0 :
+            iEntry->count + iEntry->rankUncertainty - 1;
+        m_mergedEntries.push_back( entry );
+    }
+    m_mergedEntries.insert( m_mergedEntries.end(), iEntry, m_entries.end() );
+    m_buffer.clear();
+
+    // Merge every entry into its successor while the rank bounds stay within the error, keeping the extremes
+    const size_t threshold = static_cast<size_t>( std::floor( 2 * m_rankError * m_numberOfValues ) );
+    m_entries.clear();
+    if ( m_mergedEntries.size() <= 2 ) {
+        m_entries.swap( m_mergedEntries );
+        return;
+    }
+    Entry successor = m_mergedEntries.back();
+    for ( size_t i = m_mergedEntries.size() - 2; i >= 1; --i ) {
+        const Entry& entry = m_mergedEntries[i];
+        if ( entry.count + successor.count + successor.rankUncertainty < threshold ) {
+            successor.count += entry.count;
+        }
+        else {
+            m_entries.push_back( successor );
+            successor = entry;
+        }
+    }
+    m_entries.push_back( successor );
+    m_entries.push_back( m_mergedEntries.front() );
+    std::reverse( m_entries.begin(), m_entries.end() );
+}
+
+
+bool
+StreamingQuantiles::quantiles( QuantileValues& quantiles )
+{
+    if ( m_numberOfValues == 0 ) return false;
+    this->flush();
+
+    // The entry whose rank bounds are within the error of the rank of each quantile. The summary keeps
+    // count + rankUncertainty within 2 rankError n for every entry, and half of their largest sum always finds one
+    size_t largestSpread = 0;
+    for ( std::vector< Entry >::const_iterator iEntry = m_entries.begin(); iEntry != m_entries.end(); ++iEntry )
+        largestSpread = std::max( largestSpread, iEntry->count + iEntry->rankUncertainty );
+    const double tolerance = largestSpread / 2.0;
+    for ( size_t q = 0; q < quantiles.size(); ++q ) {
+        const double rank = static_cast<double>( ( m_numberOfValues * quantilePercentages[q] ) / 100 + 1 );
+        size_t minimumRank = 0;
+        quantiles[q] = m_entries.back().value;
+        for ( std::vector< Entry >::const_iterator iEntry = m_entries.begin(); iEntry != m_entries.end(); ++iEntry ) {
+            minimumRank += iEntry->count;
+            const size_t maximumRank = minimumRank + iEntry->rankUncertainty;
+            if ( maximumRank - tolerance <= rank && rank <= minimumRank + tolerance ) {
+                quantiles[q] = iEntry->value;
+                break;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,66 @@
+#include "SlidingDFT.h"
+#include <cmath>
+#include <stdexcept>
+
+SlidingDFT::SlidingDFT( size_t windowSize, size_t numberOfBins, size_t resynchronisationInterval ):
+  m_plan( windowSize ),
+  m_numberOfBins( numberOfBins ),
+  m_resynchronisationInterval( resynchronisationInterval ),
+  m_numberOfSlides( 0 ),
+  m_cos( numberOfBins ),
+  m_sin( numberOfBins ),
+  m_real( windowSize / 2 + 1 ),
+  m_imaginary( windowSize / 2 + 1 ),
+  m_magnitudes( numberOfBins )
+{
+    if ( numberOfBins > m_plan.numberOfBins() )
+        throw std::runtime_error( "SlidingDFT : more bins than up to the Nyquist frequency" );
+
+    const double pi = std::atan( 1.0 ) * 4;
+    for ( size_t k = 0; k < numberOfBins; ++k ) {
+        const double angle = 2 * pi * k / windowSize;
+        m_cos[k] = std::cos( angle );
+        m_sin[k] = std::sin( angle );
+    }
+}
+
+
+SlidingDFT::~SlidingDFT()
+{}
+
+
+void
+SlidingDFT::start( const double* window )
+{
+    m_plan.transform( window, m_real.data(), m_imaginary.data() );
+    m_numberOfSlides = 0;
+    this->computeMagnitudes();
+}
+
+
+void
+SlidingDFT::slide( const double* window )
+{
+    if ( ++m_numberOfSlides >= m_resynchronisationInterval ) {
+        this->start( window );
+        return;
+    }
+
+    const double change = window[ m_plan.size() - 1 ] - window[-1];
+    for ( size_t k = 0; k < m_numberOfBins; ++k ) {
+        const double real = m_real[k] + change;
+        const double imaginary = m_imaginary[k];
+        m_real[k] = real * m_cos[k] - imaginary * m_sin[k];
+        m_imaginary[k] = real * m_sin[k] + imaginary * m_cos[k];
+    }
+    this->computeMagnitudes();
+}
+
+
+void
+SlidingDFT::computeMagnitudes()
+{
+    // The bins of the trip series are far from overflowing, so the scaling of std::hypot is not needed
+    for ( size_t k = 0; k < m_numberOfBins; ++k )
+        m_magnitudes[k] = std::sqrt( m_real[k] * m_real[k] + m_imaginary[k] * m_imaginary[k] );
+}
@@ -1,170 +1,157 @@
 #include "Trip.h"
 #include "Segment.h"
+#include "TripSegmentation.h"
+#include "TripKinematics.h"
 #include "Utilities.h"
+#include "SlidingDFT.h"
+#include "TripFeatureExtractor.h"
+#include "FastMath.h"
 #include <cmath>
+#include <algorithm>
+#include <mutex>
 
-static const double pi = std::atan( 1.0 ) * 4;
+
+// The mutexes guarding the lazy initialisation of the trips. A trip locks the one its address hashes to,
+// and only until it is initialised. Trips keep no mutex of their own, so that they stay movable
+// Trips share the mutexes, so the initialisation must never lock another trip while holding one, or it could deadlock
+static const size_t numberOfInitialisationMutexes = 64;
+static std::mutex initialisationMutexes[numberOfInitialisationMutexes];
+
+static std::mutex&
+initialisationMutex( const Trip* trip )
+{
+    return initialisationMutexes[ ( reinterpret_cast<size_t>( trip ) / sizeof(Trip) ) % numberOfInitialisationMutexes ];
+}
 
 
 Trip::Trip( int tripId):
 m_tripId( tripId ),
+m_store(),
 m_rawData(),
+m_velocityX(),
+m_velocityY(),
 m_segments(),
+m_kinematics(),
 m_segmentsGenerated( false ),
+m_kinematicsCached( false ),
 m_extraTravelDuration(0),
 m_extraTravelLength(0),
 m_distanceOfEndPoint(0)
 {
 }
 
+Trip::Trip( Trip&& rhs ) noexcept:
+m_tripId( rhs.m_tripId ),
+m_store( std::move( rhs.m_store ) ),
+m_rawData( rhs.m_rawData ),
+m_velocityX( std::move( rhs.m_velocityX ) ),
+m_velocityY( std::move( rhs.m_velocityY ) ),
+m_segments( std::move( rhs.m_segments ) ),
+m_kinematics( std::move( rhs.m_kinematics ) ),
+m_segmentsGenerated( rhs.m_segmentsGenerated.load() ),
+m_kinematicsCached( rhs.m_kinematicsCached.load() ),
+m_extraTravelDuration( rhs.m_extraTravelDuration ),
+m_extraTravelLength( rhs.m_extraTravelLength ),
+m_distanceOfEndPoint( rhs.m_distanceOfEndPoint )
+{
+    rhs.clearSegments();
+}
+
+Trip&
+Trip::operator=( Trip&& rhs ) noexcept
+{
+    if ( this == &rhs ) return *this;
+    m_tripId = rhs.m_tripId;
+    m_store = std::move( rhs.m_store );
+    m_rawData = rhs.m_rawData;
+    m_velocityX = std::move( rhs.m_velocityX );
+    m_velocityY = std::move( rhs.m_velocityY );
+    m_segments = std::move( rhs.m_segments );
+    m_kinematics = std::move( rhs.m_kinematics );
+    m_segmentsGenerated = rhs.m_segmentsGenerated.load();
+    m_kinematicsCached = rhs.m_kinematicsCached.load();
+    m_extraTravelDuration = rhs.m_extraTravelDuration;
+    m_extraTravelLength = rhs.m_extraTravelLength;
+    m_distanceOfEndPoint = rhs.m_distanceOfEndPoint;
+    rhs.clearSegments();
+    return *this;
+}
+
 Trip::~Trip()
+{}
+
+void
+Trip::clearSegments()
 {
-    for ( std::vector< Segment* >::iterator i = m_segments.begin();
-         i != m_segments.end(); ++i )
-        delete *i;
+    m_segments.clear();
+    m_kinematics.reset();
+    AlignedArray< float >().swap( m_velocityX );
+    AlignedArray< float >().swap( m_velocityY );
+    m_segmentsGenerated = false;
+    m_kinematicsCached = false;
+    m_extraTravelDuration = 0;
+    m_extraTravelLength = 0;
 }
 
 Trip&
 Trip::setTripData( const std::vector< std::pair<float,float> >& data )
 {
-    m_rawData = data;
-    if ( m_segmentsGenerated ) {
-        for ( std::vector< Segment* >::iterator i = m_segments.begin();
-             i != m_segments.end(); ++i )
-            delete *i;
-        m_segments.clear();
-        m_segmentsGenerated = false;
-        m_extraTravelDuration = 0;
-        m_extraTravelLength = 0;
-    }
+    return this->setTripData( TripDataView( data.data(), data.size() ) );
+}
+
+Trip&
+Trip::setTripData( const TripDataView& data )
+{
+    return this->setTripData( std::make_shared< const TripStore >( m_tripId, data ), 0 );
+}
+
+Trip&
+Trip::setTripData( const std::shared_ptr< const TripStore >& store, size_t index )
+{
+    this->clearSegments();
+    m_store = store;
+    m_rawData = store->trip( index );
     
-    const std::pair<float,float>& endPoint = data.back();
+    const std::pair<float,float> endPoint = m_rawData.back();
     m_distanceOfEndPoint = std::sqrt( std::pow(endPoint.first, 2) + std::pow(endPoint.second,2) );
     return *this;
 }
 
 
-long
-Trip::numberOfValidPoints() const
+TripMetrics
+Trip::metrics() const
 {
-    const_cast<Trip&>(*this).generateSegments();
-    long numberOfPoints = 0;
-    for ( std::vector< Segment* >::const_iterator iSegment = m_segments.begin();
-         iSegment != m_segments.end(); ++iSegment ) {
-        numberOfPoints += (*iSegment)->numberOfDataPoints();
-    }
-    return numberOfPoints;
+    std::vector<double> metricsValues;
+    this->metrics( metricsValues );
+    return TripMetrics( m_tripId,
+                       metricsValues );
 }
 
 
-TripMetrics
-Trip::metrics() const
+void
+Trip::metrics( std::vector<double>& metricsValues ) const
 {
-    static const long numberOfTripMetrics= TripMetrics::descriptions().size();
-    
-    static const long minimumNumberOfPoints = 20;
-    
     const_cast<Trip&>(*this).generateSegments();
     
-    std::vector<double> metricsValues( numberOfTripMetrics, NAN );
-    
-    size_t j = 0;
-    
-        // Check if this is a zero segment trip
-    if ( m_segments.size() == 0 ) {
-        metricsValues[j++] = 1;
-    }
-    else {
-        metricsValues[j++] = 0;
-        if ( this->numberOfValidPoints() < minimumNumberOfPoints ) {
-            metricsValues[j++] = 1;
-        }
-        else {
-            metricsValues[j++] = 0;
-            long travelDuration = this->travelDuration();
-            metricsValues[j++] = std::log10( 1 + travelDuration );
-            double tripLength = this->travelLength();
-            metricsValues[j++] = std::log10( 1 + tripLength );
-            
-                // Trip length to distance
-            double distanceToTravel = m_distanceOfEndPoint / tripLength;
-            metricsValues[j++] = distanceToTravel;
-            
-                // Speed percentiles
-            std::vector<double> percentiles = this->speedQuantiles();
-            for (size_t i = 1; i <= 4; ++i )
-                metricsValues[j++] = std::log10( 0.1 + percentiles[i] );
-            
-                // Acceleration percentiles
-            percentiles = this->accelerationQuantiles();
-            double value = -percentiles[0];
-            if ( value > 0 ) metricsValues[j] = std::log10( value );
-            ++j;
-            value = -percentiles[1];
-            if ( value > 0 ) metricsValues[j] = std::log10( value );
-            ++j;
-            value = percentiles[3];
-            if ( value > 0 ) metricsValues[j] = std::log10( value );
-            ++j;
-            value = percentiles[4];
-            if ( value > 0 ) metricsValues[j] = std::log10( value );
-            ++j;
-            
-                // Direction percentiles
-            percentiles = this->directionQuantiles();
-            value = -percentiles[0];
-            if ( value > 0 ) metricsValues[j] = std::log10( value );
-            ++j;
-            
-            value = percentiles[4];
-            if ( value > 0 ) metricsValues[j] = std::log10( value );
-            ++j;
-            
-                // Speed x Acceleration percentiles
-            std::vector<double> values = this->speedXaccelerationValues();
-            percentiles = findQuantiles( values );
-            value = -percentiles[0];
-            if ( value > 0 ) metricsValues[j] = std::log10( value );
-            ++j;
-            value = -percentiles[1];
-            if ( value > 0 ) metricsValues[j] = std::log10( value );
-            ++j;
-            value = percentiles[3];
-            if ( value > 0 ) metricsValues[j] = std::log10( value );
-            ++j;
-            value = percentiles[4];
-            if ( value > 0 ) metricsValues[j] = std::log10( value );
-            ++j;
-            
-                // Total turns
-            double totalDirectionChange = this->totalDirectionChange();
-            metricsValues[j++] = std::log10( 0.001 + totalDirectionChange );
-            
-            
-                // The rolling FFT transformations.
-            std::valarray< double > fft = this->rollingFFT( 11 );
-            if ( fft.size() > 0 )
-                for (size_t i = 0; i < 5; ++i ) metricsValues[j + i] = fft[i];
-            /*
-             j += 5;
-             std::valarray< double > fftd = this->rollingFFT_direction( 11 );
-             if ( fftd.size() > 0 )
-             for (size_t i = 0; i < 5; ++i ) metricsValues[j + i] = fftd[i];
-             j += 5;
-             */
-        }
-    }
-    
-    return TripMetrics( m_tripId,
-                       metricsValues );
+        // Each thread keeps its own extractor, reusing the scratch arrays for all the trips it processes
+    static thread_local TripFeatureExtractor extractor;
+    extractor.extract( m_segments, m_extraTravelDuration, m_extraTravelLength, m_distanceOfEndPoint, metricsValues );
 }
 
 
 double
 Trip::totalDirectionChange() const
 {
-    const double directionNoiseThreshold = 0.035; // 2 degrees
-    std::vector<double> values = this->directionValues();
+    ScratchKinematics scratch;
+    return this->totalDirectionChange( this->kinematics( scratch ) );
+}
+
+
+double
+Trip::totalDirectionChange( const TripKinematics& kinematics ) const
+{
+    const double directionNoiseThreshold = TripKinematics::directionNoiseThreshold();
+    const std::vector<double>& values = kinematics.directionValues();
     
     double result = 0;
     for ( std::vector<double>::const_iterator iValue = values.begin();
@@ -173,7 +160,7 @@ Trip::totalDirectionChange() const
         if ( direction > directionNoiseThreshold ) result += direction;
     }
     
-    const double travelLength = this->travelLength();
+    const double travelLength = kinematics.travelLength() + m_extraTravelLength;
     if ( travelLength == 0 ) return 0;
     else return result / travelLength;
 }
@@ -182,25 +169,15 @@ Trip::totalDirectionChange() const
 double
 Trip::travelLength() const
 {
-    const_cast<Trip&>(*this).generateSegments();
-    double length = 0;
-    for ( std::vector< Segment* >::const_iterator iSegment = m_segments.begin();
-         iSegment != m_segments.end(); ++iSegment )
-        length += (*iSegment)->travelLength();
-    
-    return length + m_extraTravelLength;
+    ScratchKinematics scratch;
+    return this->kinematics( scratch ).travelLength() + m_extraTravelLength;
 }
 
 long
 Trip::travelDuration() const
 {
-    const_cast<Trip&>(*this).generateSegments();
-    long duration = 0;
-    for ( std::vector< Segment* >::const_iterator iSegment = m_segments.begin();
-         iSegment != m_segments.end(); ++iSegment )
-        duration += (*iSegment)->travelDuration();
-    
-    return duration + m_extraTravelDuration;
+    ScratchKinematics scratch;
+    return this->kinematics( scratch ).travelDuration() + m_extraTravelDuration;
 }
 
 
@@ -208,79 +185,31 @@ Trip::travelDuration() const
 std::vector<double>
 Trip::speedValues() const
 {
-    const_cast<Trip&>(*this).generateSegments();
-    std::vector<double> speedValues;
-    speedValues.reserve( m_rawData.size() - 1 );
-    
-    for ( std::vector< Segment* >::const_iterator iSegment = m_segments.begin();
-         iSegment != m_segments.end(); ++iSegment ) {
-        std::vector<double> segmentValues = (*iSegment)->speedValues();
-        for ( std::vector<double>::const_iterator iValue = segmentValues.begin();
-             iValue != segmentValues.end(); ++iValue )
-            speedValues.push_back( *iValue );
-    }
-    
-    speedValues.shrink_to_fit();
-    return speedValues;
+    ScratchKinematics scratch;
+    return this->kinematics( scratch ).speedValues();
 }
 
 
 std::vector<double>
 Trip::accelerationValues() const
 {
-    const_cast<Trip&>(*this).generateSegments();
-    std::vector<double> accelerationValues;
-    accelerationValues.reserve( m_rawData.size() - 2 );
-    
-    for ( std::vector< Segment* >::const_iterator iSegment = m_segments.begin();
-         iSegment != m_segments.end(); ++iSegment ) {
-        std::vector<double> segmentValues = (*iSegment)->accelerationValues();
-        for ( std::vector<double>::const_iterator iValue = segmentValues.begin();
-             iValue != segmentValues.end(); ++iValue )
-            accelerationValues.push_back( *iValue );
-    }
-    
-    accelerationValues.shrink_to_fit();
-    return accelerationValues;
+    ScratchKinematics scratch;
+    return this->kinematics( scratch ).accelerationValues();
 }
 
 std::vector<double>
 Trip::speedXaccelerationValues() const
 {
-    const_cast<Trip&>(*this).generateSegments();
-    std::vector<double> speedXaccelerationValues;
-    speedXaccelerationValues.reserve( m_rawData.size() - 2 );
-    
-    for ( std::vector< Segment* >::const_iterator iSegment = m_segments.begin();
-         iSegment != m_segments.end(); ++iSegment ) {
-        std::vector<double> segmentValues = (*iSegment)->speedXaccelerationValues();
-        for ( std::vector<double>::const_iterator iValue = segmentValues.begin();
-             iValue != segmentValues.end(); ++iValue )
-            speedXaccelerationValues.push_back( *iValue );
-    }
-    
-    speedXaccelerationValues.shrink_to_fit();
-    return speedXaccelerationValues;
+    ScratchKinematics scratch;
+    return this->kinematics( scratch ).speedXaccelerationValues();
 }
 
 
 std::vector<double>
 Trip::directionValues() const
 {
-    const_cast<Trip&>(*this).generateSegments();
-    std::vector<double> directionValues;
-    directionValues.reserve( m_rawData.size() - 2 );
-    
-    for ( std::vector< Segment* >::const_iterator iSegment = m_segments.begin();
-         iSegment != m_segments.end(); ++iSegment ) {
-        std::vector<double> segmentValues = (*iSegment)->angularValues();
-        for ( std::vector<double>::const_iterator iValue = segmentValues.begin();
-             iValue != segmentValues.end(); ++iValue )
-            directionValues.push_back( *iValue );
-    }
-    
-    directionValues.shrink_to_fit();
-    return directionValues;
+    ScratchKinematics scratch;
+    return this->kinematics( scratch ).directionValues();
 }
 
 
@@ -288,299 +217,154 @@ Trip::directionValues() const
 std::vector< std::tuple<double,double,double> >
 Trip::speedAccelerationDirectionValues() const
 {
-    const_cast<Trip&>(*this).generateSegments();
     std::vector< std::tuple<double,double,double> > speedAccelerationDirectionValues;
-    speedAccelerationDirectionValues.reserve( m_rawData.size() - 2 );
-    
-    for ( std::vector< Segment* >::const_iterator iSegment = m_segments.begin();
-         iSegment != m_segments.end(); ++iSegment ) {
-        std::vector< std::tuple<double,double,double> > segmentValues = (*iSegment)->speedAccelerationDirectionValues();
-        for ( std::vector< std::tuple<double,double,double> >::const_iterator iValue = segmentValues.begin();
-             iValue != segmentValues.end(); ++iValue )
-            speedAccelerationDirectionValues.push_back( *iValue );
-    }
-    
+    this->visitSpeedAccelerationDirectionValues( [&speedAccelerationDirectionValues]( double speed, double acceleration, double direction ) {
+            speedAccelerationDirectionValues.push_back( std::make_tuple( speed, acceleration, direction ) );
+        } );
     return speedAccelerationDirectionValues;
-    
 }
 
 
-
-long
-Trip::numberOfSegments() const
+const TripKinematics*
+Trip::cachedKinematics() const
 {
     const_cast<Trip&>(*this).generateSegments();
-    return m_segments.size();
+    if ( m_kinematicsCached.load( std::memory_order_acquire ) ) return m_kinematics.get();
+    if ( ! s_cacheKinematics.load( std::memory_order_relaxed ) ) return 0;
+    
+    std::lock_guard< std::mutex > lock( initialisationMutex( this ) );
+    if ( m_kinematicsCached.load( std::memory_order_relaxed ) ) return m_kinematics.get();
+    std::shared_ptr< TripKinematics > kinematics = std::make_shared< TripKinematics >();
+    kinematics->compute( m_segments );
+    const_cast<Trip&>(*this).m_kinematics = kinematics;
+    const_cast<Trip&>(*this).m_kinematicsCached.store( true, std::memory_order_release );
+    return m_kinematics.get();
 }
 
 
-const std::vector< Segment* >&
-Trip::segments() const
+// The scratch kinematics of the thread, and whether a call is using them
+static thread_local TripKinematics threadKinematics;
+static thread_local bool threadKinematicsInUse = false;
+
+Trip::ScratchKinematics::ScratchKinematics():
+  m_threadKinematics( 0 ),
+  m_ownKinematics()
 {
-    const_cast<Trip&>(*this).generateSegments();
-    return m_segments;
+    if ( threadKinematicsInUse ) return;
+    threadKinematicsInUse = true;
+    m_threadKinematics = &threadKinematics;
 }
 
 
-Trip&
-Trip::generateSegments()
+Trip::ScratchKinematics::~ScratchKinematics()
 {
-    if ( m_segmentsGenerated ) return *this;
-    
-    m_extraTravelDuration = 0;
-    m_extraTravelLength = 0;
-    
-        // First pass: correcting for missing segment paths
-        // Look for single long jumps
-        // Estimate the mean speed and add points along the line
-        // Correct for jitter replacing the values of the data
-    
-    std::vector< std::pair< float, float > > rawData = m_rawData;
-    
-    std::vector< std::vector< std::pair< float, float > > > segmentsFirstPass;
-    this->removeZeroSpeedSegments( rawData, segmentsFirstPass );
-    
-        // Second pass: identify zero velocity points.
-        // Remove first and last zero speed points from the trip.
-    std::vector< std::vector< std::pair< float, float > > > segmentsSecondPass;
-    for ( std::vector< std::vector< std::pair< float, float > > >::const_iterator iSegment = segmentsFirstPass.begin();
-         iSegment != segmentsFirstPass.end(); ++iSegment )
-        this->identifyGapsCorrectJitter( *iSegment, segmentsSecondPass );
-    segmentsFirstPass.clear();
-    
-        // Third pass: Remove angular jitter.
-    std::vector< std::vector< std::pair< float, float > > > segmentsThirdPass;
-    for ( std::vector< std::vector< std::pair< float, float > > >::const_iterator iSegment = segmentsSecondPass.begin();
-         iSegment != segmentsSecondPass.end(); ++iSegment )
-        this->removeAccuteAngleSegments( *iSegment, segmentsThirdPass );
-    segmentsSecondPass.clear();
-    
-        // Fourth pass: Treat the gap and the jitters again
-    std::vector< std::vector< std::pair< float, float > > > segmentsFourthPass;
-    for ( std::vector< std::vector< std::pair< float, float > > >::const_iterator iSegment = segmentsThirdPass.begin();
-         iSegment != segmentsThirdPass.end(); ++iSegment )
-        this->identifyGapsCorrectJitter( *iSegment, segmentsFourthPass );
-    segmentsThirdPass.clear();
-    
-    
-        // Now create the segment objects;
-    for ( std::vector< std::vector< std::pair< float, float > > >::const_iterator iSegment = segmentsFourthPass.begin();
-         iSegment != segmentsFourthPass.end(); ++iSegment )
-        m_segments.push_back( new Segment( *iSegment ) );
-    
-    m_segmentsGenerated = true;
-    return *this;
+    if ( m_threadKinematics != 0 ) threadKinematicsInUse = false;
 }
 
 
+const TripKinematics&
+Trip::kinematics( ScratchKinematics& scratch ) const
+{
+    const TripKinematics* kinematics = this->cachedKinematics();
+    if ( kinematics != 0 ) return *kinematics;
+    return scratch.kinematics().compute( m_segments );
+}
+
 
+std::shared_ptr< const TripKinematics >
+Trip::kinematics() const
+{
+    if ( this->cachedKinematics() != 0 ) return m_kinematics;
+    std::shared_ptr< TripKinematics > kinematics = std::make_shared< TripKinematics >();
+    kinematics->compute( m_segments );
+    return kinematics;
+}
 
 
-Trip&
-Trip::identifyGapsCorrectJitter( const std::vector< std::pair< float, float > >& tripData,
-                                std::vector< std::vector< std::pair< float, float > > >& segments )
+size_t
+Trip::kinematicsMemoryUsage() const
 {
-    const double maxAcceleration = 5; // The maximum acceleration allowed in a segment
-    const double speedToTrigger = 10; // combined with a jump of 35 metres
-    
-    double v_previous = 0;
-    std::pair<float,float> p_previous = tripData[0];
-    size_t i = 1;
-    size_t segmentStartingIndex = 0;
-    
-    while ( i < tripData.size() ) {
-        std::pair<float,float> p_current = tripData[i];
-        double v_current = magnitude( p_current - p_previous );
-        
-            // Check for abrupt high speed and high acceleration in combination with no low speed.
-        if ( ( std::abs( v_current - v_previous ) > maxAcceleration ) &&  v_current > speedToTrigger ) {
-            
-                // Signal the end of the previous segment.
-            size_t nDiff = i - segmentStartingIndex;
-            if ( nDiff > 1 ) {
-                std::vector< std::pair< float, float > > segment( tripData.begin() + segmentStartingIndex, tripData.begin() + i );
-                segments.push_back( segment );
-            }
-            else {
-                    // Correct duration and length of trip for the skipped mini-segment.
-                if ( i < tripData.size() - 1 ) {
-                    std::pair<float,float> p_next = tripData[i];
-                    double v_next = magnitude( p_next - p_current );
-                    if ( std::abs( v_current - v_next ) < maxAcceleration ) {
-                        m_extraTravelDuration += 1;
-                        m_extraTravelLength += magnitude( p_next - p_previous );
-                    }
-                }
-            }
-            
-                // Check whether this is a jitter or a gap and adjust the starting index accordingly, as well as the correction to the travel length and time.
-            if ( i < tripData.size() - 1 ) {
-                
-                std::pair<float,float> p_next = tripData[i+1];
-                double v_next = magnitude( p_next - p_current );
-                if ( std::abs( v_current - v_next ) > maxAcceleration ) { // This is a gap
-                    double averageSpeedInGap = 0.5 * ( v_next + v_previous );
-                    double distanceSpentInGap = magnitude( p_current - p_previous );
-                    m_extraTravelLength += distanceSpentInGap;
-                    m_extraTravelDuration += static_cast<int>( std::nearbyint( distanceSpentInGap / averageSpeedInGap ) );
-                    segmentStartingIndex = i;
-                    ++i;
-                    p_current = p_next;
-                    v_current = v_next;
-                }
-                else { // This is a jitter. Check whether we have a sequence of spikes and skip them.
-                    size_t j = i + 2;
-                    bool endOfSpikesFound = false;
-                    while ( j < tripData.size() - 1 ) {
-                        std::pair<float,float> p_nnext = tripData[j];
-                        double v_nnext = magnitude( p_next - p_nnext );
-                        std::pair<float,float> p_nnnext = tripData[j+1];
-                        double v_nnnext = magnitude( p_nnnext - p_nnext );
-                        
-                        if ( std::abs( v_nnnext - v_nnext ) < maxAcceleration ) { // End of spikes.
-                            double averageSpeedInGap = 0.5 * ( v_nnext + v_previous );
-                            double distanceSpentInGap = magnitude( p_next - p_previous );
-                            m_extraTravelLength += distanceSpentInGap;
-                            m_extraTravelDuration += static_cast<int>( std::nearbyint( distanceSpentInGap / averageSpeedInGap ) );
-                            i = j;
-                            segmentStartingIndex = i-1;
-                            p_current = p_next;
-                            v_current = averageSpeedInGap;
-                            endOfSpikesFound = true;
-                            break;
-                        }
-                        ++j;
-                        p_next = p_nnext;
-                    }
-                    if ( ! endOfSpikesFound ) {
-                        i = j;
-                        segmentStartingIndex = i;
-                    }
-                }
-            }
-        }
-        
-        p_previous = p_current;
-        v_previous = v_current;
-        ++i;
-    }
-    
-    
-    if ( tripData.size() - segmentStartingIndex > 2 ) {
-        std::vector< std::pair< float, float > > segment( tripData.begin()+segmentStartingIndex, tripData.end() );
-        segments.push_back( segment );
-    }
-    
-    return *this;
+    if ( ! m_kinematicsCached.load( std::memory_order_acquire ) ) return 0;
+    return sizeof(TripKinematics) + m_kinematics->memoryUsage();
 }
 
 
+std::atomic< bool > Trip::s_cacheKinematics( true );
 
-static double
-angleAmongVectors( const std::pair<float,float>& v1,
-                  const std::pair<float,float>& v2 )
-{
-    const double pi = std::atan( 1.0 ) * 4;
-    double mv1 = std::sqrt( std::pow(v1.first,2) + std::pow(v1.second, 2) );
-    if (mv1 == 0 ) return 0;
-    double mv2 = std::sqrt( std::pow(v2.first,2) + std::pow(v2.second, 2) );
-    if (mv2 == 0 ) return 0;
-    double mvv = mv1 * mv2;
-    double sint = ( v1.first * v2.second - v1.second * v2.first ) / mvv;
-    double cost = ( v1.first * v2.first + v1.second * v2.second ) / mvv;
-    if ( sint > 1 ) sint = 1;
-    if ( sint < -1 ) sint = -1;
-    if (cost >= 0  )
-        return std::asin( sint );
-    else {
-        if (sint > 0 )
-            return pi - std::asin( sint );
-        else {
-            if ( cost > 1 ) cost = 1;
-            if ( cost < -1 ) cost = -1;
-            return - std::acos( cost );
-        }
-    }
+void
+Trip::setKinematicsCaching( bool cacheKinematics )
+{
+    s_cacheKinematics = cacheKinematics;
 }
 
 
-Trip&
-Trip::removeAccuteAngleSegments( const std::vector< std::pair< float, float > >& tripData,
-                                std::vector< std::vector< std::pair< float, float > > >& segments )
+
+long
+Trip::numberOfSegments() const
 {
-    const double maxAngle = 100 * pi / 180.0; // 100 degrees turn in a second!
-    
-    size_t segentStartingIndex = 0;
-    
-    std::pair<float, float> v_previous = tripData[1]-tripData[0];
-    size_t i = 2;
-    while ( i < tripData.size() ) {
-        std::pair<float, float> v_current = tripData[i] - tripData[i-1];
-        double angle = angleAmongVectors( v_current, v_previous );
-        
-        if ( std::abs( angle ) > maxAngle ) {
-            if ( i - segentStartingIndex > 2 ) {
-                std::vector< std::pair< float, float > > segment( tripData.begin() + segentStartingIndex, tripData.begin() + i - 1 );
-                segments.push_back( segment );
-            }
-            
-            m_extraTravelDuration += 2;
-            m_extraTravelLength += magnitude(tripData[i-2] - tripData[i]);
-            
-            segentStartingIndex = i;
-            i += 2;
-            if ( i - 1 < tripData.size() )
-                v_previous = tripData[i-1] - tripData[i-2];
-            continue;
-        }
-        v_previous = v_current;
-        ++i;
-    }
-    
-    if ( tripData.size() - segentStartingIndex > 2 ) {
-        std::vector< std::pair< float, float > > segment( tripData.begin()+segentStartingIndex, tripData.end() );
-        segments.push_back( segment );
-    }
-    
+    const_cast<Trip&>(*this).generateSegments();
+    return m_segments.size();
+}
+
+
+const Trip&
+Trip::prepare() const
+{
+    this->cachedKinematics();
     return *this;
 }
 
 
+const std::vector< Segment >&
+Trip::segments() const
+{
+    const_cast<Trip&>(*this).generateSegments();
+    return m_segments;
+}
+
 
 Trip&
-Trip::removeZeroSpeedSegments( const std::vector< std::pair< float, float > >& tripData,
-                              std::vector< std::vector< std::pair< float, float > > >& segments )
+Trip::generateSegments()
 {
-    const double zeroSpeedTolerance = 1.5;
-    
-    size_t segentStartingIndex = 0;
-    size_t zeroSpeedCounter = 0;
-    std::pair<float, float> p_previous = tripData[0];
-    for (size_t i = 1; i < tripData.size(); ++i ) {
-        std::pair<float, float> p_current = tripData[i];
-        double v_current = magnitude( p_current - p_previous );
-        
-        if ( v_current < zeroSpeedTolerance ) {
-            if ( zeroSpeedCounter == 0 ) { // Mark the end of a segment and beginning of a zero speed sequence
-                if ( i - segentStartingIndex > 1 ) {
-                    std::vector< std::pair< float, float > > segment( tripData.begin() + segentStartingIndex, tripData.begin() + i );
-                    segments.push_back( segment );
-                }
-            }
-            zeroSpeedCounter += 1;
-            segentStartingIndex = i;
-        }
-        else {
-            zeroSpeedCounter = 0;
+    if ( m_segmentsGenerated.load( std::memory_order_acquire ) ) return *this;
+    
+        // The first caller generates the segments; concurrent callers wait for it
+    std::lock_guard< std::mutex > lock( initialisationMutex( this ) );
+    if ( m_segmentsGenerated.load( std::memory_order_relaxed ) ) return *this;
+    
+        // Each thread keeps its own engine, reusing the scratch buffers for all the trips it segments
+    static thread_local TripSegmentation segmentation;
+    const std::vector< TripCoordinates >& segmentsCoordinates = segmentation.segment( m_rawData );
+    m_extraTravelDuration = segmentation.extraTravelDuration();
+    m_extraTravelLength = segmentation.extraTravelLength();
+    
+        // Now store the velocity vectors of all segments one after the other
+    size_t numberOfVelocityVectors = 0;
+    for ( std::vector< TripCoordinates >::const_iterator iSegment = segmentsCoordinates.begin();
+         iSegment != segmentsCoordinates.end(); ++iSegment )
+        numberOfVelocityVectors += iSegment->size() - 1;
+    AlignedArray< float >( numberOfVelocityVectors ).swap( m_velocityX );
+    AlignedArray< float >( numberOfVelocityVectors ).swap( m_velocityY );
+    
+        // and create the segment objects viewing them
+    m_segments.reserve( segmentsCoordinates.size() );
+    float* vx = m_velocityX.data();
+    float* vy = m_velocityY.data();
+    for ( std::vector< TripCoordinates >::const_iterator iSegment = segmentsCoordinates.begin();
+         iSegment != segmentsCoordinates.end(); ++iSegment ) {
+        const float* x = iSegment->x();
+        const float* y = iSegment->y();
+        const size_t numberOfSegmentVectors = iSegment->size() - 1;
+        for (size_t i = 0; i < numberOfSegmentVectors; ++i ) {
+            vx[i] = x[i+1] - x[i];
+            vy[i] = y[i+1] - y[i];
         }
-        p_previous = p_current;
-    }
-    
-    if ( tripData.size() - segentStartingIndex > 2 ) {
-        std::vector< std::pair< float, float > > segment( tripData.begin()+segentStartingIndex, tripData.end() );
-        segments.push_back( segment );
+        m_segments.push_back( Segment( iSegment->front(), vx, vy, numberOfSegmentVectors ) );
+        vx += numberOfSegmentVectors;
+        vy += numberOfSegmentVectors;
     }
     
+    m_segmentsGenerated.store( true, std::memory_order_release );
     return *this;
 }
 
@@ -609,30 +393,39 @@ Trip::directionQuantiles() const
 }
 
 
-std::valarray< double >
-Trip::rollingFFT( long sampleSize ) const
+// The magnitudes of the first bins of the DFT of every window of sampleSize values within the segments, averaged over
+// the windows, or empty without any window. The values of a segment are [offset(i), offset(i+1)) of the series.
+// With logarithmicMagnitudes the averages are of log10( 1 + magnitude )
+template< size_t (TripKinematics::*Offset)( size_t ) const >
+static std::valarray< double >
+rollingSpectrum( const TripKinematics& kinematics, const std::vector<double>& values, long sampleSize, bool logarithmicMagnitudes )
 {
-    const_cast<Trip&>(*this).generateSegments();
-    
     long numberOfTransformations = 0;
     long transformationSize = static_cast<long>( std::floor( (sampleSize - 1 ) / 2 ) ) + (sampleSize+1)%2;
     
     std::valarray< double > result( 0.0, transformationSize );
+    const size_t windowSize = static_cast<size_t>( sampleSize );
+    SlidingDFT slidingDFT( windowSize, transformationSize );
+    const std::vector<double>& magnitudes = slidingDFT.magnitudes();
+    std::vector<double> logarithms( logarithmicMagnitudes ? transformationSize : 0 );
+    const FastMath::Mode mode = FastMath::mode();
     
         // Loop over the segments
-    for ( std::vector< Segment* >::const_iterator iSegment = m_segments.begin();
-         iSegment != m_segments.end(); ++iSegment ) {
+    for ( size_t iSegment = 0; iSegment < kinematics.numberOfSegments(); ++iSegment ) {
+        const double* segmentBegin = values.data() + (kinematics.*Offset)( iSegment );
+        const size_t numberOfValues = (kinematics.*Offset)( iSegment + 1 ) - (kinematics.*Offset)( iSegment );
         
-            // Get the speed values
-        std::vector<double> segmentValues = (*iSegment)->speedValues();
-        
-        size_t startingIndex = 0;
-        size_t endIndex = sampleSize;
-        while ( endIndex <= segmentValues.size() ) {
-            std::vector<double> sample( segmentValues.begin() + startingIndex, segmentValues.begin() + endIndex );
-            result += vfft( sample );
-            ++startingIndex;
-            ++endIndex;
+            // Slide the window over the segment
+        for ( size_t startingIndex = 0; startingIndex + windowSize <= numberOfValues; ++startingIndex ) {
+            if ( startingIndex == 0 ) slidingDFT.start( segmentBegin );
+            else slidingDFT.slide( segmentBegin + startingIndex );
+            if ( logarithmicMagnitudes ) {
+                for (size_t i = 0; i < result.size(); ++i ) logarithms[i] = 1 + magnitudes[i];
+                FastMath::log10( logarithms.data(), logarithms.size(), logarithms.data(), mode );
+                for (size_t i = 0; i < result.size(); ++i ) result[i] += logarithms[i];
+            }
+            else
+                for (size_t i = 0; i < result.size(); ++i ) result[i] += magnitudes[i];
             ++numberOfTransformations;
         }
     }
@@ -646,39 +439,25 @@ Trip::rollingFFT( long sampleSize ) const
 }
 
 
+std::valarray< double >
+Trip::rollingFFT( long sampleSize ) const
+{
+    ScratchKinematics scratch;
+    return this->rollingFFT( this->kinematics( scratch ), sampleSize );
+}
+
+
+std::valarray< double >
+Trip::rollingFFT( const TripKinematics& kinematics, long sampleSize ) const
+{
+    return rollingSpectrum< &TripKinematics::speedOffset >( kinematics, kinematics.speedValues(), sampleSize, false );
+}
+
 
 std::valarray< double >
 Trip::rollingFFT_direction( long sampleSize ) const
 {
-    const_cast<Trip&>(*this).generateSegments();
-    
-    long numberOfTransformations = 0;
-    long transformationSize = static_cast<long>( std::floor( (sampleSize - 1 ) / 2 ) ) + (sampleSize+1)%2;
-    
-    std::valarray< double > result( 0.0, transformationSize );
-    
-        // Loop over the segments
-    for ( std::vector< Segment* >::const_iterator iSegment = m_segments.begin();
-         iSegment != m_segments.end(); ++iSegment ) {
-        
-            // Get the speed values
-        std::vector<double> segmentValues = (*iSegment)->angularValues();
-        
-        size_t startingIndex = 0;
-        size_t endIndex = sampleSize;
-        while ( endIndex <= segmentValues.size() ) {
-            std::vector<double> sample( segmentValues.begin() + startingIndex, segmentValues.begin() + endIndex );
-            result += std::log10( 1 + vfft( sample ) );
-            ++startingIndex;
-            ++endIndex;
-            ++numberOfTransformations;
-        }
-    }
-    
-    if ( numberOfTransformations == 0 )  // Return an empty vector
-        return std::valarray< double >();
-    
-    for (size_t i = 0; i < result.size(); ++i ) result[i] /= numberOfTransformations;
-    
-    return result;
+    ScratchKinematics scratch;
+    const TripKinematics& kinematics = this->kinematics( scratch );
+    return rollingSpectrum< &TripKinematics::directionOffset >( kinematics, kinematics.directionValues(), sampleSize, true );
 }
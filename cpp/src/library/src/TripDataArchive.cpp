@@ -0,0 +1,150 @@
+#include "TripDataArchive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <exception>
+#include <stdexcept>
+
+static_assert( sizeof( TripDataArchiveEntry ) == 24, "unexpected padding in TripDataArchiveEntry" );
+static_assert( sizeof( TripDataArchiveHeader ) == 32, "unexpected padding in TripDataArchiveHeader" );
+
+static bool entryLess( const TripDataArchiveEntry& lhs, const TripDataArchiveEntry& rhs )
+{
+    if ( lhs.driverId != rhs.driverId ) return lhs.driverId < rhs.driverId;
+    return lhs.tripId < rhs.tripId;
+}
+
+static bool entryOffsetLess( const TripDataArchiveEntry& lhs, uint64_t offset )
+{
+    return lhs.offset < offset;
+}
+
+// Returns whether the points of an entry lie within the point data region [ sizeof(header), dataEndOffset )
+static bool entryInDataRegion( const TripDataArchiveEntry& entry, uint64_t dataEndOffset )
+{
+    return entry.offset >= sizeof( TripDataArchiveHeader ) && entry.offset <= dataEndOffset &&
+        entry.pointCount <= ( dataEndOffset - entry.offset ) / sizeof( std::pair<float,float> );
+}
+
+
+TripDataArchive::TripDataArchive( const std::string& archiveFileName ):
+  m_file(),
+  m_header(),
+  m_entries()
+{
+    m_file.open( archiveFileName, std::ios::in | std::ios::binary );
+    if (! m_file.is_open() )
+        throw std::runtime_error( "TripDataArchive::TripDataArchive : could not open " + archiveFileName );
+    
+    m_file.read( (char*) &m_header, sizeof(m_header) );
+    if ( ! m_file || std::memcmp( m_header.magic, "AXATRIPS", sizeof(m_header.magic) ) != 0 )
+        throw std::runtime_error( "TripDataArchive::TripDataArchive : not a trip data archive" );
+    if ( m_header.version != currentVersion || m_header.entrySize != sizeof( TripDataArchiveEntry ) )
+        throw std::runtime_error( "TripDataArchive::TripDataArchive : unsupported archive version" );
+    
+    // The directory must fit between the point data and the end of the file
+    m_file.seekg( 0, std::ios::end );
+    const uint64_t fileSize = static_cast<uint64_t>( m_file.tellg() );
+    if ( m_header.directoryOffset < sizeof( m_header ) || m_header.directoryOffset > fileSize ||
+         m_header.numberOfEntries > ( fileSize - m_header.directoryOffset ) / sizeof( TripDataArchiveEntry ) )
+        throw std::runtime_error( "TripDataArchive::TripDataArchive : truncated directory" );
+    
+    // Read the directory in one go
+    m_entries.resize( m_header.numberOfEntries );
+    m_file.seekg( m_header.directoryOffset );
+    m_file.read( (char*) m_entries.data(), m_entries.size() * sizeof( TripDataArchiveEntry ) );
+    if ( ! m_file )
+        throw std::runtime_error( "TripDataArchive::TripDataArchive : truncated directory" );
+    
+    // The lookups rely on the entries being sorted by driver and trip id, with their points laid out in that order
+    for ( size_t i = 0; i < m_entries.size(); ++i ) {
+        if ( ! entryInDataRegion( m_entries[i], m_header.directoryOffset ) )
+            throw std::runtime_error( "TripDataArchive::TripDataArchive : trip data outside the point data region" );
+        if ( i > 0 && ( ! entryLess( m_entries[i - 1], m_entries[i] ) ||
+                        m_entries[i - 1].offset + m_entries[i - 1].pointCount * sizeof( std::pair<float,float> ) > m_entries[i].offset ) )
+            throw std::runtime_error( "TripDataArchive::TripDataArchive : the directory is not sorted" );
+    }
+}
+
+TripDataArchive::~TripDataArchive()
+{}
+
+
+std::vector< int >
+TripDataArchive::driverIds() const
+{
+    std::vector< int > result;
+    for ( std::vector< TripDataArchiveEntry >::const_iterator iEntry = m_entries.begin();
+         iEntry != m_entries.end(); ++iEntry ) {
+        if ( result.empty() || result.back() != iEntry->driverId )
+            result.push_back( iEntry->driverId );
+    }
+    return result;
+}
+
+
+const TripDataArchiveEntry*
+TripDataArchive::findTrip( int driverId, int tripId ) const
+{
+    TripDataArchiveEntry key;
+    key.driverId = driverId;
+    key.tripId = tripId;
+    std::vector< TripDataArchiveEntry >::const_iterator iEntry = std::lower_bound( m_entries.begin(), m_entries.end(), key, entryLess );
+    if ( iEntry == m_entries.end() || iEntry->driverId != driverId || iEntry->tripId != tripId )
+        return 0;
+    return &( *iEntry );
+}
+
+
+std::pair< size_t, size_t >
+TripDataArchive::driverEntries( int driverId ) const
+{
+    TripDataArchiveEntry first;
+    first.driverId = driverId;
+    first.tripId = std::numeric_limits<int32_t>::min();
+    TripDataArchiveEntry last;
+    last.driverId = driverId;
+    last.tripId = std::numeric_limits<int32_t>::max();
+    
+    std::vector< TripDataArchiveEntry >::const_iterator iFirst = std::lower_bound( m_entries.begin(), m_entries.end(), first, entryLess );
+    std::vector< TripDataArchiveEntry >::const_iterator iLast = std::upper_bound( iFirst, m_entries.end(), last, entryLess );
+    return std::make_pair( iFirst - m_entries.begin(), iLast - m_entries.begin() );
+}
+
+
+std::pair< size_t, size_t >
+TripDataArchive::entriesInByteRange( uint64_t beginOffset, uint64_t endOffset ) const
+{
+    // The writer lays out the point data in directory order, so the offsets are sorted too
+    std::vector< TripDataArchiveEntry >::const_iterator iFirst = std::lower_bound( m_entries.begin(), m_entries.end(), beginOffset, entryOffsetLess );
+    std::vector< TripDataArchiveEntry >::const_iterator iLast = std::lower_bound( iFirst, m_entries.end(), endOffset, entryOffsetLess );
+    return std::make_pair( iFirst - m_entries.begin(), iLast - m_entries.begin() );
+}
+
+
+std::vector< std::pair<float,float> >
+TripDataArchive::readTrip( const TripDataArchiveEntry& entry )
+{
+    if ( ! entryInDataRegion( entry, m_header.directoryOffset ) )
+        throw std::runtime_error( "TripDataArchive::readTrip : trip data outside the point data region" );
+    std::vector< std::pair<float,float> > tripData( entry.pointCount );
+    m_file.clear();
+    m_file.seekg( entry.offset );
+    m_file.read( (char*) tripData.data(), tripData.size() * sizeof( std::pair<float,float> ) );
+    if ( ! m_file )
+        throw std::runtime_error( "TripDataArchive::readTrip : could not read the trip data" );
+    return tripData;
+}
+
+
+std::vector< std::pair< int, std::vector< std::pair<float,float> > > >
+TripDataArchive::readDriver( int driverId )
+{
+    std::pair< size_t, size_t > range = this->driverEntries( driverId );
+    std::vector< std::pair< int, std::vector< std::pair<float,float> > > > result;
+    result.reserve( range.second - range.first );
+    for ( size_t i = range.first; i < range.second; ++i )
+        result.push_back( std::make_pair( m_entries[i].tripId, this->readTrip( m_entries[i] ) ) );
+    return result;
+}
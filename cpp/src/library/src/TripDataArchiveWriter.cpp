@@ -0,0 +1,94 @@
+#include "TripDataArchiveWriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+
+TripDataArchiveWriter::TripDataArchiveWriter( const std::string& archiveFileName ):
+  m_file(),
+  m_offset( 0 ),
+  m_entries()
+{
+    m_file.open( archiveFileName, std::ios::out | std::ios::binary | std::ios::trunc );
+    if (! m_file.is_open() )
+        throw std::runtime_error( "TripDataArchiveWriter::TripDataArchiveWriter : could not open " + archiveFileName );
+    
+    // Reserve the space for the header. It is written when closing
+    TripDataArchiveHeader header;
+    std::memset( &header, 0, sizeof(header) );
+    m_file.write( (const char*) &header, sizeof(header) );
+    m_offset = sizeof(header);
+}
+
+TripDataArchiveWriter::~TripDataArchiveWriter()
+{
+    try {
+        if ( m_file.is_open() ) this->close();
+    }
+    catch ( ... ) {}
+}
+
+
+TripDataArchiveWriter&
+TripDataArchiveWriter::addDriver( int driverId,
+                                  const std::vector< std::pair< int, std::vector< std::pair<float,float> > > >& tripData )
+{
+    // Write the trips in trip id order so that the directory and the data share the same ordering
+    std::vector< std::pair< int, size_t > > tripOrder;
+    tripOrder.reserve( tripData.size() );
+    for ( size_t i = 0; i < tripData.size(); ++i ) tripOrder.push_back( std::make_pair( tripData[i].first, i ) );
+    std::sort( tripOrder.begin(), tripOrder.end() );
+    
+    for ( std::vector< std::pair< int, size_t > >::const_iterator iTrip = tripOrder.begin();
+         iTrip != tripOrder.end(); ++iTrip ) {
+        const std::vector< std::pair<float,float> >& points = tripData[iTrip->second].second;
+        TripDataArchiveEntry entry;
+        entry.driverId = driverId;
+        entry.tripId = iTrip->first;
+        entry.offset = m_offset;
+        entry.pointCount = points.size();
+        
+        const size_t dataSize = points.size() * sizeof( std::pair<float,float> );
+        m_file.write( (const char*) points.data(), dataSize );
+        m_offset += dataSize;
+        m_entries.push_back( entry );
+    }
+    
+    if ( ! m_file )
+        throw std::runtime_error( "TripDataArchiveWriter::addDriver : write failed" );
+    return *this;
+}
+
+
+void
+TripDataArchiveWriter::close()
+{
+    // The data are laid out in insertion order; keep the directory sorted by driver and trip id.
+    // Drivers are expected to be added in increasing id order so that both orders coincide.
+    std::stable_sort( m_entries.begin(), m_entries.end(),
+                     [] ( const TripDataArchiveEntry& a, const TripDataArchiveEntry& b ) {
+                         if ( a.driverId != b.driverId ) return a.driverId < b.driverId;
+                         return a.tripId < b.tripId; } );
+    
+    for ( size_t i = 1; i < m_entries.size(); ++i ) {
+        if ( m_entries[i].offset < m_entries[i-1].offset )
+            throw std::runtime_error( "TripDataArchiveWriter::close : drivers were not added in increasing id order" );
+    }
+    
+    TripDataArchiveHeader header;
+    std::memset( &header, 0, sizeof(header) );
+    std::memcpy( header.magic, "AXATRIPS", sizeof(header.magic) );
+    header.version = TripDataArchive::currentVersion;
+    header.entrySize = sizeof( TripDataArchiveEntry );
+    header.numberOfEntries = m_entries.size();
+    header.directoryOffset = m_offset;
+    
+    m_file.write( (const char*) m_entries.data(), m_entries.size() * sizeof( TripDataArchiveEntry ) );
+    m_file.seekp( 0 );
+    m_file.write( (const char*) &header, sizeof(header) );
+    m_file.flush();
+    if ( ! m_file )
+        throw std::runtime_error( "TripDataArchiveWriter::close : write failed" );
+    m_file.close();
+}
@@ -0,0 +1,304 @@
+#include "TripDataCompression.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <stdint.h>
+
+// The quantisation step is 0.1 metres
+static const float quantisationScale = 10.0f;
+
+// Quantised values are limited so that the second differences fit in 32 bits
+static const double maximumQuantisedValue = 134217728.0; // 2^27
+
+// The number of values sharing a bit width
+static const size_t blockSize = 32;
+
+enum TripEncoding {
+    RawEncoding = 0,
+    QuantisedEncoding = 1
+};
+
+
+// Quantises a coordinate. Returns false if the value cannot be restored bit for bit
+inline static bool quantise( float value, int32_t& quantised )
+{
+    const double scaled = static_cast<double>( value ) * quantisationScale;
+    if ( ! ( std::fabs( scaled ) < maximumQuantisedValue ) ) return false;
+    quantised = static_cast<int32_t>( std::lrint( scaled ) );
+    const float restored = static_cast<float>( quantised ) / quantisationScale;
+    return std::memcmp( &restored, &value, sizeof(float) ) == 0;
+}
+
+inline static uint32_t zigZagEncode( int32_t value )
+{
+    return ( static_cast<uint32_t>( value ) << 1 ) ^ static_cast<uint32_t>( value >> 31 );
+}
+
+inline static int32_t zigZagDecode( uint32_t value )
+{
+    return static_cast<int32_t>( ( value >> 1 ) ^ ( 0u - ( value & 1u ) ) );
+}
+
+inline static void appendInt32( int32_t value, std::vector<char>& output )
+{
+    const char* bytes = reinterpret_cast<const char*>( &value );
+    output.insert( output.end(), bytes, bytes + sizeof(value) );
+}
+
+
+// Encodes one coordinate stream: first value, first difference, bit-packed second differences
+static void encodeStream( const std::vector<int32_t>& values, std::vector<char>& output )
+{
+    const size_t n = values.size();
+    if ( n == 0 ) return;
+    appendInt32( values[0], output );
+    if ( n == 1 ) return;
+    appendInt32( values[1] - values[0], output );
+    
+    uint32_t residuals[blockSize];
+    for ( size_t blockStart = 2; blockStart < n; blockStart += blockSize ) {
+        const size_t count = std::min( blockSize, n - blockStart );
+        uint32_t allBits = 0;
+        for ( size_t i = 0; i < count; ++i ) {
+            const size_t j = blockStart + i;
+            residuals[i] = zigZagEncode( values[j] - 2 * values[j-1] + values[j-2] );
+            allBits |= residuals[i];
+        }
+        
+        uint32_t width = 0;
+        while ( width < 32 && ( allBits >> width ) != 0 ) ++width;
+        output.push_back( static_cast<char>( width ) );
+        
+        const size_t packedBytes = ( count * width + 7 ) / 8;
+        const size_t packedStart = output.size();
+        output.resize( packedStart + packedBytes, 0 );
+        unsigned char* packed = reinterpret_cast<unsigned char*>( &output[packedStart] );
+        for ( size_t i = 0; i < count; ++i ) {
+            uint64_t bits = static_cast<uint64_t>( residuals[i] ) << ( ( i * width ) & 7 );
+            size_t byte = ( i * width ) >> 3;
+            while ( bits != 0 ) {
+                packed[byte++] |= static_cast<unsigned char>( bits & 0xff );
+                bits >>= 8;
+            }
+        }
+    }
+}
+
+
+void
+compressTripData( const std::pair<float,float>* points,
+                  size_t numberOfPoints,
+                  std::vector<char>& output )
+{
+    std::vector<int32_t> x( numberOfPoints );
+    std::vector<int32_t> y( numberOfPoints );
+    bool quantisable = true;
+    for ( size_t i = 0; i < numberOfPoints && quantisable; ++i )
+        quantisable = quantise( points[i].first, x[i] ) && quantise( points[i].second, y[i] );
+    
+    if ( ! quantisable ) {
+        output.push_back( static_cast<char>( RawEncoding ) );
+        const char* bytes = reinterpret_cast<const char*>( points );
+        output.insert( output.end(), bytes, bytes + numberOfPoints * sizeof( std::pair<float,float> ) );
+        return;
+    }
+    
+    output.push_back( static_cast<char>( QuantisedEncoding ) );
+    encodeStream( x, output );
+    encodeStream( y, output );
+}
+
+
+// Reads 8 bytes at the given position, without reading beyond the end of the input
+inline static uint64_t loadWord( const unsigned char* p, const unsigned char* end )
+{
+    uint64_t word = 0;
+    if ( end - p >= 8 ) std::memcpy( &word, p, 8 );
+    else if ( end > p ) std::memcpy( &word, p, end - p );
+    return word;
+}
+
+
+// Decodes one coordinate stream into every second float of the output, starting at the given one
+static const unsigned char* decodeStream( const unsigned char* p,
+                                          const unsigned char* end,
+                                          float* output,
+                                          size_t n )
+{
+    if ( n == 0 ) return p;
+    // The integration is done in unsigned arithmetic, so that corrupt input cannot overflow
+    if ( end - p < 4 ) return 0;
+    uint32_t value;
+    std::memcpy( &value, p, 4 );
+    p += 4;
+    output[0] = static_cast<float>( static_cast<int32_t>( value ) ) / quantisationScale;
+    if ( n == 1 ) return p;
+    
+    if ( end - p < 4 ) return 0;
+    uint32_t difference;
+    std::memcpy( &difference, p, 4 );
+    p += 4;
+    value += difference;
+    output[2] = static_cast<float>( static_cast<int32_t>( value ) ) / quantisationScale;
+    
+    uint32_t residuals[blockSize];
+    int32_t values[blockSize];
+    for ( size_t blockStart = 2; blockStart < n; blockStart += blockSize ) {
+        const size_t count = std::min( blockSize, n - blockStart );
+        if ( p == end ) return 0;
+        const uint32_t width = static_cast<unsigned char>( *p++ );
+        if ( width > 32 ) return 0;
+        const size_t packedBytes = ( count * width + 7 ) / 8;
+        if ( static_cast<size_t>( end - p ) < packedBytes ) return 0;
+        
+        // Unpack and undo the zig-zag encoding. Branch free, so that the compiler can vectorise it
+        const uint64_t mask = ( width == 32 ) ? 0xffffffffULL : ( ( 1ULL << width ) - 1 );
+        const unsigned char* packedEnd = p + packedBytes;
+        for ( size_t i = 0; i < count; ++i ) {
+            const size_t bit = i * width;
+            const uint32_t zigZag = static_cast<uint32_t>( ( loadWord( p + ( bit >> 3 ), packedEnd ) >> ( bit & 7 ) ) & mask );
+            residuals[i] = static_cast<uint32_t>( zigZagDecode( zigZag ) );
+        }
+        p = packedEnd;
+        
+        // Integrate twice: second differences to velocities to positions
+        for ( size_t i = 0; i < count; ++i ) {
+            difference += residuals[i];
+            value += difference;
+            values[i] = static_cast<int32_t>( value );
+        }
+        
+        float* blockOutput = output + 2 * blockStart;
+        for ( size_t i = 0; i < count; ++i )
+            blockOutput[2 * i] = static_cast<float>( values[i] ) / quantisationScale;
+    }
+    return p;
+}
+
+
+bool
+decompressTripData( const char* input,
+                    size_t inputSize,
+                    std::pair<float,float>* points,
+                    size_t numberOfPoints )
+{
+    if ( inputSize == 0 ) return false;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>( input );
+    const unsigned char* end = p + inputSize;
+    const int encoding = *p++;
+    
+    if ( encoding == RawEncoding ) {
+        const size_t dataSize = numberOfPoints * sizeof( std::pair<float,float> );
+        if ( static_cast<size_t>( end - p ) != dataSize ) return false;
+        std::memcpy( points, p, dataSize );
+        return true;
+    }
+    
+    if ( encoding != QuantisedEncoding ) return false;
+    
+    float* coordinates = reinterpret_cast<float*>( points );
+    p = decodeStream( p, end, coordinates, numberOfPoints );
+    if ( p == 0 ) return false;
+    p = decodeStream( p, end, coordinates + 1, numberOfPoints );
+    return p == end;
+}
+
+
+// The signature and version of the compressed driver files
+static const char compressedSignature[8] = { 'A', 'X', 'A', 'T', 'R', 'I', 'P', 'Z' };
+// Version 1 has the same layout without the checksum trailer
+static const uint32_t compressedVersion = 2;
+
+template< typename T >
+inline static void appendValue( const T& value, std::vector<char>& output )
+{
+    const char* bytes = reinterpret_cast<const char*>( &value );
+    output.insert( output.end(), bytes, bytes + sizeof(value) );
+}
+
+template< typename T >
+inline static T readValue( const char* data, size_t size, size_t& offset )
+{
+    if ( offset > size || size - offset < sizeof(T) )
+        throw std::runtime_error( "decompressDriverData : truncated file" );
+    T value;
+    std::memcpy( &value, data + offset, sizeof(T) );
+    offset += sizeof(T);
+    return value;
+}
+
+
+bool
+isCompressedDriverData( const char* data, size_t size )
+{
+    return size >= sizeof( compressedSignature ) && std::memcmp( data, compressedSignature, sizeof( compressedSignature ) ) == 0;
+}
+
+
+bool
+compressedDriverDataHasChecksum( const char* data, size_t size )
+{
+    if ( ! isCompressedDriverData( data, size ) ) return false;
+    size_t offset = sizeof( compressedSignature );
+    return readValue<uint32_t>( data, size, offset ) >= 2;
+}
+
+
+void
+compressDriverData( int driverId,
+                    const std::vector< std::pair< int, std::vector< std::pair<float,float> > > >& tripData,
+                    std::vector<char>& output )
+{
+    output.insert( output.end(), compressedSignature, compressedSignature + sizeof( compressedSignature ) );
+    appendValue( compressedVersion, output );
+    appendValue( static_cast<int32_t>( driverId ), output );
+    appendValue( static_cast<uint64_t>( tripData.size() ), output );
+    
+    for ( std::vector< std::pair< int, std::vector< std::pair<float,float> > > >::const_iterator iTrip = tripData.begin();
+         iTrip != tripData.end(); ++iTrip ) {
+        appendValue( static_cast<int32_t>( iTrip->first ), output );
+        appendValue( static_cast<uint64_t>( iTrip->second.size() ), output );
+        // Reserve the encoded size and fill it in after encoding
+        const size_t sizePosition = output.size();
+        appendValue( static_cast<uint64_t>( 0 ), output );
+        compressTripData( iTrip->second.data(), iTrip->second.size(), output );
+        const uint64_t encodedSize = output.size() - sizePosition - sizeof( uint64_t );
+        std::memcpy( &output[sizePosition], &encodedSize, sizeof( encodedSize ) );
+    }
+}
+
+
+void
+decompressDriverData( const char* data,
+                      size_t size,
+                      int& driverId,
+                      std::vector< std::pair< int, std::vector< std::pair<float,float> > > >& tripData )
+{
+    if ( ! isCompressedDriverData( data, size ) )
+        throw std::runtime_error( "decompressDriverData : not a compressed driver file" );
+    size_t offset = sizeof( compressedSignature );
+    const uint32_t version = readValue<uint32_t>( data, size, offset );
+    if ( version < 1 || version > compressedVersion )
+        throw std::runtime_error( "decompressDriverData : unsupported version" );
+    driverId = readValue<int32_t>( data, size, offset );
+    const uint64_t numberOfTrips = readValue<uint64_t>( data, size, offset );
+    
+    tripData.clear();
+    tripData.reserve( numberOfTrips );
+    for ( uint64_t i = 0; i < numberOfTrips; ++i ) {
+        const int tripId = readValue<int32_t>( data, size, offset );
+        const uint64_t numberOfPoints = readValue<uint64_t>( data, size, offset );
+        const uint64_t encodedSize = readValue<uint64_t>( data, size, offset );
+        // Every block of 32 points takes at least two bytes, bounding the allocation for corrupt counts
+        if ( encodedSize > size - offset || numberOfPoints > 16 * encodedSize + 2 )
+            throw std::runtime_error( "decompressDriverData : truncated file" );
+        
+        tripData.push_back( std::make_pair( tripId, std::vector< std::pair<float,float> >( numberOfPoints ) ) );
+        if ( ! decompressTripData( data + offset, encodedSize, tripData.back().second.data(), numberOfPoints ) )
+            throw std::runtime_error( "decompressDriverData : corrupt trip data" );
+        offset += encodedSize;
+    }
+}
@@ -0,0 +1,187 @@
+#include "TripFeatureExtractor.h"
+#include "TripMetrics.h"
+#include "TripKinematics.h"
+#include "QuantileSelection.h"
+#include "FastMath.h"
+#include <cmath>
+
+// The window of the rolling spectrum of the speed, and its bins below the Nyquist frequency
+static const size_t spectrumWindowSize = 11;
+static const size_t spectrumNumberOfBins = ( spectrumWindowSize - 1 ) / 2 + ( spectrumWindowSize + 1 ) % 2;
+
+
+// The argument of a logarithm if it is positive, otherwise NaN, which makes the logarithm undefined
+static inline double
+positiveOrUndefined( double value )
+{
+    return value > 0 ? value : NAN;
+}
+
+
+// Finds the quantiles of the values together with a number of zeros left out of them, as if the zeros were
+// among the values. The values less than zero are the first numberOfNegatives in ascending order, so the
+// zeros take the ranks after them. Returns false, leaving the quantiles untouched, if there are no values at all
+static bool
+selectQuantilesWithZeros( double* begin, double* end, size_t numberOfZeros, size_t numberOfNegatives, QuantileValues& quantiles )
+{
+    const size_t numberOfValues = ( end - begin ) + numberOfZeros;
+    if ( numberOfValues == 0 ) return false;
+
+    std::array< size_t, 5 > ranks;
+    size_t numberOfRanks = 0;
+    for ( size_t i = 0; i < quantilePercentages.size(); ++i ) {
+        const size_t rank = ( numberOfValues * quantilePercentages[i] ) / 100;
+        if ( rank < numberOfNegatives ) ranks[numberOfRanks++] = rank;
+        else if ( rank >= numberOfNegatives + numberOfZeros ) ranks[numberOfRanks++] = rank - numberOfZeros;
+    }
+    multiSelect( begin, end, ranks.data(), numberOfRanks );
+
+    size_t j = 0;
+    for ( size_t i = 0; i < quantilePercentages.size(); ++i ) {
+        const size_t rank = ( numberOfValues * quantilePercentages[i] ) / 100;
+        if ( rank < numberOfNegatives || rank >= numberOfNegatives + numberOfZeros ) quantiles[i] = begin[ ranks[j++] ];
+        else quantiles[i] = 0;
+    }
+    return true;
+}
+
+
+TripFeatureExtractor::TripFeatureExtractor():
+  m_speedValues(),
+  m_accelerationValues(),
+  m_speedXaccelerationValues(),
+  m_directionValues(),
+  m_slidingDFT( spectrumWindowSize, spectrumNumberOfBins )
+{}
+
+
+TripFeatureExtractor::~TripFeatureExtractor()
+{}
+
+
+void
+TripFeatureExtractor::extract( const std::vector< Segment >& segments,
+                               long extraTravelDuration,
+                               double extraTravelLength,
+                               double distanceOfEndPoint,
+                               std::vector< double >& metricsValues )
+{
+    static const size_t numberOfTripMetrics = TripMetrics::descriptions().size();
+    metricsValues.assign( numberOfTripMetrics, NAN );
+
+    size_t j = 0;
+
+    // Check if this is a zero segment trip
+    if ( segments.empty() ) {
+        metricsValues[j++] = 1;
+        return;
+    }
+    metricsValues[j++] = 0;
+
+    // Lay out the segments
+    size_t numberOfSpeedValues = 0;
+    long numberOfPoints = 0;
+    for ( std::vector< Segment >::const_iterator iSegment = segments.begin(); iSegment != segments.end(); ++iSegment ) {
+        numberOfSpeedValues += iSegment->numberOfVelocityVectors();
+        numberOfPoints += iSegment->numberOfDataPoints();
+    }
+    if ( numberOfPoints < TripMetrics::minimumNumberOfPoints() ) {
+        metricsValues[j++] = 1;
+        return;
+    }
+    metricsValues[j++] = 0;
+    const size_t numberOfAccelerationValues = numberOfSpeedValues - segments.size();
+    m_speedValues.resize( numberOfSpeedValues );
+    m_accelerationValues.resize( numberOfAccelerationValues );
+    m_speedXaccelerationValues.resize( numberOfAccelerationValues );
+    m_directionValues.resize( numberOfAccelerationValues );
+
+    // The single traversal of the segments
+    const double directionNoiseThreshold = TripKinematics::directionNoiseThreshold();
+    const std::vector< double >& magnitudes = m_slidingDFT.magnitudes();
+    double spectrum[spectrumNumberOfBins] = {};
+    long numberOfTransformations = 0;
+    double travelLength = 0;
+    long travelDuration = 0;
+    double totalDirectionChange = 0;
+    size_t numberOfNegativeDirections = 0;
+    double* speed = m_speedValues.data();
+    double* acceleration = m_accelerationValues.data();
+    double* speedXacceleration = m_speedXaccelerationValues.data();
+    double* direction = m_directionValues.data();
+    for ( std::vector< Segment >::const_iterator iSegment = segments.begin(); iSegment != segments.end(); ++iSegment ) {
+        const size_t n = iSegment->numberOfVelocityVectors();
+        travelLength += TripKinematics::computeSegment( *iSegment, speed, acceleration, speedXacceleration, direction );
+        travelDuration += iSegment->travelDuration();
+
+        // The turns
+        for ( size_t i = 0; i + 1 < n; ++i ) {
+            const double change = std::abs( direction[i] );
+            if ( change > directionNoiseThreshold ) totalDirectionChange += change;
+            if ( direction[i] < 0 ) ++numberOfNegativeDirections;
+        }
+
+        // The rolling spectrum of the speed within the segment
+        for ( size_t startingIndex = 0; startingIndex + spectrumWindowSize <= n; ++startingIndex ) {
+            if ( startingIndex == 0 ) m_slidingDFT.start( speed );
+            else m_slidingDFT.slide( speed + startingIndex );
+            for ( size_t i = 0; i < spectrumNumberOfBins; ++i ) spectrum[i] += magnitudes[i];
+            ++numberOfTransformations;
+        }
+
+        speed += n;
+        acceleration += n - 1;
+        speedXacceleration += n - 1;
+        direction += n - 1;
+    }
+
+    // The metrics are set to the arguments of their logarithms, which are taken together at the end.
+    // The arguments that are not positive leave the metrics undefined
+    const FastMath::Mode mode = FastMath::mode();
+
+    // Travel duration and length
+    travelDuration += extraTravelDuration;
+    metricsValues[j++] = 1 + travelDuration;
+    const double tripLength = travelLength + extraTravelLength;
+    metricsValues[j++] = 1 + tripLength;
+    FastMath::log10( metricsValues.data() + j - 2, 2, metricsValues.data() + j - 2, mode );
+
+    // Trip length to distance
+    metricsValues[j++] = distanceOfEndPoint / tripLength;
+    const size_t firstLogarithm = j;
+
+    // Speed percentiles. A series without values leaves the percentiles of the previous one
+    QuantileValues percentiles;
+    percentiles.fill( NAN );
+    selectQuantiles( m_speedValues.data(), m_speedValues.data() + m_speedValues.size(), percentiles );
+    for ( size_t i = 1; i <= 4; ++i )
+        metricsValues[j++] = 0.1 + percentiles[i];
+
+    // Acceleration percentiles
+    selectQuantiles( m_accelerationValues.data(), m_accelerationValues.data() + m_accelerationValues.size(), percentiles );
+    metricsValues[j++] = positiveOrUndefined( -percentiles[0] );
+    metricsValues[j++] = positiveOrUndefined( -percentiles[1] );
+    metricsValues[j++] = positiveOrUndefined( percentiles[3] );
+    metricsValues[j++] = positiveOrUndefined( percentiles[4] );
+
+    // Direction percentiles, with the leading zeros of the segments
+    selectQuantilesWithZeros( m_directionValues.data(), m_directionValues.data() + m_directionValues.size(),
+                              numberOfAccelerationValues, numberOfNegativeDirections, percentiles );
+    metricsValues[j++] = positiveOrUndefined( -percentiles[0] );
+    metricsValues[j++] = positiveOrUndefined( percentiles[4] );
+
+    // Speed x Acceleration percentiles
+    selectQuantiles( m_speedXaccelerationValues.data(), m_speedXaccelerationValues.data() + m_speedXaccelerationValues.size(), percentiles );
+    metricsValues[j++] = positiveOrUndefined( -percentiles[0] );
+    metricsValues[j++] = positiveOrUndefined( -percentiles[1] );
+    metricsValues[j++] = positiveOrUndefined( percentiles[3] );
+    metricsValues[j++] = positiveOrUndefined( percentiles[4] );
+
+    // Total turns
+    metricsValues[j++] = 0.001 + ( tripLength == 0 ? 0 : totalDirectionChange / tripLength );
+    FastMath::log10( metricsValues.data() + firstLogarithm, j - firstLogarithm, metricsValues.data() + firstLogarithm, mode );
+
+    // The rolling spectrum, averaged over the windows
+    if ( numberOfTransformations > 0 )
+        for ( size_t i = 0; i < spectrumNumberOfBins; ++i ) metricsValues[j + i] = spectrum[i] / numberOfTransformations;
+}
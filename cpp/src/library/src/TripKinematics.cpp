@@ -0,0 +1,85 @@
+#include "TripKinematics.h"
+#include "Segment.h"
+#include "KinematicsKernels.h"
+
+TripKinematics::TripKinematics():
+  m_speedValues(),
+  m_accelerationValues(),
+  m_speedXaccelerationValues(),
+  m_directionValues(),
+  m_speedOffsets(),
+  m_travelLength( 0 ),
+  m_travelDuration( 0 )
+{}
+
+
+TripKinematics::~TripKinematics()
+{}
+
+
+TripKinematics&
+TripKinematics::compute( const std::vector< Segment >& segments )
+{
+    // Lay out the segments
+    m_speedOffsets.resize( segments.size() + 1 );
+    m_speedOffsets[0] = 0;
+    for ( size_t i = 0; i < segments.size(); ++i )
+        m_speedOffsets[i + 1] = m_speedOffsets[i] + segments[i].numberOfVelocityVectors();
+    const size_t numberOfSpeedValues = m_speedOffsets.back();
+    m_speedValues.resize( numberOfSpeedValues );
+    m_accelerationValues.resize( numberOfSpeedValues - segments.size() );
+    m_speedXaccelerationValues.resize( numberOfSpeedValues - segments.size() );
+    m_directionValues.assign( 2 * ( numberOfSpeedValues - segments.size() ), 0.0 );
+
+    m_travelLength = 0;
+    m_travelDuration = 0;
+    for ( size_t iSegment = 0; iSegment < segments.size(); ++iSegment ) {
+        const Segment& segment = segments[iSegment];
+        const size_t n = segment.numberOfVelocityVectors();
+
+        // The kinematic values, with the direction values after the leading zeros of the segment
+        m_travelLength += computeSegment( segment,
+                                          m_speedValues.data() + this->speedOffset( iSegment ),
+                                          m_accelerationValues.data() + this->accelerationOffset( iSegment ),
+                                          m_speedXaccelerationValues.data() + this->accelerationOffset( iSegment ),
+                                          m_directionValues.data() + this->directionOffset( iSegment ) + ( n - 1 ) );
+        m_travelDuration += segment.travelDuration();
+    }
+
+    return *this;
+}
+
+
+double
+TripKinematics::computeSegment( const Segment& segment, double* speed, double* acceleration,
+                                double* speedXacceleration, double* direction )
+{
+    const KinematicsKernels& kernels = KinematicsKernels::best();
+    const size_t n = segment.numberOfVelocityVectors();
+    const float* vx = segment.velocityX();
+    const float* vy = segment.velocityY();
+    kernels.speed( vx, vy, n, speed );
+    kernels.acceleration( speed, n, acceleration, speedXacceleration );
+    kernels.direction( vx, vy, speed, n, direction );
+
+    // The distance travelled is summed up per segment, as in Segment::travelLength
+    double distance = 0;
+    for ( size_t i = 0; i < n; ++i ) distance += speed[i];
+    return distance;
+}
+
+
+double
+TripKinematics::directionNoiseThreshold()
+{
+    return 0.035;
+}
+
+
+size_t
+TripKinematics::memoryUsage() const
+{
+    return ( m_speedValues.capacity() + m_accelerationValues.capacity() +
+             m_speedXaccelerationValues.capacity() + m_directionValues.capacity() ) * sizeof(double) +
+           m_speedOffsets.capacity() * sizeof(size_t);
+}
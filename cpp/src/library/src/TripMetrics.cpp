@@ -57,6 +57,13 @@ TripMetrics::numberOfBinaryMetrics()
 }
 
 
+long
+TripMetrics::minimumNumberOfPoints()
+{
+    return 20;
+}
+
+
 
 std::ostream&
 TripMetrics::writeDescriptions( std::ostream& out ) const
@@ -8,7 +8,39 @@
 #include <cmath>
 #include <algorithm>
 
-TripMetricsReference::TripMetricsReference( const std::vector< TripMetrics >& input,
+// Returns the defined values of a metric in the rows [beginRow, endRow), in the order of the rows
+static std::vector<double>
+definedValues( const FeatureMatrix& input, size_t metric, size_t beginRow, size_t endRow )
+{
+    std::vector<double> values;
+    values.reserve( endRow - beginRow );
+    if ( metric < FeatureMatrix::numberOfBinaryMetrics() ) {
+        for ( size_t row = beginRow; row < endRow; ++row )
+            if ( input.flagDefined( row, metric ) ) values.push_back( input.flag( row, metric ) ? 1 : 0 );
+    }
+    else {
+        const std::vector<double>& column = input.feature( metric - FeatureMatrix::numberOfBinaryMetrics() );
+        for ( size_t row = beginRow; row < endRow; ++row )
+            if ( ! std::isnan( column[row] ) ) values.push_back( column[row] );
+    }
+    return values;
+}
+
+
+// Fills the normalised features of a row into a buffer
+static void
+normalisedRow( const FeatureMatrix& input, size_t row,
+               const std::vector<double>& meanValues, const std::vector<double>& stdValues,
+               std::vector<double>& sample )
+{
+    const size_t numberOfFeatures = FeatureMatrix::numberOfFeatures();
+    sample.resize( numberOfFeatures );
+    for ( size_t iFeature = 0; iFeature < numberOfFeatures; ++iFeature )
+        sample[iFeature] = ( input.feature( iFeature )[row] - meanValues[iFeature] ) / stdValues[iFeature];
+}
+
+
+TripMetricsReference::TripMetricsReference( const FeatureMatrix& input,
                                             long binsForHistograms ):
 m_histograms(),
 m_binsForHistograms( binsForHistograms ),
@@ -17,49 +49,25 @@ m_stdValues(),
 m_pca( 0 )
 {
     // Create the vectors to feed the histograms
-    if ( input.size() == 0 ) {
+    if ( input.empty() ) {
         throw std::runtime_error( "TripMetricsReference::TripMetricsReference : 0 size input given." );
     }
     
-    ProcessLogger log(3, "Building the trip reference : ");
-    
-    const size_t numberOfHistograms = input.front().values().size();
-    
-    std::vector<double> minValues = input.front().values();
-    std::vector<double> maxValues = input.front().values();
-    
-    std::vector< std::vector<double> > allValues( numberOfHistograms, std::vector<double>() );
-    
-    // Loop over the trip metrics and fill in the valarrays, minimum and maximum values
-    for ( size_t iMetric = 0; iMetric < input.size(); ++iMetric ) {
-        
-        const std::vector<double>& metricValues = input[iMetric].values();
-        
-        for ( size_t iValue = 0; iValue < numberOfHistograms; ++iValue ) {
-            if ( std::isnan(metricValues[iValue])) continue;
-            double currentValue = metricValues[iValue];
-            allValues[iValue].push_back( currentValue );
-            if ( std::isnan(minValues[iValue]) || currentValue < minValues[iValue] ) minValues[iValue] = currentValue;
-            if ( std::isnan(maxValues[iValue]) || currentValue > maxValues[iValue] ) maxValues[iValue] = currentValue;
-        }
-    }
+    ProcessLogger log(2, "Building the trip reference : ");
     
-    log.taskEnded();
+    const size_t numberOfHistograms = FeatureMatrix::numberOfMetrics();
     
-    // For each vector create the corresponding histogram
+    // For each metric create the corresponding histogram from its defined values
     for ( size_t iValue = 0; iValue < numberOfHistograms; ++iValue ) {
-        // Calculate the edges to be 1% of the bin size beyond the minimum and maximum value
-        double lowEdge = minValues[iValue];
-        double highEdge = maxValues[iValue];
-        std::vector<double>& valuesForMetric = allValues[iValue];
+        std::vector<double> valuesForMetric = definedValues( input, iValue, 0, input.numberOfRows() );
 
         // Trim extremes!
         std::sort( valuesForMetric.begin(), valuesForMetric.end() );
         const double percentageToKeep = 99.5;
         size_t lowEdgeIndex = static_cast< size_t>(std::floor( valuesForMetric.size() * (100 - percentageToKeep) / 200 ) );
-        lowEdge = valuesForMetric[lowEdgeIndex];
+        double lowEdge = valuesForMetric[lowEdgeIndex];
         size_t highEdgeIndex = static_cast< size_t>(std::floor( valuesForMetric.size() * (100 + percentageToKeep) / 200 ) ) + 1;
-        highEdge = valuesForMetric[highEdgeIndex];
+        double highEdge = valuesForMetric[highEdgeIndex];
 
         double binSize = ( highEdge - lowEdge ) / binsForHistograms;
         highEdge += 0.01 * binSize;
@@ -69,20 +77,12 @@ m_pca( 0 )
                                                binsForHistograms,
                                                lowEdge,
                                                highEdge ) );
-        
-        // Trim the values (so that the sorting is not repeated at the next step
-        valuesForMetric = std::vector<double>( valuesForMetric.begin()+lowEdgeIndex, valuesForMetric.begin()+highEdgeIndex );
     }
     
     log.taskEnded();
     
     // Create the PCA histograms
-    allValues.clear();
-    allValues.reserve( input.size() );
-    for ( std::vector< TripMetrics >::const_iterator iSample = input.begin(); iSample != input.end(); ++iSample )
-        allValues.push_back( iSample->values() );
-    
-    this->performPCA( allValues );
+    this->performPCA( input );
     
     log.taskEnded();
 }
@@ -91,7 +91,9 @@ m_pca( 0 )
 
 
 
-TripMetricsReference::TripMetricsReference( const std::vector< TripMetrics >& input,
+TripMetricsReference::TripMetricsReference( const FeatureMatrix& input,
+                                           size_t beginRow,
+                                           size_t endRow,
                                            long binsForHistograms,
                                            const TripMetricsReference& reference ):
 m_histograms(),
@@ -101,35 +103,19 @@ m_stdValues(),
 m_pca( 0 )
 {
     // Create the vectors to feed the histograms
-    if ( input.size() == 0 ) {
+    if ( endRow <= beginRow ) {
         throw std::runtime_error( "TripMetricsReference::TripMetricsReference : 0 size input given." );
     }
     
-    const size_t numberOfHistograms = input.front().values().size();
+    const size_t numberOfHistograms = FeatureMatrix::numberOfMetrics();
     
-    std::vector< std::vector<double> > allValues( numberOfHistograms, std::vector<double>() );
-    
-    // Loop over the trip metrics and fill in the valarrays, minimum and maximum values
-    for ( size_t iMetric = 0; iMetric < input.size(); ++iMetric ) {
-        
-        const std::vector<double>& metricValues = input[iMetric].values();
-
-        for ( size_t iValue = 0; iValue < numberOfHistograms; ++iValue ) {
-            if ( std::isnan(metricValues[iValue])) continue;
-            double currentValue = metricValues[iValue];
-            allValues[iValue].push_back( currentValue );
-        }
-    }
-    
-    
-    // For each vector create the corresponding histogram
+    // For each metric create the corresponding histogram with the edges of the reference
     for ( size_t iValue = 0; iValue < numberOfHistograms; ++iValue ) {
 
-        std::vector<double>& valuesForMetric = allValues[iValue];
+        std::vector<double> valuesForMetric = definedValues( input, iValue, beginRow, endRow );
 
         double lowEdge = reference.m_histograms[iValue]->lowEdge();
         double highEdge = reference.m_histograms[iValue]->highEdge();
-        double binSize = ( (highEdge/1.01) - lowEdge ) / binsForHistograms;
         
         // Create the histogram
         m_histograms.push_back( new Histogram( valuesForMetric,
@@ -140,43 +126,34 @@ m_pca( 0 )
     }
 
     
-    
-    
-    // Get rid of empty values and normalise
-    allValues.clear();
-    allValues.reserve( input.size() );
-    for ( std::vector< TripMetrics >::const_iterator iSample = input.begin(); iSample != input.end(); ++iSample )
-        allValues.push_back( iSample->values() );
-
-    const long nBinaryVariables = TripMetrics::numberOfBinaryMetrics();
-    const long numberOfFeatures = numberOfHistograms - nBinaryVariables;
-    
-    std::vector< std::vector< double > > cleanData;
-    cleanData.reserve( allValues.size() );
-    
-    m_meanValues = reference.m_meanValues;
-    m_stdValues = reference.m_stdValues;
-    for ( size_t iSample = 0; iSample < allValues.size(); ++iSample ) {
+    // Get rid of the rows with empty values
+    std::vector< size_t > cleanRows;
+    cleanRows.reserve( endRow - beginRow );
+    for ( size_t row = beginRow; row < endRow; ++row ) {
         bool nanFound = false;
-        const std::vector<double>& metricValues = allValues[iSample];
-        for ( size_t iMetric = 0; iMetric < metricValues.size(); ++iMetric ) {
-            if ( std::isnan( metricValues[iMetric]) ) {
+        for ( size_t iMetric = 0; iMetric < numberOfHistograms; ++iMetric ) {
+            if ( std::isnan( input.value( row, iMetric ) ) ) {
                 nanFound = true;
                 break;
             }
         }
-        if ( nanFound ) continue;
-        std::vector<double> sampleValues = std::vector<double>( metricValues.begin() + nBinaryVariables, metricValues.end() );
-        // Normalise using previously calculated mean and std values.
-        for ( size_t iFeature = 0; iFeature < numberOfFeatures; ++iFeature ) sampleValues[iFeature] = (sampleValues[iFeature] - m_meanValues[iFeature] ) / m_stdValues[iFeature];
-        cleanData.push_back( sampleValues );
+        if ( ! nanFound ) cleanRows.push_back( row );
     }
     
-    // Transform the clean data using the reference pca obejcts and create the corresponding histograms
+    m_meanValues = reference.m_meanValues;
+    m_stdValues = reference.m_stdValues;
     m_pca = new PCA( *(reference.m_pca ) );
-
-    for ( std::vector< std::vector< double > >::iterator iData = cleanData.begin(); iData != cleanData.end(); ++iData )
-        *iData = m_pca->transform( *iData );
+    if ( cleanRows.empty() ) return;
+    
+    // Normalise using the mean and std values of the reference, transform using the reference pca object
+    // and create the corresponding histograms
+    std::vector< std::vector< double > > cleanData;
+    cleanData.reserve( cleanRows.size() );
+    std::vector< double > sampleValues;
+    for ( std::vector< size_t >::const_iterator iRow = cleanRows.begin(); iRow != cleanRows.end(); ++iRow ) {
+        normalisedRow( input, *iRow, m_meanValues, m_stdValues, sampleValues );
+        cleanData.push_back( m_pca->transform( sampleValues ) );
+    }
     
     const size_t nPrincipalComponents = cleanData.front().size();
     const size_t numberOfSamples = cleanData.size();
@@ -203,23 +180,25 @@ TripMetricsReference::~TripMetricsReference()
          iHistogram != m_histograms.end(); ++iHistogram )
         delete *iHistogram;
     
+    for ( std::vector< Histogram* >::iterator iHistogram = m_histogramsPCA.begin();
+         iHistogram != m_histogramsPCA.end(); ++iHistogram )
+        delete *iHistogram;
+    
     if ( m_pca) delete m_pca;
 }
 
 
 std::vector<double>
-TripMetricsReference::scoreMetrics( const TripMetrics& input ) const
+TripMetricsReference::scoreMetrics( const FeatureMatrix& input, size_t row ) const
 {
     size_t nSize = m_histograms.size();
     std::vector<double> result;
     result.reserve( nSize );
     
-    const std::vector<double>& values = input.values();
-    
     // Check it there is a nan value
     bool nanFound = false;
     for ( size_t i = 0; i < nSize; ++i ) {
-        if ( std::isnan( values[i] ) ) {
+        if ( std::isnan( input.value( row, i ) ) ) {
             nanFound = true;
             break;
         }
@@ -228,18 +207,15 @@ TripMetricsReference::scoreMetrics( const TripMetrics& input ) const
         //    if ( nanFound ) { // use the metrics histograms for scoring
     if ( true ) { // use the metrics histograms for scoring
         for ( size_t i = 0; i < nSize; ++i ) {
-            const double prob = m_histograms[i]->probability( values[i] );
+            const double prob = m_histograms[i]->probability( input.value( row, i ) );
             result.push_back( prob );
         }
     }
     else { // use the PCA histograms for scoring
-        std::vector<double> dataForPCA = std::vector<double>( values.begin() + TripMetrics::numberOfBinaryMetrics(),
-                                                             values.end() );
-        nSize = dataForPCA.size();
+        std::vector<double> dataForPCA;
         
         // Normalise
-        for ( size_t iFeature = 0; iFeature < nSize; ++iFeature )
-            dataForPCA[iFeature] = (dataForPCA[iFeature] - m_meanValues[iFeature] ) / m_stdValues[iFeature];
+        normalisedRow( input, row, m_meanValues, m_stdValues, dataForPCA );
         // Transform
         dataForPCA = m_pca->transform( dataForPCA );
         const size_t nPrincipalComponents = dataForPCA.size();
@@ -256,44 +232,42 @@ TripMetricsReference::scoreMetrics( const TripMetrics& input ) const
 
 
 void
-TripMetricsReference::performPCA( const std::vector< std::vector<double> >& input )
+TripMetricsReference::performPCA( const FeatureMatrix& input )
 {
-    const long nBinaryVariables = TripMetrics::numberOfBinaryMetrics();
+    const size_t numberOfFeatures = FeatureMatrix::numberOfFeatures();
     
     // Get rid of empty values.
-    std::vector< std::vector< double > > cleanData;
-    cleanData.reserve( input.size() );
-    for ( size_t iSample = 0; iSample < input.size(); ++iSample ) {
+    std::vector< size_t > cleanRows;
+    cleanRows.reserve( input.numberOfRows() );
+    for ( size_t row = 0; row < input.numberOfRows(); ++row ) {
         bool nanFound = false;
-        const std::vector<double>& metricValues = input[iSample];
-        for ( size_t iMetric = nBinaryVariables; iMetric < metricValues.size(); ++iMetric ) {
-            if ( std::isnan( metricValues[iMetric]) ) {
+        for ( size_t iFeature = 0; iFeature < numberOfFeatures; ++iFeature ) {
+            if ( std::isnan( input.feature( iFeature )[row] ) ) {
                 nanFound = true;
                 break;
             }
-            
         }
-        if ( nanFound ) continue;
-        cleanData.push_back( std::vector<double>( metricValues.begin() + nBinaryVariables, metricValues.end() ) );
+        if ( ! nanFound ) cleanRows.push_back( row );
     }
+    const FeatureMatrix cleanData = input.selectRows( cleanRows );
     
     // Get rid of the extreme values
     const double percentageToKeep = 99.8;
-    std::vector<std::vector<double> > cleanDataNoExtremes = tripExtremesFromColumns( cleanData, percentageToKeep );
+    FeatureMatrix cleanDataNoExtremes = cleanData.selectRows( rowsWithoutExtremes( cleanData, percentageToKeep ) );
     
     
     // Then normalize the values. Store the mean and std to be used when scoring
-    const size_t numberOfFeatures = cleanDataNoExtremes.front().size();
-    const size_t numberOfSamples = cleanDataNoExtremes.size();
+    const size_t numberOfSamples = cleanDataNoExtremes.numberOfRows();
     m_meanValues = std::vector< double >( numberOfFeatures, 0.0 );
     m_stdValues = std::vector< double >( numberOfFeatures, 0.0 );
     
     for ( size_t iFeature = 0; iFeature < numberOfFeatures; ++iFeature ) {
         // calculate mean and standard deviation
+        std::vector< double >& column = cleanDataNoExtremes.feature( iFeature );
         double sx = 0;
         double sxx = 0;
-        for ( size_t iSample = 0; iSample < cleanDataNoExtremes.size(); ++iSample ) {
-            const double x = cleanDataNoExtremes[iSample][iFeature];
+        for ( size_t iSample = 0; iSample < numberOfSamples; ++iSample ) {
+            const double x = column[iSample];
             sx += x;
             sxx += x*x;
         }
@@ -305,10 +279,10 @@ TripMetricsReference::performPCA( const std::vector< std::vector<double> >& inpu
         m_stdValues[iFeature] = stdx;
 
         // normalise values
-        for ( size_t iSample = 0; iSample < cleanDataNoExtremes.size(); ++iSample ) {
-            const double x = cleanData[iSample][iFeature];
+        for ( size_t iSample = 0; iSample < numberOfSamples; ++iSample ) {
+            const double x = column[iSample];
             const double xnew = (x - mx) / stdx;
-            cleanDataNoExtremes[iSample][iFeature] = xnew;
+            column[iSample] = xnew;
         }
 
     }
@@ -321,50 +295,46 @@ TripMetricsReference::performPCA( const std::vector< std::vector<double> >& inpu
     
     
     // Transform the clean data to identify the histogram edges
-    for ( std::vector< std::vector< double > >::iterator iData = cleanDataNoExtremes.begin(); iData != cleanDataNoExtremes.end(); ++iData )
-        *iData = m_pca->transform( *iData );
-    const size_t nPrincipalComponents = cleanDataNoExtremes.front().size();
-    std::vector<double> minValues = cleanDataNoExtremes.front();
-    std::vector<double> maxValues = minValues;
-    for ( size_t iComponent = 0; iComponent < nPrincipalComponents; ++iComponent ) {
-        for (size_t i = 0; i < cleanDataNoExtremes.size(); ++i ) {
-            const double value = cleanDataNoExtremes[i][iComponent];
-            if ( value < minValues[iComponent] ) minValues[iComponent] = value;
-            if ( value > maxValues[iComponent] ) maxValues[iComponent] = value;
+    std::vector< double > sampleValues( numberOfFeatures, 0.0 );
+    std::vector< double > minValues;
+    std::vector< double > maxValues;
+    for ( size_t iSample = 0; iSample < numberOfSamples; ++iSample ) {
+        for ( size_t iFeature = 0; iFeature < numberOfFeatures; ++iFeature )
+            sampleValues[iFeature] = cleanDataNoExtremes.feature( iFeature )[iSample];
+        const std::vector< double > components = m_pca->transform( sampleValues );
+        if ( iSample == 0 ) {
+            minValues = components;
+            maxValues = components;
+        }
+        for ( size_t iComponent = 0; iComponent < components.size(); ++iComponent ) {
+            if ( components[iComponent] < minValues[iComponent] ) minValues[iComponent] = components[iComponent];
+            if ( components[iComponent] > maxValues[iComponent] ) maxValues[iComponent] = components[iComponent];
         }
     }
-    
-    // Normalise the full reference data
-    
-    
-    // Normalise and tranform the full reference data
-    for ( std::vector< std::vector< double > >::iterator iData = cleanData.begin(); iData != cleanData.end(); ++iData ) {
-        std::vector<double>& sampleData = *iData;
-        // Normalise
-        for ( size_t iFeature = 0; iFeature < numberOfFeatures; ++iFeature )
-            sampleData[iFeature] = (sampleData[iFeature] - m_meanValues[iFeature] ) / m_stdValues[iFeature];
-        // Transform
-        sampleData = m_pca->transform( sampleData );
+    const size_t nPrincipalComponents = minValues.size();
+    
+    // Normalise and tranform the full reference data, one column per principal component
+    std::vector< std::vector< double > > histogramData( nPrincipalComponents, std::vector< double >( cleanData.numberOfRows(), 0.0 ) );
+    for ( size_t iSample = 0; iSample < cleanData.numberOfRows(); ++iSample ) {
+        normalisedRow( cleanData, iSample, m_meanValues, m_stdValues, sampleValues );
+        const std::vector< double > components = m_pca->transform( sampleValues );
+        for ( size_t iComponent = 0; iComponent < nPrincipalComponents; ++iComponent )
+            histogramData[iComponent][iSample] = components[iComponent];
     }
     
     // Create the histograms with the principal component values
     m_histogramsPCA.reserve( nPrincipalComponents );
     
     for ( size_t iComponent = 0; iComponent < nPrincipalComponents; ++iComponent ) {
-        std::vector< double > histogramData( numberOfSamples, 0.0 );
         double minValue = minValues[iComponent];
         double maxValue = maxValues[iComponent];
-        for ( size_t iSample = 0; iSample < cleanData.size(); ++iSample ) {
-            const double value = cleanData[iSample][iComponent];
-            histogramData[iSample] = value;
-        }
         
         // Determine the edges, the bins and create the corresponding histogram.
         double binSize = ( maxValue - minValue ) / m_binsForHistograms;
         maxValue += 0.01 * binSize;
         
             // Create the histogram
-        m_histogramsPCA.push_back( new Histogram( histogramData,
+        m_histogramsPCA.push_back( new Histogram( histogramData[iComponent],
                                                  m_binsForHistograms,
                                                  minValue,
                                                  maxValue ) );
@@ -0,0 +1,230 @@
+#include "TripSegmentation.h"
+#include "Utilities.h"
+#include <cmath>
+
+static const double pi = std::atan( 1.0 ) * 4;
+
+
+// Returns the view of the points [begin, end) of a trip
+static inline TripCoordinates
+subRange( const TripCoordinates& tripData, size_t begin, size_t end )
+{
+    return TripCoordinates( tripData.x() + begin, tripData.y() + begin, end - begin );
+}
+
+
+TripSegmentation::TripSegmentation():
+  m_segments(),
+  m_extraTravelDuration( 0 ),
+  m_extraTravelLength( 0 ),
+  m_zeroSpeedSegments(),
+  m_gapSegments(),
+  m_angleSegments()
+{}
+
+
+TripSegmentation::~TripSegmentation()
+{}
+
+
+const std::vector< TripCoordinates >&
+TripSegmentation::segment( const TripCoordinates& trip )
+{
+    m_segments.clear();
+    m_extraTravelDuration = 0;
+    m_extraTravelLength = 0;
+    m_zeroSpeedSegments.clear();
+    m_gapSegments.clear();
+    m_angleSegments.clear();
+
+        // First pass: identify zero velocity points.
+        // Remove first and last zero speed points from the trip.
+    this->removeZeroSpeedSegments( trip, m_zeroSpeedSegments );
+
+        // Second pass: correcting for missing segment paths
+        // Look for single long jumps and skip the jitter spikes
+    for ( std::vector< TripCoordinates >::const_iterator iSegment = m_zeroSpeedSegments.begin();
+         iSegment != m_zeroSpeedSegments.end(); ++iSegment )
+        this->identifyGapsCorrectJitter( *iSegment, m_gapSegments );
+
+        // Third pass: Remove angular jitter.
+    for ( std::vector< TripCoordinates >::const_iterator iSegment = m_gapSegments.begin();
+         iSegment != m_gapSegments.end(); ++iSegment )
+        this->removeAccuteAngleSegments( *iSegment, m_angleSegments );
+
+        // Fourth pass: Treat the gap and the jitters again
+    for ( std::vector< TripCoordinates >::const_iterator iSegment = m_angleSegments.begin();
+         iSegment != m_angleSegments.end(); ++iSegment )
+        this->identifyGapsCorrectJitter( *iSegment, m_segments );
+
+    return m_segments;
+}
+
+
+void
+TripSegmentation::identifyGapsCorrectJitter( const TripCoordinates& tripData,
+                                             std::vector< TripCoordinates >& segments )
+{
+    const double maxAcceleration = 5; // The maximum acceleration allowed in a segment
+    const double speedToTrigger = 10; // combined with a jump of 35 metres
+
+    double v_previous = 0;
+    std::pair<float,float> p_previous = tripData[0];
+    size_t i = 1;
+    size_t segmentStartingIndex = 0;
+
+    while ( i < tripData.size() ) {
+        std::pair<float,float> p_current = tripData[i];
+        double v_current = magnitude( p_current - p_previous );
+
+            // Check for abrupt high speed and high acceleration in combination with no low speed.
+        if ( ( std::abs( v_current - v_previous ) > maxAcceleration ) &&  v_current > speedToTrigger ) {
+
+                // Signal the end of the previous segment.
+            size_t nDiff = i - segmentStartingIndex;
+            if ( nDiff > 1 ) {
+                segments.push_back( subRange( tripData, segmentStartingIndex, i ) );
+            }
+            else {
+                    // Correct duration and length of trip for the skipped mini-segment.
+                if ( i < tripData.size() - 1 ) {
+                    std::pair<float,float> p_next = tripData[i];
+                    double v_next = magnitude( p_next - p_current );
+                    if ( std::abs( v_current - v_next ) < maxAcceleration ) {
+                        m_extraTravelDuration += 1;
+                        m_extraTravelLength += magnitude( p_next - p_previous );
+                    }
+                }
+            }
+
+                // Check whether this is a jitter or a gap and adjust the starting index accordingly, as well as the correction to the travel length and time.
+            if ( i < tripData.size() - 1 ) {
+
+                std::pair<float,float> p_next = tripData[i+1];
+                double v_next = magnitude( p_next - p_current );
+                if ( std::abs( v_current - v_next ) > maxAcceleration ) { // This is a gap
+                    double averageSpeedInGap = 0.5 * ( v_next + v_previous );
+                    double distanceSpentInGap = magnitude( p_current - p_previous );
+                    m_extraTravelLength += distanceSpentInGap;
+                    m_extraTravelDuration += static_cast<int>( std::nearbyint( distanceSpentInGap / averageSpeedInGap ) );
+                    segmentStartingIndex = i;
+                    ++i;
+                    p_current = p_next;
+                    v_current = v_next;
+                }
+                else { // This is a jitter. Check whether we have a sequence of spikes and skip them.
+                    size_t j = i + 2;
+                    bool endOfSpikesFound = false;
+                    while ( j < tripData.size() - 1 ) {
+                        std::pair<float,float> p_nnext = tripData[j];
+                        double v_nnext = magnitude( p_next - p_nnext );
+                        std::pair<float,float> p_nnnext = tripData[j+1];
+                        double v_nnnext = magnitude( p_nnnext - p_nnext );
+
+                        if ( std::abs( v_nnnext - v_nnext ) < maxAcceleration ) { // End of spikes.
+                            double averageSpeedInGap = 0.5 * ( v_nnext + v_previous );
+                            double distanceSpentInGap = magnitude( p_next - p_previous );
+                            m_extraTravelLength += distanceSpentInGap;
+                            m_extraTravelDuration += static_cast<int>( std::nearbyint( distanceSpentInGap / averageSpeedInGap ) );
+                            i = j;
+                            segmentStartingIndex = i-1;
+                            p_current = p_next;
+                            v_current = averageSpeedInGap;
+                            endOfSpikesFound = true;
+                            break;
+                        }
+                        ++j;
+                        p_next = p_nnext;
+                    }
+                    if ( ! endOfSpikesFound ) {
+                        i = j;
+                        segmentStartingIndex = i;
+                    }
+                }
+            }
+        }
+
+        p_previous = p_current;
+        v_previous = v_current;
+        ++i;
+    }
+
+
+    if ( tripData.size() - segmentStartingIndex > 2 ) {
+        segments.push_back( subRange( tripData, segmentStartingIndex, tripData.size() ) );
+    }
+}
+
+
+
+void
+TripSegmentation::removeAccuteAngleSegments( const TripCoordinates& tripData,
+                                             std::vector< TripCoordinates >& segments )
+{
+    const double maxAngle = 100 * pi / 180.0; // 100 degrees turn in a second!
+
+    size_t segentStartingIndex = 0;
+
+    std::pair<float, float> v_previous = tripData[1]-tripData[0];
+    size_t i = 2;
+    while ( i < tripData.size() ) {
+        std::pair<float, float> v_current = tripData[i] - tripData[i-1];
+        double angle = angleAmongVectors( v_current, v_previous );
+
+        if ( std::abs( angle ) > maxAngle ) {
+            if ( i - segentStartingIndex > 2 ) {
+                segments.push_back( subRange( tripData, segentStartingIndex, i - 1 ) );
+            }
+
+            m_extraTravelDuration += 2;
+            m_extraTravelLength += magnitude(tripData[i-2] - tripData[i]);
+
+            segentStartingIndex = i;
+            i += 2;
+            if ( i - 1 < tripData.size() )
+                v_previous = tripData[i-1] - tripData[i-2];
+            continue;
+        }
+        v_previous = v_current;
+        ++i;
+    }
+
+    if ( tripData.size() - segentStartingIndex > 2 ) {
+        segments.push_back( subRange( tripData, segentStartingIndex, tripData.size() ) );
+    }
+}
+
+
+
+void
+TripSegmentation::removeZeroSpeedSegments( const TripCoordinates& tripData,
+                                           std::vector< TripCoordinates >& segments )
+{
+    const double zeroSpeedTolerance = 1.5;
+
+    size_t segentStartingIndex = 0;
+    size_t zeroSpeedCounter = 0;
+    std::pair<float, float> p_previous = tripData[0];
+    for (size_t i = 1; i < tripData.size(); ++i ) {
+        std::pair<float, float> p_current = tripData[i];
+        double v_current = magnitude( p_current - p_previous );
+
+        if ( v_current < zeroSpeedTolerance ) {
+            if ( zeroSpeedCounter == 0 ) { // Mark the end of a segment and beginning of a zero speed sequence
+                if ( i - segentStartingIndex > 1 ) {
+                    segments.push_back( subRange( tripData, segentStartingIndex, i ) );
+                }
+            }
+            zeroSpeedCounter += 1;
+            segentStartingIndex = i;
+        }
+        else {
+            zeroSpeedCounter = 0;
+        }
+        p_previous = p_current;
+    }
+
+    if ( tripData.size() - segentStartingIndex > 2 ) {
+        segments.push_back( subRange( tripData, segentStartingIndex, tripData.size() ) );
+    }
+}
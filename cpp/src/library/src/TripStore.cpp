@@ -0,0 +1,110 @@
+#include "TripStore.h"
+#include "DriverTripDataMap.h"
+
+TripStore::TripStore():
+  m_x(),
+  m_y(),
+  m_mappedData(),
+  m_tripIds(),
+  m_trips()
+{}
+
+
+TripStore::TripStore( const std::vector< std::pair< int, TripDataView > >& trips ):
+  m_x(),
+  m_y(),
+  m_mappedData(),
+  m_tripIds(),
+  m_trips()
+{
+    this->store( trips );
+}
+
+
+TripStore::TripStore( const std::vector< std::pair< int, std::vector< std::pair<float,float> > > >& trips ):
+  m_x(),
+  m_y(),
+  m_mappedData(),
+  m_tripIds(),
+  m_trips()
+{
+    std::vector< std::pair< int, TripDataView > > views;
+    views.reserve( trips.size() );
+    for ( std::vector< std::pair< int, std::vector< std::pair<float,float> > > >::const_iterator iTrip = trips.begin();
+         iTrip != trips.end(); ++iTrip )
+        views.push_back( std::make_pair( iTrip->first, TripDataView( iTrip->second.data(), iTrip->second.size() ) ) );
+    this->store( views );
+}
+
+
+TripStore::TripStore( int tripId, const TripDataView& trip ):
+  m_x(),
+  m_y(),
+  m_mappedData(),
+  m_tripIds(),
+  m_trips()
+{
+    this->store( std::vector< std::pair< int, TripDataView > >( 1, std::make_pair( tripId, trip ) ) );
+}
+
+
+TripStore::TripStore( const std::shared_ptr< const DriverTripDataMap >& mappedData ):
+  m_x(),
+  m_y(),
+  m_mappedData( mappedData ),
+  m_tripIds(),
+  m_trips()
+{
+    m_tripIds.reserve( mappedData->numberOfTrips() );
+    m_trips.reserve( mappedData->numberOfTrips() );
+    for ( size_t i = 0; i < mappedData->numberOfTrips(); ++i ) {
+        m_tripIds.push_back( mappedData->tripId( i ) );
+        m_trips.push_back( mappedData->trip( i ) );
+    }
+}
+
+
+TripStore::~TripStore()
+{}
+
+
+void
+TripStore::store( const std::vector< std::pair< int, TripDataView > >& trips )
+{
+    // Lay out the trips, each starting on an aligned block
+    std::vector< size_t > tripOffsets;
+    tripOffsets.reserve( trips.size() );
+    size_t totalSize = 0;
+    for ( std::vector< std::pair< int, TripDataView > >::const_iterator iTrip = trips.begin();
+         iTrip != trips.end(); ++iTrip ) {
+        tripOffsets.push_back( totalSize );
+        totalSize += AlignedArray<float>::paddedSize( iTrip->second.size() );
+    }
+
+    // Split the coordinates into the x and y arrays. The padding stays zero
+    AlignedArray<float>( totalSize ).swap( m_x );
+    AlignedArray<float>( totalSize ).swap( m_y );
+    m_tripIds.reserve( trips.size() );
+    m_trips.reserve( trips.size() );
+    for ( size_t i = 0; i < trips.size(); ++i ) {
+        const TripDataView& trip = trips[i].second;
+        float* x = m_x.data() + tripOffsets[i];
+        float* y = m_y.data() + tripOffsets[i];
+        for ( size_t j = 0; j < trip.size(); ++j ) {
+            x[j] = trip[j].first;
+            y[j] = trip[j].second;
+        }
+        m_tripIds.push_back( trips[i].first );
+        m_trips.push_back( TripCoordinates( x, y, trip.size() ) );
+    }
+}
+
+
+size_t
+TripStore::memoryUsage() const
+{
+    size_t coordinatesSize = 0;
+    for ( std::vector< TripCoordinates >::const_iterator iTrip = m_trips.begin(); iTrip != m_trips.end(); ++iTrip )
+        coordinatesSize += 2 * AlignedArray<float>::paddedSize( iTrip->size() ) * sizeof(float);
+    return coordinatesSize + m_tripIds.capacity() * sizeof(int) + m_trips.capacity() * sizeof(TripCoordinates);
+}
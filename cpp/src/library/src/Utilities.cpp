@@ -1,7 +1,11 @@
 #include "Utilities.h"
+#include "FeatureMatrix.h"
+#include "DFTPlan.h"
+#include "QuantileSelection.h"
 #include <cmath>
 #include <algorithm>
-#include <complex>
+
+static const double pi = std::atan( 1.0 ) * 4;
 
 
 double
@@ -51,30 +55,43 @@ operator/( const std::pair<float,float>& v, double f )
 }
 
 
+double
+angleAmongVectors( const std::pair<float,float>& v1,
+                   const std::pair<float,float>& v2 )
+{
+    // The squares of the float components are exact in double precision, as std::pow( x, 2 ) was
+    const double x1 = v1.first, y1 = v1.second;
+    double mv1 = std::sqrt( x1 * x1 + y1 * y1 );
+    if (mv1 == 0 ) return 0;
+    const double x2 = v2.first, y2 = v2.second;
+    double mv2 = std::sqrt( x2 * x2 + y2 * y2 );
+    if (mv2 == 0 ) return 0;
+    double mvv = mv1 * mv2;
+    double sint = ( v1.first * v2.second - v1.second * v2.first ) / mvv;
+    double cost = ( v1.first * v2.first + v1.second * v2.second ) / mvv;
+    if ( sint > 1 ) sint = 1;
+    if ( sint < -1 ) sint = -1;
+    if (cost >= 0  )
+        return std::asin( sint );
+    else {
+        if (sint > 0 )
+            return pi - std::asin( sint );
+        else {
+            if ( cost > 1 ) cost = 1;
+            if ( cost < -1 ) cost = -1;
+            return - std::acos( cost );
+        }
+    }
+}
+
+
 std::vector< double >
 findQuantiles( std::vector<double>& values )
 {
-    if (values.size() == 0 )
+    QuantileValues quantiles;
+    if ( ! selectQuantiles( values.data(), values.data() + values.size(), quantiles ) )
 	return std::vector<double>();
-    
-    size_t Q05 = ( values.size() *  5 ) / 100;
-    size_t Q25 = ( values.size() * 25 ) / 100;
-    size_t Q50 = ( values.size() * 50 ) / 100;
-    size_t Q75 = ( values.size() * 75 ) / 100;
-    size_t Q95 = ( values.size() * 95 ) / 100;
-
-    std::nth_element(values.begin()          , values.begin() + Q05, values.end() );
-    std::nth_element(values.begin() + Q05 + 1, values.begin() + Q25, values.end() );
-    std::nth_element(values.begin() + Q25 + 1, values.begin() + Q50, values.end() );
-    std::nth_element(values.begin() + Q50 + 1, values.begin() + Q75, values.end() );
-    std::nth_element(values.begin() + Q75 + 1, values.begin() + Q95, values.end() );
-
-    return std::vector<double> ( {
-	        *(values.begin() + Q05),
-		*(values.begin() + Q25),
-		*(values.begin() + Q50),
-		*(values.begin() + Q75),
-		*(values.begin() + Q95) } );
+    return std::vector<double>( quantiles.begin(), quantiles.end() );
 }
 
 
@@ -114,59 +131,28 @@ r2_correlation( const std::vector<double>& x,
 
 
 
-static const double PI = asin(1) * 2;
-
-static void fft( std::valarray< std::complex<double> >& x )
-{
-    const size_t N = x.size();
-    if ( N <=1 ) return;
-    
-    std::valarray< std::complex<double> > even = x[std::slice(0, N/2, 2)];
-    std::valarray< std::complex<double> >  odd = x[std::slice(1, N/2, 2)];
-    
-    fft( even );
-    fft( odd );
-
-    for (size_t k = 0; k < N/2; ++k) {
-        std::complex<double> t = std::polar(1.0, -2 * PI * k / N) * odd[k];
-        x[k    ] = even[k] + t;
-        x[k+N/2] = even[k] - t;
-    }
-}
-
-
 std::valarray< double >
 vfft( const std::vector<double>& data )
 {
-    std::valarray< std::complex<double> > x( data.size() );
-    for ( size_t i = 0; i < data.size(); ++i ) x[i] = data[i];
-    fft( x );
-
-    size_t tbins = static_cast<size_t>( std::floor( (data.size() - 1 ) / 2 ) ) + (data.size()+1)%2;
-
-    std::valarray<double> transformed( tbins + 1 );
-    for (size_t i = 0; i <= tbins; ++i ) transformed[i] = std::abs( x[i] );
-
+    DFTPlan plan( data.size() );
+    std::valarray<double> transformed( plan.numberOfBins() );
+    plan.magnitudes( data.data(), &transformed[0] );
     return transformed;
 }
 
 
-std::vector<std::vector<double> >
-tripExtremesFromColumns( const std::vector<std::vector<double> >& input, double percentageToKeep )
+std::vector< size_t >
+rowsWithoutExtremes( const FeatureMatrix& input, double percentageToKeep )
 {
-    // Create a transpose matrix
-    const size_t nSamples = input.size();
-    const size_t nFeatures = input.front().size();
-    std::vector< std::vector<double> > inputT( nFeatures, std::vector<double>( nSamples, 0.0 ) );
-    for ( size_t i = 0; i < nSamples; ++i )
-        for (size_t j = 0; j < nFeatures; ++j )
-            inputT[j][i] = input[i][j];
+    const size_t nSamples = input.numberOfRows();
+    const size_t nFeatures = FeatureMatrix::numberOfFeatures();
     
     // Find min and max values (by trimming)
     std::vector<double> minValues( nFeatures, 0.0 );
     std::vector<double> maxValues( nFeatures, 0.0 );
+    std::vector<double> featureVector;
     for ( size_t i = 0; i < nFeatures; ++i ) {
-        std::vector<double>& featureVector = inputT[i];
+        featureVector.assign( input.feature( i ).begin(), input.feature( i ).end() );
         
         std::sort( featureVector.begin(), featureVector.end() );
         
@@ -177,14 +163,13 @@ tripExtremesFromColumns( const std::vector<std::vector<double> >& input, double
         maxValues[i] = featureVector[highEdgeIndex];
     }
     
-    // Filter the rows of the input so that they do not contain columns with extreme values
-    inputT.clear();
-    inputT.reserve( nSamples );
+    // Keep the rows which do not contain columns with extreme values
+    std::vector< size_t > rows;
+    rows.reserve( nSamples );
     for ( size_t i = 0; i < nSamples; ++i ) {
-        const std::vector<double>& sample = input[i];
         bool extremeFound = false;
         for ( size_t j = 0; j < nFeatures; ++j ) {
-            const double value = sample[j];
+            const double value = input.feature( j )[i];
             if ( value < minValues[j] || value > maxValues[j] ) {
                 extremeFound = true;
                 break;
@@ -192,9 +177,9 @@ tripExtremesFromColumns( const std::vector<std::vector<double> >& input, double
         }
         
         if (extremeFound) continue;
-        inputT.push_back( sample );
+        rows.push_back( i );
     }
     
-    return inputT;
+    return rows;
 }
 